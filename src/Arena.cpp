@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <new>
+
+#include "Arena.h"
+
+//----------------------------------------------------------------------------
+Arena::Arena(size_t blockSize)
+{
+    this->current = 0;
+    this->used = 0;
+    this->blockSize = blockSize;
+}
+
+//----------------------------------------------------------------------------
+Arena::~Arena()
+{
+    for(Block& b: this->blocks)
+        ::operator delete(b.data);
+}
+
+//----------------------------------------------------------------------------
+void* Arena::allocate(size_t bytes, size_t align)
+{
+    if(!this->blocks.empty())
+    {
+        Block& b = this->blocks[this->current];
+        size_t start = (this->used + align - 1) & ~(align - 1);
+
+        if(start + bytes <= b.size)
+        {
+            this->used = start + bytes;
+            return b.data + start;
+        }
+    }
+
+    // move on to the next block big enough, kept from before a reset or
+    // made now; a fresh block starts out aligned for anything
+    size_t next = this->blocks.empty() ? 0 : this->current + 1;
+
+    while(next < this->blocks.size() && this->blocks[next].size < bytes)
+        next++;
+
+    if(next == this->blocks.size())
+    {
+        Block b;
+        b.size = std::max(this->blockSize, bytes);
+        b.data = static_cast<char*>(::operator new(b.size));
+        this->blocks.push_back(b);
+    }
+
+    this->current = next;
+    this->used = bytes;
+
+    return this->blocks[next].data;
+}
+
+//----------------------------------------------------------------------------
+Arena::Mark Arena::mark() const
+{
+    Mark m;
+    m.block = this->current;
+    m.used = this->used;
+
+    return m;
+}
+
+//----------------------------------------------------------------------------
+void Arena::reset(const Mark& m)
+{
+    this->current = m.block;
+    this->used = m.used;
+}
+
+//----------------------------------------------------------------------------
+void Arena::reset()
+{
+    this->current = 0;
+    this->used = 0;
+}
+
+//----------------------------------------------------------------------------
+size_t Arena::capacity() const
+{
+    size_t total = 0;
+
+    for(const Block& b: this->blocks)
+        total += b.size;
+
+    return total;
+}
+
+//----------------------------------------------------------------------------
+Arena& Arena::local()
+{
+    thread_local Arena arena;
+    return arena;
+}
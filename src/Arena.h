@@ -0,0 +1,118 @@
+#ifndef ARENA_H_INCLUDED
+#define ARENA_H_INCLUDED
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * The Arena class hands out memory by bumping a pointer through large
+ * blocks. Nothing is freed on its own; instead a mark is taken before a
+ * stretch of work, such as one level of a search, and resetting to the
+ * mark gives back everything handed out since. Blocks are kept after a
+ * reset, so once an arena has grown to fit a solve, later solves do not
+ * call malloc at all.
+ *
+ * An arena is not thread safe. Each thread gets its own from local().
+ */
+class Arena
+{
+    private:
+        /**
+         * A block of memory handed out piece by piece
+         */
+        struct Block
+        {
+            char* data;             ///< Start of the block
+            size_t size;            ///< Bytes in the block
+        };
+
+        std::vector<Block> blocks;  ///< Blocks, in the order they are used
+        size_t current;             ///< Block being handed out
+        size_t used;                ///< Bytes handed out of that block
+        size_t blockSize;           ///< Size of every new block
+
+        Arena(const Arena&);
+        Arena& operator=(const Arena&);
+
+    public:
+        /**
+         * A point to reset the arena back to
+         */
+        struct Mark
+        {
+            size_t block;           ///< Block in use at the mark
+            size_t used;            ///< Bytes used of it at the mark
+        };
+
+        /**
+         * Constructor
+         *
+         * @param blockSize bytes in every block, larger requests get a
+         *        block of their own size
+         */
+        Arena(size_t blockSize = 1 << 16);
+
+        /**
+         * Destructor, frees every block
+         */
+        ~Arena();
+
+        /**
+         * Hand out memory, valid until the arena is reset past it
+         *
+         * @param bytes number of bytes wanted
+         * @param align alignment wanted, a power of two no larger than
+         *        that of std::max_align_t
+         *
+         * @return the memory
+         */
+        void* allocate(size_t bytes, size_t align = alignof(std::max_align_t));
+
+        /**
+         * Hand out room for a number of objects, left uninitialized
+         * Only meant for types without constructors or destructors.
+         *
+         * @param n number of objects
+         *
+         * @return the first object
+         */
+        template <typename T>
+        T* allocate(size_t n)
+        {
+            return static_cast<T*>(this->allocate(n * sizeof(T), alignof(T)));
+        }
+
+        /**
+         * Get the point the arena is at
+         *
+         * @return mark to pass to reset()
+         */
+        Mark mark() const;
+
+        /**
+         * Give back everything handed out since a mark was taken
+         *
+         * @param m mark taken earlier, not before an earlier reset
+         */
+        void reset(const Mark& m);
+
+        /**
+         * Give back everything, keeping the blocks for reuse
+         */
+        void reset();
+
+        /**
+         * Get the bytes held in blocks, used or not
+         *
+         * @return number of bytes
+         */
+        size_t capacity() const;
+
+        /**
+         * Get the arena of the calling thread
+         *
+         * @return arena that lives as long as the thread
+         */
+        static Arena& local();
+};
+#endif
@@ -0,0 +1,149 @@
+#include <mutex>
+#include <new>
+
+#include "AsyncSolve.h"
+
+/**
+ * Number of frame size classes, MIN_FRAME to MAX_FRAME
+ */
+static const int FRAME_CLASSES = 7;
+
+static_assert(FramePool::MIN_FRAME << (FRAME_CLASSES - 1) ==
+              FramePool::MAX_FRAME, "size classes cover every frame");
+
+/**
+ * Freed frames of one size, linked through their first bytes
+ */
+struct FrameList
+{
+    std::mutex lock;            ///< Guards head
+    void* head;                 ///< Last frame freed, or nullptr
+};
+
+/**
+ * Frames of every size class, and the count of frames allocated
+ */
+static FrameList frameLists[FRAME_CLASSES];
+static std::atomic<long long> framesAllocated(0);
+
+/**
+ * Find the size class of a frame
+ *
+ * @return the class, or -1 for a frame larger than MAX_FRAME
+ */
+static int frameClass(size_t size)
+{
+    int c = 0;
+
+    for(size_t s = FramePool::MIN_FRAME; s < size; s *= 2)
+        c++;
+
+    return c < FRAME_CLASSES ? c : -1;
+}
+
+//----------------------------------------------------------------------------
+AsyncOptions::AsyncOptions()
+{
+    this->budget = 0;
+    this->search = false;
+}
+
+//----------------------------------------------------------------------------
+SolveOperation::SolveOperation(Board& board, const AsyncOptions& opts)
+    : cancelled(false)
+{
+    this->group = nullptr;
+    this->call = &SolveOperation::run;
+    this->target = &board;
+    this->done = nullptr;
+    this->arg = nullptr;
+    this->opts = opts;
+}
+
+//----------------------------------------------------------------------------
+void SolveOperation::run(ThreadPool::Task* t)
+{
+    SolveOperation* op = static_cast<SolveOperation*>(t);
+
+    thread_local SudokuSolver solver;
+
+    solver.board = *op->target;
+    solver.budget = op->opts.budget;
+    solver.search = op->opts.search;
+    solver.cancel = &op->cancelled;
+    solver.solveDriver();
+    solver.cancel = nullptr;
+
+    *op->target = solver.board;
+    op->stats = solver.stats;
+
+    // the caller may free the operation from here on
+    op->done(op->arg);
+}
+
+//----------------------------------------------------------------------------
+void SolveOperation::start(void (*done)(void* arg), void* arg)
+{
+    this->done = done;
+    this->arg = arg;
+
+    ThreadPool::shared().post(this);
+}
+
+//----------------------------------------------------------------------------
+void SolveOperation::cancel()
+{
+    this->cancelled.store(true, std::memory_order_relaxed);
+}
+
+//----------------------------------------------------------------------------
+void* FramePool::operator new(size_t size)
+{
+    int c = frameClass(size);
+
+    if(c < 0)
+    {
+        framesAllocated++;
+        return ::operator new(size);
+    }
+
+    FrameList& list = frameLists[c];
+
+    {
+        std::lock_guard<std::mutex> guard(list.lock);
+
+        if(list.head != nullptr)
+        {
+            void* frame = list.head;
+            list.head = *static_cast<void**>(frame);
+            return frame;
+        }
+    }
+
+    framesAllocated++;
+    return ::operator new(MIN_FRAME << c);
+}
+
+//----------------------------------------------------------------------------
+void FramePool::operator delete(void* frame, size_t size)
+{
+    int c = frameClass(size);
+
+    if(c < 0)
+    {
+        ::operator delete(frame);
+        return;
+    }
+
+    FrameList& list = frameLists[c];
+    std::lock_guard<std::mutex> guard(list.lock);
+
+    *static_cast<void**>(frame) = list.head;
+    list.head = frame;
+}
+
+//----------------------------------------------------------------------------
+long long FramePool::allocated()
+{
+    return framesAllocated.load();
+}
@@ -0,0 +1,235 @@
+#ifndef ASYNCSOLVE_H_INCLUDED
+#define ASYNCSOLVE_H_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "Board.h"
+#include "SudokuSolver.h"
+#include "ThreadPool.h"
+
+/**
+ * \file
+ * Solving a board on the shared pool without blocking the caller
+ *
+ * A SolveOperation solves a board in place on a pool worker and calls
+ * back when it is done. Built as C++20, solveAsync() wraps one in an
+ * awaitable, so a coroutine can co_await a solve: it is suspended while
+ * the board is solved and resumed on the worker that solved it, and a
+ * stop requested through its std::stop_token cancels the solve. Neither
+ * allocates; the operation lives in the awaiting coroutine's frame, and
+ * a promise type that derives from FramePool gets its frames from a pool
+ * instead of the heap.
+ */
+
+/**
+ * Settings for an asynchronous solve
+ */
+struct AsyncOptions
+{
+    int budget;                 ///< Most passes, 0 for no limit
+    bool search;                ///< Guess when cross checking gets stuck
+
+    /**
+     * Default Constructor, no budget and no guessing
+     */
+    AsyncOptions();
+};
+
+/**
+ * The SolveOperation class is one board solved on the shared pool. The
+ * board belongs to the caller and must last until the operation is done,
+ * as must the operation itself.
+ */
+class SolveOperation : private ThreadPool::Task
+{
+    private:
+        Board* target;                  ///< Board to solve in place
+        std::atomic<bool> cancelled;    ///< Set to give up
+        void (*done)(void* arg);        ///< Called once solved
+        void* arg;                      ///< Passed to done
+
+        /**
+         * Solve on a pool worker, then call done
+         */
+        static void run(ThreadPool::Task* t);
+
+    public:
+        AsyncOptions opts;              ///< How to solve
+        SolveStats stats;               ///< Counts of the solve, once done
+
+        /**
+         * Constructor
+         *
+         * @param board board to solve in place
+         * @param opts how to solve it
+         */
+        SolveOperation(Board& board,
+                       const AsyncOptions& opts = AsyncOptions());
+
+        /**
+         * Hand the solve to the shared pool
+         * done is called on the worker that solved the board, once board
+         * and stats are set; the operation is not touched after that.
+         *
+         * @param done function to call when the solve is done
+         * @param arg passed to done
+         */
+        void start(void (*done)(void* arg), void* arg);
+
+        /**
+         * Stop the solve before its next pass, leaving the BUDGET status
+         * May be called from any thread, before or after start().
+         */
+        void cancel();
+
+    private:
+        SolveOperation(const SolveOperation&);
+        SolveOperation& operator=(const SolveOperation&);
+};
+
+/**
+ * The FramePool class recycles the memory of coroutine frames. A promise
+ * type that derives from it has its frames taken from lists of freed
+ * frames, in size classes of powers of two up to MAX_FRAME bytes, so a
+ * coroutine started over and over reuses the frame of the last one.
+ * Larger frames come from the heap as usual. Frames may be freed on
+ * another thread than the one they were taken on.
+ */
+class FramePool
+{
+    public:
+        static const size_t MIN_FRAME = 64;     ///< Smallest size class
+        static const size_t MAX_FRAME = 4096;   ///< Largest size class
+
+        /**
+         * Take a frame
+         *
+         * @param size bytes needed
+         *
+         * @return the frame
+         */
+        static void* operator new(size_t size);
+
+        /**
+         * Give a frame back
+         *
+         * @param frame frame from operator new
+         * @param size bytes asked for when it was taken
+         */
+        static void operator delete(void* frame, size_t size);
+
+        /**
+         * Count the frames taken from the heap rather than a list
+         *
+         * @return frames allocated so far
+         */
+        static long long allocated();
+};
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+#include <coroutine>
+#include <optional>
+#include <stop_token>
+
+/**
+ * The SolveAwaitable class suspends a coroutine while a SolveOperation
+ * runs, and resumes it with the counts of the solve
+ */
+class SolveAwaitable
+{
+    private:
+        /**
+         * Turns a stop request into a cancel
+         */
+        struct Canceller
+        {
+            SolveOperation* op;     ///< Operation to cancel
+
+            /**
+             * Cancel the operation
+             */
+            void operator()() const noexcept
+            {
+                this->op->cancel();
+            }
+        };
+
+        SolveOperation op;          ///< The solve
+        std::stop_token stop;       ///< Stop requests of the caller
+        std::optional<std::stop_callback<Canceller>> onStop;    ///< Set
+                                    ///< while suspended
+
+        /**
+         * Resume the suspended coroutine
+         */
+        static void resume(void* frame)
+        {
+            std::coroutine_handle<>::from_address(frame).resume();
+        }
+
+    public:
+        /**
+         * Constructor
+         *
+         * @param board board to solve in place
+         * @param opts how to solve it
+         * @param stop cancels the solve when a stop is requested
+         */
+        SolveAwaitable(Board& board, const AsyncOptions& opts,
+                       std::stop_token stop)
+            : op(board, opts), stop(std::move(stop))
+        {
+        }
+
+        /**
+         * Always suspend, the solve has not started
+         */
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        /**
+         * Start the solve, to resume the caller when done
+         */
+        void await_suspend(std::coroutine_handle<> caller)
+        {
+            this->onStop.emplace(this->stop, Canceller{&this->op});
+
+            // the caller may be resumed before this returns
+            this->op.start(&SolveAwaitable::resume, caller.address());
+        }
+
+        /**
+         * Give the counts of the finished solve
+         */
+        SolveStats await_resume()
+        {
+            // waits for a stop callback running on another thread
+            this->onStop.reset();
+
+            return this->op.stats;
+        }
+};
+
+/**
+ * Solve a board in place on the shared pool from a coroutine
+ * The coroutine is resumed on the pool worker that solved the board.
+ *
+ * @param board board to solve, which must outlive the co_await
+ * @param opts how to solve it
+ * @param stop cancels the solve when a stop is requested, leaving the
+ *        BUDGET status
+ *
+ * @return awaitable giving the counts of the solve
+ */
+inline SolveAwaitable solveAsync(Board& board,
+                                 const AsyncOptions& opts = AsyncOptions(),
+                                 std::stop_token stop = std::stop_token())
+{
+    return SolveAwaitable(board, opts, std::move(stop));
+}
+#endif
+#endif
@@ -0,0 +1,459 @@
+#include <algorithm>
+#include <climits>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BatchRunner.h"
+#include "BoundedQueue.h"
+#include "LockstepSolver.h"
+#include "NumaTopology.h"
+#include "ThreadPool.h"
+
+const int BatchRunner::CHUNK_SIZE;
+
+//----------------------------------------------------------------------------
+BatchRunner::BatchRunner()
+{
+    this->seconds = 0;
+    this->count = 0;
+    this->solved = 0;
+    this->malformed = 0;
+    this->threads = 1;
+    this->lockstep = false;
+    this->numa = false;
+    this->search = false;
+    this->results = nullptr;
+    this->store = nullptr;
+    this->cache = nullptr;
+}
+
+//----------------------------------------------------------------------------
+bool BatchRunner::isSkipped(const char* rec, int len)
+{
+    // a blank line from a CRLF file still counts as blank
+    int i = 0;
+    while(i < len && (rec[i] == ' ' || rec[i] == '\t' || rec[i] == '\r'))
+        i++;
+
+    return i == len || rec[0] == '#';
+}
+
+//----------------------------------------------------------------------------
+void BatchRunner::solveRecord(const char* rec, int len, long long lineNum,
+                              OutputBuffer& out)
+{
+    if(BatchRunner::isSkipped(rec, len))
+        return;
+
+    if(!this->puzzle.readLine(rec, len))
+    {
+        std::cerr << "line " << lineNum << ": malformed record\n";
+        this->malformed++;
+        return;
+    }
+
+    this->solvePuzzle(lineNum, out);
+}
+
+//----------------------------------------------------------------------------
+void BatchRunner::solvePuzzle(unsigned long long id, OutputBuffer& out)
+{
+    this->count++;
+    this->solver.board = this->puzzle;
+    this->solver.search = this->search;
+
+    if(this->solveBoard(this->solver))
+        this->solved++;
+
+    out.writeRecord(id, this->puzzle, this->solver.board, this->solver.stats);
+}
+
+//----------------------------------------------------------------------------
+void BatchRunner::run(std::istream& ins, OutputBuffer& out)
+{
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+
+    long long lineNum = 0;
+
+    while(std::getline(ins, this->line))
+    {
+        lineNum++;
+        this->solveRecord(this->line.data(), this->line.size(), lineNum, out);
+    }
+
+    out.flush();
+
+    this->seconds = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start).count();
+}
+
+//----------------------------------------------------------------------------
+void BatchRunner::run(PuzzleReader& in, OutputBuffer& out)
+{
+    this->run(in, 0, ULLONG_MAX, out);
+}
+
+//----------------------------------------------------------------------------
+void BatchRunner::run(PuzzleReader& in, unsigned long long first,
+                      unsigned long long last, OutputBuffer& out)
+{
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+
+    unsigned long long lineNum = 0;
+    const char* rec;
+    int len;
+
+    // lines before the range are only counted
+    while(lineNum < first && in.next(rec, len))
+        lineNum++;
+
+    if(this->threads > 1 || this->lockstep || this->numa)
+    {
+        this->runPipeline([&](Chunk& c) -> bool
+        {
+            while(c.size < CHUNK_SIZE)
+            {
+                if(lineNum >= last || !in.next(rec, len))
+                    return false;
+
+                lineNum++;
+
+                if(BatchRunner::isSkipped(rec, len))
+                    continue;
+
+                if(!c.puzzles[c.size].readLine(rec, len))
+                {
+                    std::cerr << "line " << lineNum << ": malformed record\n";
+                    this->malformed++;
+                    continue;
+                }
+
+                c.ids[c.size] = lineNum;
+                c.size++;
+            }
+
+            return true;
+        }, out);
+    }
+    else
+    {
+        while(lineNum < last && in.next(rec, len))
+        {
+            lineNum++;
+            this->solveRecord(rec, len, lineNum, out);
+        }
+    }
+
+    out.flush();
+
+    this->seconds = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start).count();
+}
+
+//----------------------------------------------------------------------------
+void BatchRunner::run(const PackedReader& in, unsigned long long first,
+                      unsigned long long last, OutputBuffer& out)
+{
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+
+    if(last > in.size())
+        last = in.size();
+
+    unsigned long long n = first;
+    unsigned long long id;
+
+    if(this->threads > 1 || this->lockstep || this->numa)
+    {
+        this->runPipeline([&](Chunk& c) -> bool
+        {
+            for(; c.size < CHUNK_SIZE; n++)
+            {
+                if(n >= last)
+                    return false;
+
+                if(!in.read(n, c.puzzles[c.size], nullptr, &id))
+                {
+                    std::cerr << "record " << n << ": malformed record\n";
+                    this->malformed++;
+                    continue;
+                }
+
+                c.ids[c.size] = in.hasIds() ? id : n;
+                c.size++;
+            }
+
+            return true;
+        }, out);
+    }
+    else
+    {
+        for(; n < last; n++)
+        {
+            if(!in.read(n, this->puzzle, nullptr, &id))
+            {
+                std::cerr << "record " << n << ": malformed record\n";
+                this->malformed++;
+                continue;
+            }
+
+            this->solvePuzzle(in.hasIds() ? id : n, out);
+        }
+    }
+
+    out.flush();
+
+    this->seconds = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start).count();
+}
+
+//----------------------------------------------------------------------------
+void BatchRunner::runPipeline(const std::function<bool(Chunk&)>& fill,
+                              OutputBuffer& out)
+{
+    // one worker group per NUMA node, or the shared pool for all
+    NumaTopology topology;
+    std::vector<ThreadPool*> pools(1, &ThreadPool::shared());
+
+    this->nodeIds.assign(1, 0);
+
+    if(this->numa)
+    {
+        topology.load();
+        topology.keepAllowed();
+
+        this->nodeIds = topology.ids;
+        pools.clear();
+
+        for(int n = 0; n < topology.size(); n++)
+            pools.push_back(&ThreadPool::forNode(topology.ids[n],
+                                                 topology.cpus[n]));
+    }
+
+    int nodes = pools.size();
+    int perNode = std::max(1, this->threads / nodes);
+
+    this->nodeCount.assign(nodes, 0);
+
+    // every chunk is either free, being read, solved, or written, so a
+    // fixed number of them bounds the memory of the whole run
+    int numChunks = 4 * perNode * nodes;
+    std::vector<Chunk> chunks(numChunks);
+
+    BoundedQueue<Chunk*> freeChunks(numChunks);
+    BoundedQueue<Chunk*> toWrite(numChunks);
+
+    for(int n = 0; n < nodes; n++)
+    {
+        pools[n]->reserve(perNode);
+
+        // chunks are first touched on their own node, so their pages
+        // are placed there, and only that node's workers solve them
+        ThreadPool::Group allocating(*pools[n]);
+
+        for(int i = n; i < numChunks; i += nodes)
+        {
+            Chunk* c = &chunks[i];
+            c->node = n;
+
+            allocating.run([c]()
+            {
+                c->puzzles.resize(CHUNK_SIZE);
+                c->solutions.resize(CHUNK_SIZE);
+                c->ids.resize(CHUNK_SIZE);
+                c->stats.resize(CHUNK_SIZE);
+            });
+        }
+
+        // waiting here must not run any of them on this thread
+        allocating.wait(false);
+    }
+
+    // hand out chunks from every node in turn
+    for(Chunk& c: chunks)
+        freeChunks.push(&c);
+
+    // reading blocks on I/O, so it gets a thread of its own instead of
+    // holding up a worker of the pool
+    std::thread reader([&]()
+    {
+        std::vector<std::unique_ptr<ThreadPool::Group>> solving;
+        for(ThreadPool* pool: pools)
+            solving.push_back(std::unique_ptr<ThreadPool::Group>(
+                new ThreadPool::Group(*pool)));
+
+        unsigned long long seq = 0;
+        Chunk* c;
+
+        while(freeChunks.pop(c))
+        {
+            c->size = 0;
+            bool more = fill(*c);
+
+            if(c->size > 0)
+            {
+                c->seq = seq++;
+                solving[c->node]->run([this, c, &toWrite]()
+                {
+                    this->solveChunk(*c);
+                    toWrite.push(c);
+                });
+            }
+
+            if(!more)
+                break;
+        }
+
+        // tell the writer nothing else is coming, chunks are left to the
+        // workers of their node rather than solved on this thread
+        for(std::unique_ptr<ThreadPool::Group>& g: solving)
+            g->wait(false);
+
+        toWrite.close();
+    });
+
+    // chunks finish out of order, hold on to them until their turn
+    std::vector<Chunk*> pending(numChunks, nullptr);
+    unsigned long long next = 0;
+    Chunk* c;
+
+    while(toWrite.pop(c))
+    {
+        pending[c->seq % numChunks] = c;
+
+        while((c = pending[next % numChunks]) != nullptr)
+        {
+            pending[next % numChunks] = nullptr;
+
+            for(int i = 0; i < c->size; i++)
+                out.writeRecord(c->ids[i], c->puzzles[i], c->solutions[i],
+                                c->stats[i]);
+
+            this->count += c->size;
+            this->solved += c->solved;
+            this->nodeCount[c->node] += c->size;
+            next++;
+
+            freeChunks.push(c);
+        }
+    }
+
+    reader.join();
+}
+
+//----------------------------------------------------------------------------
+void BatchRunner::solveChunk(Chunk& c)
+{
+    thread_local SudokuSolver solver;
+    thread_local LockstepSolver group;
+    Result results[LockstepSolver::LANES];
+    bool lanes = this->lockstep && !this->results && !this->store &&
+                 !this->cache;
+
+    c.solved = 0;
+    solver.search = this->search;
+    group.search = this->search;
+
+    for(int i = 0; lanes && i < c.size; i += LockstepSolver::LANES)
+    {
+        int n = std::min(LockstepSolver::LANES, c.size - i);
+        group.solve(&c.puzzles[i], n, results);
+
+        for(int j = 0; j < n; j++)
+        {
+            if(results[j].stats.status == SOLVED)
+                c.solved++;
+
+            c.solutions[i + j] = results[j].solution;
+            c.stats[i + j] = results[j].stats;
+        }
+    }
+
+    for(int i = 0; !lanes && i < c.size; i++)
+    {
+        solver.board = c.puzzles[i];
+
+        if(this->solveBoard(solver))
+            c.solved++;
+
+        c.solutions[i] = solver.board;
+        c.stats[i] = solver.stats;
+    }
+}
+
+//----------------------------------------------------------------------------
+bool BatchRunner::solveBoard(SudokuSolver& solver)
+{
+    std::function<bool(SudokuSolver&)> solve = [this](SudokuSolver& s) -> bool
+    {
+        return this->cache ? this->cache->solve(s) : s.solveDriver();
+    };
+
+    std::function<bool(SudokuSolver&)> miss = [&](SudokuSolver& s) -> bool
+    {
+        return this->store ? this->store->solve(s, solve) : solve(s);
+    };
+
+    if(this->results)
+        return this->results->solve(solver, miss);
+
+    return miss(solver);
+}
+
+//----------------------------------------------------------------------------
+void BatchRunner::summary(std::ostream& outs) const
+{
+    double rate = 0;
+
+    if(this->seconds > 0)
+        rate = this->count / this->seconds;
+
+    outs << this->count << " puzzles, "
+         << this->solved << " solved, "
+         << this->count - this->solved << " unsolved, "
+         << this->malformed << " malformed in "
+         << this->seconds << " s ("
+         << static_cast<long long>(rate) << " puzzles/s)\n";
+
+    const ResultCache* caches[2] = {this->results,
+                                    this->cache ? &this->cache->entries()
+                                                : nullptr};
+    const char* names[2] = {"cache", "canonical cache"};
+
+    for(int i = 0; i < 2; i++)
+    {
+        if(caches[i] == nullptr)
+            continue;
+
+        outs << "  " << names[i] << ": " << caches[i]->hits() << " hits, "
+             << caches[i]->misses() << " misses, "
+             << caches[i]->evictions() << " evictions, "
+             << caches[i]->size() << " of " << caches[i]->capacity()
+             << " boards\n";
+    }
+
+    if(this->store)
+        outs << "  store: " << this->store->size() << " of "
+             << this->store->capacity() << " boards\n";
+
+    if(!this->numa)
+        return;
+
+    for(size_t n = 0; n < this->nodeCount.size(); n++)
+    {
+        rate = 0;
+
+        if(this->seconds > 0)
+            rate = this->nodeCount[n] / this->seconds;
+
+        outs << "  node " << this->nodeIds[n] << ": "
+             << this->nodeCount[n] << " puzzles ("
+             << static_cast<long long>(rate) << " puzzles/s)\n";
+    }
+}
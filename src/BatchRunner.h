@@ -0,0 +1,194 @@
+#ifndef BATCHRUNNER_H_INCLUDED
+#define BATCHRUNNER_H_INCLUDED
+
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "SudokuSolver.h"
+#include "CanonicalCache.h"
+#include "ResultCache.h"
+#include "SolutionStore.h"
+#include "PuzzleReader.h"
+#include "OutputBuffer.h"
+#include "PackedCorpus.h"
+
+/**
+ * The BatchRunner class solves a stream of puzzles, one per line, and
+ * streams the results back out while keeping count of how it went.
+ */
+class BatchRunner
+{
+    private:
+        SudokuSolver solver;        ///< Solver reused for every puzzle
+        Board puzzle;               ///< Puzzle as it was read
+        std::string line;           ///< Buffer reused for every record
+        double seconds;             ///< Time spent in the last run
+        std::vector<int> nodeIds;   ///< NUMA node of each worker group
+        std::vector<long long> nodeCount;   ///< Puzzles solved on each
+
+        /**
+         * A run of consecutive puzzles handed between pipeline stages
+         */
+        struct Chunk
+        {
+            unsigned long long seq;         ///< Position in the input
+            int node;                       ///< Worker group solving it
+            int size;                       ///< Number of puzzles held
+            long long solved;               ///< Number of puzzles solved
+            std::vector<Board> puzzles;     ///< Puzzles as they were read
+            std::vector<Board> solutions;   ///< Boards the solver left
+            std::vector<unsigned long long> ids;    ///< Id of each puzzle
+            std::vector<SolveStats> stats;  ///< Counts from each solve
+        };
+
+        static const int CHUNK_SIZE = 256;  ///< Most puzzles in a chunk
+
+        /**
+         * Solve every puzzle of a chunk, counting the ones solved
+         *
+         * @param c chunk to solve
+         */
+        void solveChunk(Chunk& c);
+
+        /**
+         * Solve the solver's board through whichever caches are set, the
+         * one by puzzle first, then the store, then the canonical one
+         *
+         * @param solver solver holding the board, left holding the result
+         *
+         * @return true if the board is solved
+         */
+        bool solveBoard(SudokuSolver& solver);
+
+        /**
+         * Solve puzzles on several threads and write them out in order
+         * A reader thread fills chunks and hands each one to the shared
+         * ThreadPool to solve, and the calling thread writes chunks out in
+         * input order. The number of chunks is fixed, which bounds memory.
+         *
+         * With numa set, every node runs on its ThreadPool::forNode() pool,
+         * kept from run to run, and gets its own share of the chunks,
+         * allocated by its workers, so puzzles are read and solved in
+         * memory local to the node.
+         *
+         * @param fill fills a chunk with puzzles, returns false at the end
+         * @param out buffer for the results
+         */
+        void runPipeline(const std::function<bool(Chunk&)>& fill,
+                         OutputBuffer& out);
+
+        /**
+         * Solve a single record and write out the result
+         *
+         * @param rec characters of the record
+         * @param len length of the record
+         * @param lineNum line the record came from, for error messages
+         * @param out buffer for the result
+         */
+        void solveRecord(const char* rec, int len, long long lineNum,
+                         OutputBuffer& out);
+
+        /**
+         * Solve the puzzle that was just read and write out the result
+         *
+         * @param id number identifying the puzzle in the output
+         * @param out buffer for the result
+         */
+        void solvePuzzle(unsigned long long id, OutputBuffer& out);
+
+    public:
+        long long count;            ///< Number of puzzles read
+        long long solved;           ///< Number of puzzles solved
+        long long malformed;        ///< Number of records that were skipped
+        int threads;                ///< Pool workers to solve on, 1 in place
+        bool lockstep;              ///< Solve chunks with a LockstepSolver,
+                                    ///< unless a cache is set
+        bool numa;                  ///< One pinned worker group per node
+        bool search;                ///< Guess on puzzles that get stuck
+        ResultCache* results;       ///< Cache of solves by puzzle, nullptr
+                                    ///< for none
+        SolutionStore* store;       ///< Solves kept on disk, nullptr for
+                                    ///< none
+        CanonicalCache* cache;      ///< Cache of solves by canonical form,
+                                    ///< nullptr for none
+
+        /**
+         * Default Constructor
+         */
+        BatchRunner();
+
+        /**
+         * Determine whether a record holds no puzzle at all: a line of
+         * nothing but spaces, tabs and carriage returns, or a comment
+         * starting with '#'
+         *
+         * @param rec start of the record
+         * @param len length of the record
+         *
+         * @return true if the record is skipped without a report
+         */
+        static bool isSkipped(const char* rec, int len);
+
+        /**
+         * Solve every puzzle in the input stream
+         * Each record is a line of 81 characters. Blank lines and lines
+         * starting with '#' are ignored, malformed records are reported
+         * on the error stream and skipped.
+         *
+         * Every puzzle that is read produces one result in the output
+         * buffer, holding the board as far as the solver could take it.
+         * Puzzles are identified by the line they were read from.
+         *
+         * @param ins input stream of puzzles
+         * @param out buffer for the results, flushed at the end
+         */
+        void run(std::istream& ins, OutputBuffer& out);
+
+        /**
+         * Solve every puzzle handed out by a reader
+         * Records are parsed in place, see run(std::istream&, OutputBuffer&)
+         * for how they are treated. With more than one thread the results
+         * are identical to a run on a single thread.
+         *
+         * @param in reader of puzzle records
+         * @param out buffer for the results, flushed at the end
+         */
+        void run(PuzzleReader& in, OutputBuffer& out);
+
+        /**
+         * Solve a range of lines handed out by a reader
+         * Lines are counted from 1, and the lines before the range are
+         * read only to count them. See run(PuzzleReader&, OutputBuffer&)
+         * for how records are treated.
+         *
+         * @param in reader of puzzle records
+         * @param first number of lines to skip
+         * @param last number of the last line to solve
+         * @param out buffer for the results, flushed at the end
+         */
+        void run(PuzzleReader& in, unsigned long long first,
+                 unsigned long long last, OutputBuffer& out);
+
+        /**
+         * Solve a range of records from a packed corpus
+         * Puzzles are identified by the id stored with them, or by their
+         * index if the corpus has no ids.
+         *
+         * @param in packed corpus to read
+         * @param first index of the first record to solve
+         * @param last index one past the last record to solve
+         * @param out buffer for the results, flushed at the end
+         */
+        void run(const PackedReader& in, unsigned long long first,
+                 unsigned long long last, OutputBuffer& out);
+
+        /**
+         * Print the counts and throughput of the last run
+         *
+         * @param outs output stream
+         */
+        void summary(std::ostream& outs) const;
+};
+#endif
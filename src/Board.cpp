@@ -1,8 +1,13 @@
+#include <algorithm>
 #include <iostream>
 #include <utility>
 #include <vector>
 
 #include "Board.h"
+#include "LineParser.h"
+
+const int Board::PRETTY_SIZE;
+const int Board::PACKED_SIZE;
 
 //----------------------------------------------------------------------------
 Board::Board()
@@ -141,12 +146,11 @@ int Board::getBlockFilled(int b) const
 {
     int count = 0;
 
-
-    std::vector<int> block = this->getBlock(b);
-
     for(int i = 0; i < 9; i++)
     {
-        if(block[i] != -1)
+        int cell = ((b / 3) * 3 + i / 3) * 9 + (b % 3) * 3 + i % 3;
+
+        if(this->board[cell] != -1)
             count++;
     }
 
@@ -233,10 +237,11 @@ bool Board::isColFull(int c) const
 }
 
 //----------------------------------------------------------------------------
-Board Board::operator=(const Board& src)
+Board& Board::operator=(const Board& src)
 {
-    this->board = src.getBoard();
-        
+    // assign in place so the storage is reused
+    this->board = src.board;
+
     return *this;
 }
 
@@ -249,46 +254,60 @@ bool Board::operator<(const Board& lhs) const
 //----------------------------------------------------------------------------
 bool Board::operator==(const Board& lhs) const
 {
-    return this->board == lhs.getBoard();
+    return this->board == lhs.board;
 }
 
 //----------------------------------------------------------------------------
 void Board::display(std::ostream& outs) const
 {
+    char out[PRETTY_SIZE];
+
+    outs.write(out, this->writePretty(out));
+}
+
+//----------------------------------------------------------------------------
+int Board::writePretty(char* out) const
+{
+    int n = 0;
+
     for(int i = 0; i < 9; i++)
     {
-        outs << " ";
+        out[n++] = ' ';
 
         for(int j = 0; j < 9; j++)
         {
             // print 3 nums and then a separator
             if(j == 3 || j == 6)
-                outs << "|| ";
+            {
+                out[n++] = '|';
+                out[n++] = '|';
+                out[n++] = ' ';
+            }
 
-                        
             // print space if the board is empty there
             if(this->board[(i * 9) + j] == -1)
-                outs << " ";
+                out[n++] = ' ';
             else
-                outs << this->board[(i * 9) + j];
+                out[n++] = static_cast<char>('0' + this->board[(i * 9) + j]);
 
             // print a separating space
             if(j != 8)
-                outs << " ";
-                        
+                out[n++] = ' ';
         }
-                
-            outs << "\n";
 
-            // dividing line between grids
-            if(i == 2 || i == 5)
-            {
-                std::string divide(24, '=');
-                outs << divide << "\n";
-            }
-                
+        out[n++] = '\n';
+
+        // dividing line between grids
+        if(i == 2 || i == 5)
+        {
+            for(int k = 0; k < 24; k++)
+                out[n++] = '=';
 
+            out[n++] = '\n';
+        }
     }
+
+    return n;
 }
 
 //----------------------------------------------------------------------------
@@ -318,20 +337,140 @@ void Board::read(std::istream& ins)
 }
 
 //----------------------------------------------------------------------------
-bool Board::searchFor(int n, int toSearch, char type) const
+bool Board::readLine(const char* line, int len)
 {
-    std::vector<int> target;
+    // ignore trailing whitespace and carriage returns
+    while(len > 0 && (line[len - 1] == ' ' || line[len - 1] == '\t' ||
+                      line[len - 1] == '\r' || line[len - 1] == '\n'))
+        len--;
+
+    if(len != 81)
+        return false;
+
+    // parse straight into the board unless it was given an odd size
+    if(this->board.size() == 81)
+        return parseCells(line, this->board.data());
+
+    int cells[81];
 
-    if(type == 'r')
-        target = this->getRow(n);
-    if(type == 'c')
-        target = this->getCol(n);
-    if(type == 'b')
-        target = this->getBlock(n);
+    if(!parseCells(line, cells))
+        return false;
+
+    this->board.assign(cells, cells + 81);
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+void Board::writeLine(char* out) const
+{
+    for(int i = 0; i < 81; i++)
+    {
+        if(this->board[i] == -1)
+            out[i] = '.';
+        else
+            out[i] = static_cast<char>('0' + this->board[i]);
+    }
+}
+
+//----------------------------------------------------------------------------
+bool Board::readPacked(const unsigned char* in)
+{
+    int cells[81];
+
+    for(int i = 0; i < 81; i++)
+    {
+        int val = (i % 2 == 0) ? (in[i / 2] & 0x0f) : (in[i / 2] >> 4);
 
-    for(int cell: target)
+        if(val > 9)
+            return false;
+
+        cells[i] = (val == 0) ? -1 : val;
+    }
+
+    this->board.assign(cells, cells + 81);
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+void Board::writePacked(unsigned char* out) const
+{
+    for(int i = 0; i < PACKED_SIZE; i++)
+        out[i] = 0;
+
+    for(int i = 0; i < 81; i++)
+    {
+        int val = (this->board[i] == -1) ? 0 : this->board[i];
+
+        out[i / 2] |= (i % 2 == 0) ? val : (val << 4);
+    }
+}
+
+//----------------------------------------------------------------------------
+void Board::saveCells(int* cells) const
+{
+    std::copy(this->board.begin(), this->board.end(), cells);
+}
+
+//----------------------------------------------------------------------------
+void Board::loadCells(const int* cells)
+{
+    std::copy(cells, cells + 81, this->board.begin());
+}
+
+//----------------------------------------------------------------------------
+bool Board::hasDuplicates() const
+{
+    for(int n = 0; n < 9; n++)
+    {
+        int rowSeen = 0;
+        int colSeen = 0;
+        int blockSeen = 0;
+
+        for(int i = 0; i < 9; i++)
+        {
+            int row = this->board[(n * 9) + i];
+            int col = this->board[(i * 9) + n];
+            int block = this->board[((n / 3) * 3 + i / 3) * 9 +
+                                    (n % 3) * 3 + i % 3];
+
+            if((row != -1 && (rowSeen & (1 << row))) ||
+               (col != -1 && (colSeen & (1 << col))) ||
+               (block != -1 && (blockSeen & (1 << block))))
+                return true;
+
+            if(row != -1)
+                rowSeen |= 1 << row;
+            if(col != -1)
+                colSeen |= 1 << col;
+            if(block != -1)
+                blockSeen |= 1 << block;
+        }
+    }
+
+    return false;
+}
+
+//----------------------------------------------------------------------------
+bool Board::searchFor(int n, int toSearch, char type) const
+{
+    // walk the cells in place, this is called for every check the
+    // solver makes
+    for(int i = 0; i < 9; i++)
     {
-        if(cell == toSearch)
+        int cell = -1;
+
+        if(type == 'r')
+            cell = (n * 9) + i;
+        else if(type == 'c')
+            cell = (i * 9) + n;
+        else if(type == 'b')
+            cell = ((n / 3) * 3 + i / 3) * 9 + (n % 3) * 3 + i % 3;
+        else
+            return false;
+
+        if(this->board[cell] == toSearch)
             return true;
     }
 
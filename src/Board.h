@@ -206,6 +206,13 @@ class Board
          */
         bool isColFull(int c) const;
 
+        /**
+         * Determine whether any row, column, or block holds a number twice
+         *
+         * @return true if a number is repeated
+         */
+        bool hasDuplicates() const;
+
         /**
          * Search a row/block/col for a certain number
          *
@@ -224,7 +231,7 @@ class Board
          *
          * @return newly assigned board
          */
-        Board operator=(const Board& src);
+        Board& operator=(const Board& src);
 
         /**
          * Overloaded comparision operator
@@ -252,6 +259,52 @@ class Board
          */
         void display(std::ostream& outs) const;
 
+        /**
+         * Write the board in the layout used by display()
+         *
+         * @param out buffer with room for at least PRETTY_SIZE characters
+         *
+         * @return number of characters written
+         */
+        int writePretty(char* out) const;
+
+        static const int PRETTY_SIZE = 275;     ///< Characters in display()
+
+        /**
+         * Read in a board packed four bits to a cell
+         * Cell i is in the low half of byte i / 2 when i is even and the
+         * high half otherwise. 0 is an empty space.
+         *
+         * @param in PACKED_SIZE bytes of packed cells
+         *
+         * @return true if every cell held 0 through 9, the board is left
+         *         untouched otherwise
+         */
+        bool readPacked(const unsigned char* in);
+
+        /**
+         * Write the board packed four bits to a cell
+         *
+         * @param out buffer with room for at least PACKED_SIZE bytes
+         */
+        void writePacked(unsigned char* out) const;
+
+        static const int PACKED_SIZE = 41;      ///< Bytes in a packed board
+
+        /**
+         * Copy every cell out, row by row, -1 for an empty space
+         *
+         * @param cells room for 81 values
+         */
+        void saveCells(int* cells) const;
+
+        /**
+         * Put back cells copied out by saveCells()
+         *
+         * @param cells 81 values, row by row
+         */
+        void loadCells(const int* cells);
+
         /**
          * Read in a board from an input stream
          *
@@ -259,6 +312,26 @@ class Board
          */
         void read(std::istream& ins);
 
+        /**
+         * Read in a board from a single line of 81 characters
+         * Digits 1-9 are placed, '.' or '0' mark empty spaces
+         *
+         * @param line characters of the line (need not be null terminated)
+         * @param len number of characters in the line
+         *
+         * @return true if the line held a valid board, the board is left
+         *         untouched otherwise
+         */
+        bool readLine(const char* line, int len);
+
+        /**
+         * Write the board as a single line of 81 characters
+         * Empty spaces are written as '.' and no terminator is added
+         *
+         * @param out buffer with room for at least 81 characters
+         */
+        void writeLine(char* out) const;
+
 };
 
 /** \relates Board
@@ -0,0 +1,109 @@
+#ifndef BOUNDEDQUEUE_H_INCLUDED
+#define BOUNDEDQUEUE_H_INCLUDED
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+/**
+ * The BoundedQueue class passes items between threads. Producers block
+ * while the queue is full and consumers block while it is empty, until
+ * the queue is closed.
+ */
+template <typename T>
+class BoundedQueue
+{
+    private:
+        std::mutex lock;                    ///< Guards everything below
+        std::condition_variable notEmpty;   ///< Signalled after a push
+        std::condition_variable notFull;    ///< Signalled after a pop
+        std::deque<T> items;                ///< Items waiting to be popped
+        size_t capacity;                    ///< Most items held at once
+        bool closed;                        ///< True once close() is called
+
+    public:
+        /**
+         * Constructor
+         *
+         * @param capacity most items held before push() blocks
+         */
+        BoundedQueue(size_t capacity)
+        {
+            this->capacity = capacity;
+            this->closed = false;
+        }
+
+        /**
+         * Add an item, waiting for room if the queue is full
+         *
+         * @param item item to add
+         *
+         * @return false if the queue was closed and the item dropped
+         */
+        bool push(const T& item)
+        {
+            std::unique_lock<std::mutex> guard(this->lock);
+
+            while(this->items.size() >= this->capacity && !this->closed)
+                this->notFull.wait(guard);
+
+            if(this->closed)
+                return false;
+
+            this->items.push_back(item);
+            this->notEmpty.notify_one();
+
+            return true;
+        }
+
+        /**
+         * Remove the oldest item, waiting for one if the queue is empty
+         *
+         * @param item set to the removed item
+         *
+         * @return false once the queue is closed and empty
+         */
+        bool pop(T& item)
+        {
+            std::unique_lock<std::mutex> guard(this->lock);
+
+            while(this->items.empty() && !this->closed)
+                this->notEmpty.wait(guard);
+
+            if(this->items.empty())
+                return false;
+
+            item = this->items.front();
+            this->items.pop_front();
+            this->notFull.notify_one();
+
+            return true;
+        }
+
+        /**
+         * Refuse further pushes and wake every waiting thread
+         * Items already queued can still be popped.
+         */
+        void close()
+        {
+            std::lock_guard<std::mutex> guard(this->lock);
+
+            this->closed = true;
+            this->notEmpty.notify_all();
+            this->notFull.notify_all();
+        }
+
+        /**
+         * Access the number of queued items
+         *
+         * @return number of items waiting to be popped
+         */
+        size_t size()
+        {
+            std::lock_guard<std::mutex> guard(this->lock);
+
+            return this->items.size();
+        }
+};
+#endif
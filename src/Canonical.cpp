@@ -0,0 +1,496 @@
+#include <algorithm>
+
+#include "Canonical.h"
+
+/**
+ * Orders of three things
+ */
+static const int PERM3[6][3] = {
+    {0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}
+};
+
+/**
+ * Most transforms compared on their numbers before settling for the best
+ * found, only reached by boards with hardly any numbers filled in
+ */
+static const long long MAX_DIGIT_TRIES = 1 << 16;
+
+/**
+ * Three spaces of a row, filled ones as set bits with the first space
+ * highest, reordered by each of PERM3
+ */
+struct Bits3
+{
+    unsigned char value[6][8];
+
+    Bits3()
+    {
+        for(int p = 0; p < 6; p++)
+        {
+            for(int bits = 0; bits < 8; bits++)
+            {
+                int v = 0;
+
+                for(int j = 0; j < 3; j++)
+                {
+                    if(bits & (4 >> PERM3[p][j]))
+                        v |= 4 >> j;
+                }
+
+                this->value[p][bits] = v;
+            }
+        }
+    }
+};
+
+static const Bits3 BITS3;
+
+/**
+ * A choice of stack order and column orders, with the rows placed in the
+ * best order for it
+ */
+struct ColumnChoice
+{
+    int transpose;              ///< 1 if the grid is transposed
+    int stacks[3];              ///< Stack in each position
+    int perms[3];               ///< PERM3 order of each stack's columns
+};
+
+/**
+ * Work shared by the steps of canonicalForm()
+ */
+struct Search
+{
+    int grid[2][81];            ///< Board and its transpose, 0 for empty
+    int pattern[2][9][3];       ///< Filled spaces of each row's stacks
+
+    int best[9];                ///< Smallest row pattern found
+    int bestKeys[3];            ///< The same, packed a band at a time
+    bool found;                 ///< True once best is set
+    std::vector<ColumnChoice> ties;     ///< Choices that reach best
+
+    int bestDigits[81];         ///< Smallest numbers found
+    bool digitsFound;           ///< True once bestDigits is set
+    long long digitTries;       ///< Transforms compared on their numbers
+    Symmetry sym;               ///< Transform giving bestDigits
+};
+
+/**
+ * Put three values in order
+ */
+static inline void sort3(int& a, int& b, int& c)
+{
+    if(a > b)
+        std::swap(a, b);
+    if(b > c)
+        std::swap(b, c);
+    if(a > b)
+        std::swap(a, b);
+}
+
+/**
+ * Place the rows of a full choice of columns in their best order, which
+ * is the rows sorted within each band and the bands sorted by their
+ * rows, and keep the choice if it is as good as the best so far
+ *
+ * @param s search in progress
+ * @param c choice of columns
+ * @param values pattern of each row under the choice
+ */
+static void placeRows(Search& s, const ColumnChoice& c, const int values[9])
+{
+    int keys[3];
+
+    // a band sorted is three 9 bit rows, packed first row highest
+    for(int b = 0; b < 3; b++)
+    {
+        int x = values[b * 3];
+        int y = values[b * 3 + 1];
+        int z = values[b * 3 + 2];
+
+        sort3(x, y, z);
+        keys[b] = (x << 18) | (y << 9) | z;
+    }
+
+    sort3(keys[0], keys[1], keys[2]);
+
+    int cmp = 0;
+    if(s.found)
+    {
+        for(int b = 0; b < 3 && cmp == 0; b++)
+            cmp = (keys[b] > s.bestKeys[b]) - (keys[b] < s.bestKeys[b]);
+    }
+
+    if(cmp > 0)
+        return;
+
+    if(!s.found || cmp < 0)
+    {
+        for(int b = 0; b < 3; b++)
+        {
+            s.bestKeys[b] = keys[b];
+            s.best[b * 3] = keys[b] >> 18;
+            s.best[b * 3 + 1] = (keys[b] >> 9) & 511;
+            s.best[b * 3 + 2] = keys[b] & 511;
+        }
+
+        s.found = true;
+        s.ties.clear();
+    }
+
+    s.ties.push_back(c);
+}
+
+/**
+ * Try every choice of columns that makes one row the smallest first row
+ * there is: its stacks from least to most filled, and the empty spaces
+ * first in each stack. Any other choice gives a larger first row.
+ *
+ * @param s search in progress
+ * @param transpose 1 if the grid is transposed
+ * @param row row to make the first row
+ */
+static void chooseColumns(Search& s, int transpose, int row)
+{
+    const int* stacks = s.pattern[transpose][row];
+
+    // column orders of each stack with its filled spaces last
+    int perms[3][6];
+    int numPerms[3];
+
+    for(int stack = 0; stack < 3; stack++)
+    {
+        int filled = (1 << __builtin_popcount(stacks[stack])) - 1;
+        numPerms[stack] = 0;
+
+        for(int p = 0; p < 6; p++)
+        {
+            if(BITS3.value[p][stacks[stack]] == filled)
+                perms[stack][numPerms[stack]++] = p;
+        }
+    }
+
+    ColumnChoice c;
+    c.transpose = transpose;
+
+    for(int order = 0; order < 6; order++)
+    {
+        bool sorted = true;
+
+        for(int k = 0; k < 3; k++)
+            c.stacks[k] = PERM3[order][k];
+
+        for(int k = 0; k < 2 && sorted; k++)
+            sorted = __builtin_popcount(stacks[c.stacks[k]]) <=
+                     __builtin_popcount(stacks[c.stacks[k + 1]]);
+
+        if(!sorted)
+            continue;
+
+        for(int i0 = 0; i0 < numPerms[c.stacks[0]]; i0++)
+        {
+            for(int i1 = 0; i1 < numPerms[c.stacks[1]]; i1++)
+            {
+                for(int i2 = 0; i2 < numPerms[c.stacks[2]]; i2++)
+                {
+                    c.perms[0] = perms[c.stacks[0]][i0];
+                    c.perms[1] = perms[c.stacks[1]][i1];
+                    c.perms[2] = perms[c.stacks[2]][i2];
+
+                    int values[9];
+                    for(int r = 0; r < 9; r++)
+                    {
+                        const int* bits = s.pattern[transpose][r];
+
+                        values[r] =
+                            (BITS3.value[c.perms[0]][bits[c.stacks[0]]] << 6) |
+                            (BITS3.value[c.perms[1]][bits[c.stacks[1]]] << 3) |
+                            BITS3.value[c.perms[2]][bits[c.stacks[2]]];
+                    }
+
+                    placeRows(s, c, values);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Compare the numbers of one full transform against the best so far
+ *
+ * @param s search in progress
+ * @param transpose 1 if the grid is transposed
+ * @param rows row each row of the result comes from
+ * @param cols column each column of the result comes from
+ */
+static void tryDigits(Search& s, int transpose, const int rows[9],
+                      const int cols[9])
+{
+    const int* grid = s.grid[transpose];
+    int labels[10] = {0};
+    int next = 1;
+    bool lower = !s.digitsFound;
+    int out[81];
+
+    s.digitTries++;
+
+    for(int r = 0; r < 9; r++)
+    {
+        for(int c = 0; c < 9; c++)
+        {
+            int v = grid[rows[r] * 9 + cols[c]];
+
+            if(v != 0)
+            {
+                if(labels[v] == 0)
+                    labels[v] = next++;
+
+                v = labels[v];
+            }
+
+            int i = r * 9 + c;
+            out[i] = v;
+
+            if(!lower)
+            {
+                if(v > s.bestDigits[i])
+                    return;
+                if(v < s.bestDigits[i])
+                    lower = true;
+            }
+        }
+    }
+
+    if(!lower)
+        return;
+
+    std::copy(out, out + 81, s.bestDigits);
+    s.digitsFound = true;
+    s.sym.transpose = (transpose == 1);
+    std::copy(rows, rows + 9, s.sym.rows);
+    std::copy(cols, cols + 9, s.sym.cols);
+
+    // numbers missing from the board take the labels left, in order
+    for(int d = 1; d < 10; d++)
+    {
+        if(labels[d] == 0)
+            labels[d] = next++;
+    }
+
+    std::copy(labels, labels + 10, s.sym.digits);
+}
+
+/**
+ * Try every row order that gives the best pattern for a choice of
+ * columns, comparing their numbers
+ */
+static void chooseRows(Search& s, const ColumnChoice& c)
+{
+    int cols[9];
+    for(int j = 0; j < 9; j++)
+        cols[j] = 3 * c.stacks[j / 3] + PERM3[c.perms[j / 3]][j % 3];
+
+    int values[9];
+    for(int r = 0; r < 9; r++)
+    {
+        const int* stacks = s.pattern[c.transpose][r];
+
+        values[r] = (BITS3.value[c.perms[0]][stacks[c.stacks[0]]] << 6) |
+                    (BITS3.value[c.perms[1]][stacks[c.stacks[1]]] << 3) |
+                    BITS3.value[c.perms[2]][stacks[c.stacks[2]]];
+    }
+
+    // row orders of each band that give each band position of the best
+    // pattern, most of them give none
+    int orders[3][3][6];
+    int numOrders[3][3];
+
+    for(int band = 0; band < 3; band++)
+    {
+        for(int b = 0; b < 3; b++)
+        {
+            numOrders[band][b] = 0;
+
+            for(int p = 0; p < 6; p++)
+            {
+                bool match = true;
+
+                for(int j = 0; j < 3 && match; j++)
+                    match = (values[band * 3 + PERM3[p][j]] ==
+                             s.best[b * 3 + j]);
+
+                if(match)
+                    orders[band][b][numOrders[band][b]++] = p;
+            }
+        }
+    }
+
+    int rows[9];
+
+    for(int bp = 0; bp < 6; bp++)
+    {
+        const int* bands = PERM3[bp];
+
+        if(numOrders[bands[0]][0] == 0 || numOrders[bands[1]][1] == 0 ||
+           numOrders[bands[2]][2] == 0)
+            continue;
+
+        for(int i0 = 0; i0 < numOrders[bands[0]][0]; i0++)
+        {
+            for(int i1 = 0; i1 < numOrders[bands[1]][1]; i1++)
+            {
+                for(int i2 = 0; i2 < numOrders[bands[2]][2]; i2++)
+                {
+                    if(s.digitTries >= MAX_DIGIT_TRIES)
+                        return;
+
+                    int perms[3] = {orders[bands[0]][0][i0],
+                                    orders[bands[1]][1][i1],
+                                    orders[bands[2]][2][i2]};
+
+                    for(int r = 0; r < 9; r++)
+                        rows[r] = bands[r / 3] * 3 +
+                                  PERM3[perms[r / 3]][r % 3];
+
+                    tryDigits(s, c.transpose, rows, cols);
+                }
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+Symmetry::Symmetry()
+{
+    this->transpose = false;
+
+    for(int i = 0; i < 9; i++)
+    {
+        this->rows[i] = i;
+        this->cols[i] = i;
+    }
+
+    for(int d = 0; d < 10; d++)
+        this->digits[d] = d;
+}
+
+//----------------------------------------------------------------------------
+void Symmetry::apply(const Board& in, Board& out) const
+{
+    for(int r = 0; r < 9; r++)
+    {
+        for(int c = 0; c < 9; c++)
+        {
+            int v = this->transpose ? in.getCell(this->cols[c], this->rows[r])
+                                    : in.getCell(this->rows[r], this->cols[c]);
+
+            out.setCell(r, c, (v == -1) ? -1 : this->digits[v]);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+void Symmetry::invert(const Board& in, Board& out) const
+{
+    int original[10];
+    for(int d = 1; d < 10; d++)
+        original[this->digits[d]] = d;
+
+    for(int r = 0; r < 9; r++)
+    {
+        for(int c = 0; c < 9; c++)
+        {
+            int v = in.getCell(r, c);
+            v = (v == -1) ? -1 : original[v];
+
+            if(this->transpose)
+                out.setCell(this->cols[c], this->rows[r], v);
+            else
+                out.setCell(this->rows[r], this->cols[c], v);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+void canonicalForm(const Board& b, Board& canon, Symmetry& sym)
+{
+    Search s;
+
+    for(int r = 0; r < 9; r++)
+    {
+        for(int c = 0; c < 9; c++)
+        {
+            int v = b.getCell(r, c);
+            v = (v >= 1 && v <= 9) ? v : 0;
+
+            s.grid[0][r * 9 + c] = v;
+            s.grid[1][c * 9 + r] = v;
+        }
+    }
+
+    for(int t = 0; t < 2; t++)
+    {
+        for(int r = 0; r < 9; r++)
+        {
+            for(int stack = 0; stack < 3; stack++)
+            {
+                int bits = 0;
+
+                for(int j = 0; j < 3; j++)
+                {
+                    if(s.grid[t][r * 9 + stack * 3 + j] != 0)
+                        bits |= 4 >> j;
+                }
+
+                s.pattern[t][r][stack] = bits;
+            }
+        }
+    }
+
+    // a row is smallest with its stacks from least to most filled, and
+    // the empty spaces first in each
+    int smallest[2][9];
+    int firstRow = 1 << 9;
+
+    for(int t = 0; t < 2; t++)
+    {
+        for(int r = 0; r < 9; r++)
+        {
+            int counts[3];
+            for(int stack = 0; stack < 3; stack++)
+                counts[stack] = __builtin_popcount(s.pattern[t][r][stack]);
+
+            sort3(counts[0], counts[1], counts[2]);
+
+            int v = 0;
+            for(int stack = 0; stack < 3; stack++)
+                v = (v << 3) | ((1 << counts[stack]) - 1);
+
+            smallest[t][r] = v;
+            firstRow = std::min(firstRow, v);
+        }
+    }
+
+    s.found = false;
+    s.digitsFound = false;
+    s.digitTries = 0;
+
+    for(int t = 0; t < 2; t++)
+    {
+        for(int r = 0; r < 9; r++)
+        {
+            if(smallest[t][r] == firstRow)
+                chooseColumns(s, t, r);
+        }
+    }
+
+    for(size_t i = 0; i < s.ties.size() && s.digitTries < MAX_DIGIT_TRIES;
+        i++)
+        chooseRows(s, s.ties[i]);
+
+    sym = s.sym;
+
+    for(int i = 0; i < 81; i++)
+        canon.setCell(i / 9, i % 9, (s.bestDigits[i] == 0) ? -1
+                                                           : s.bestDigits[i]);
+}
@@ -0,0 +1,66 @@
+#ifndef CANONICAL_H_INCLUDED
+#define CANONICAL_H_INCLUDED
+
+#include <iostream>
+#include <vector>
+
+#include "Board.h"
+
+/**
+ * The Symmetry class is one of the transforms that turn a sudoku board
+ * into an equivalent one: optionally transposing the grid, reordering the
+ * rows within each band and the bands themselves, doing the same for the
+ * columns and stacks, and relabeling the numbers.
+ */
+class Symmetry
+{
+    public:
+        bool transpose;             ///< True if the grid is transposed first
+        int rows[9];                ///< Row each row of the result comes from
+        int cols[9];                ///< Column each column comes from
+        int digits[10];             ///< New label of each number, 0 for empty
+
+        /**
+         * Default Constructor, the identity
+         */
+        Symmetry();
+
+        /**
+         * Transform a board
+         *
+         * @param in board to transform
+         * @param out transformed board
+         */
+        void apply(const Board& in, Board& out) const;
+
+        /**
+         * Undo the transform
+         *
+         * @param in transformed board
+         * @param out board as it was before the transform
+         */
+        void invert(const Board& in, Board& out) const;
+};
+
+/**
+ * Find the canonical form of a board
+ * Every board the symmetries relate has the same canonical form. Among
+ * all transforms of the board, the canonical form has the smallest
+ * pattern of filled spaces, read row by row with empty spaces first, and
+ * among those the smallest numbers once they are relabeled 1, 2, 3, ...
+ * in the order they first appear.
+ *
+ * Rather than trying every transform, only the column orders that give
+ * the smallest possible first row are tried, the best row order for each
+ * is found by sorting, and only the transforms left tied on the pattern
+ * are compared on their numbers. Boards with so few numbers that a huge
+ * number of transforms tie settle for the best of the first 65536, which
+ * is still a transform of the board but may differ between boards the
+ * symmetries relate.
+ *
+ * @param b board to transform
+ * @param canon canonical form of the board
+ * @param sym transform that turns b into canon
+ */
+void canonicalForm(const Board& b, Board& canon, Symmetry& sym);
+#endif
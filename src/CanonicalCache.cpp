@@ -0,0 +1,55 @@
+#include <chrono>
+
+#include "CanonicalCache.h"
+
+//----------------------------------------------------------------------------
+CanonicalCache::CanonicalCache(size_t bytes) : store(bytes)
+{
+}
+
+//----------------------------------------------------------------------------
+bool CanonicalCache::solve(SudokuSolver& solver)
+{
+    if(solver.budget > 0)
+        return solver.solveDriver();
+
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+
+    Board canon;
+    Symmetry sym;
+    canonicalForm(solver.board, canon, sym);
+
+    // guessing solves boards that are stuck without it
+    ResultCache::Key key;
+    ResultCache::makeKey(canon, solver.search, key);
+
+    SolveStats stats;
+    if(this->store.find(key, canon, stats))
+    {
+        sym.invert(canon, solver.board);
+        solver.stats = stats;
+        solver.unsolvable = false;
+        solver.stats.nanos =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+
+        return solver.stats.status == SOLVED;
+    }
+
+    solver.solveDriver();
+
+    if(solver.stats.status == SOLVED || solver.stats.status == STUCK)
+    {
+        sym.apply(solver.board, canon);
+        this->store.insert(key, canon, solver.stats);
+    }
+
+    return solver.stats.status == SOLVED;
+}
+
+//----------------------------------------------------------------------------
+const ResultCache& CanonicalCache::entries() const
+{
+    return this->store;
+}
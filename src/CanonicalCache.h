@@ -0,0 +1,57 @@
+#ifndef CANONICALCACHE_H_INCLUDED
+#define CANONICALCACHE_H_INCLUDED
+
+#include <cstddef>
+
+#include "Canonical.h"
+#include "ResultCache.h"
+#include "SudokuSolver.h"
+
+/**
+ * The CanonicalCache class remembers solved boards by their canonical
+ * form, so a board that is a relabeled, reordered, or transposed copy of
+ * one solved before is answered by transforming the earlier solution
+ * back instead of solving it again.
+ *
+ * Only boards that end solved or stuck are kept, since those results do
+ * not depend on the order the solver visits the spaces in. Solves with a
+ * budget bypass the cache. The boards are kept in a ResultCache, so the
+ * cache stays within its memory and may be shared between threads.
+ *
+ * The counts reported for a hit are those of the equivalent board that
+ * was solved, and with search a board with several solutions may get a
+ * different one of them than a fresh solve would.
+ */
+class CanonicalCache
+{
+    private:
+        ResultCache store;          ///< Solves by canonical form
+
+    public:
+        /**
+         * Constructor
+         *
+         * @param bytes memory the remembered boards may take
+         */
+        CanonicalCache(size_t bytes = 64 << 20);
+
+        /**
+         * Solve the solver's board, from the cache if an equivalent board
+         * was solved before
+         * On a hit the board and stats are as the solver would leave them,
+         * except that the time is that of the lookup.
+         *
+         * @param solver solver holding the board, left holding the result
+         *
+         * @return true if the board is solved
+         */
+        bool solve(SudokuSolver& solver);
+
+        /**
+         * Get the cache the canonical forms are kept in, for its counts
+         *
+         * @return the backing cache
+         */
+        const ResultCache& entries() const;
+};
+#endif
@@ -0,0 +1,177 @@
+#include <immintrin.h>
+
+#include "LineParser.h"
+
+//----------------------------------------------------------------------------
+bool parseCellsScalar(const char* line, int* cells)
+{
+    // check everything first so a bad line leaves the cells alone
+    for(int i = 0; i < 81; i++)
+    {
+        char ch = line[i];
+
+        if(!((ch >= '0' && ch <= '9') || ch == '.'))
+            return false;
+    }
+
+    for(int i = 0; i < 81; i++)
+    {
+        char ch = line[i];
+
+        if(ch == '.' || ch == '0')
+            cells[i] = -1;
+        else
+            cells[i] = ch - '0';
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+__attribute__((target("sse4.1")))
+static inline __m128i validSse41(__m128i v, __m128i& empty)
+{
+    // bytes of 0x80 and up are negative and fail the digit range
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0')),
+                                  _mm_cmpgt_epi8(_mm_set1_epi8(':'), v));
+
+    empty = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('.')),
+                         _mm_cmpeq_epi8(v, _mm_set1_epi8('0')));
+
+    return _mm_or_si128(digit, empty);
+}
+
+//----------------------------------------------------------------------------
+__attribute__((target("sse4.1")))
+static inline void storeSse41(__m128i v, __m128i empty, int* cells)
+{
+    // empty spaces are all ones, which is -1 once sign extended
+    __m128i val = _mm_or_si128(_mm_andnot_si128(empty,
+                                   _mm_sub_epi8(v, _mm_set1_epi8('0'))),
+                               empty);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(cells),
+                     _mm_cvtepi8_epi32(val));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(cells + 4),
+                     _mm_cvtepi8_epi32(_mm_srli_si128(val, 4)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(cells + 8),
+                     _mm_cvtepi8_epi32(_mm_srli_si128(val, 8)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(cells + 12),
+                     _mm_cvtepi8_epi32(_mm_srli_si128(val, 12)));
+}
+
+//----------------------------------------------------------------------------
+__attribute__((target("sse4.1")))
+bool parseCellsSse41(const char* line, int* cells)
+{
+    // the last load overlaps the one before it so nothing past the 81st
+    // character is touched
+    static const int offsets[6] = {0, 16, 32, 48, 64, 65};
+    __m128i v[6];
+    __m128i empty[6];
+    __m128i ok = _mm_set1_epi8(-1);
+
+    for(int i = 0; i < 6; i++)
+    {
+        v[i] = _mm_loadu_si128(
+                   reinterpret_cast<const __m128i*>(line + offsets[i]));
+        ok = _mm_and_si128(ok, validSse41(v[i], empty[i]));
+    }
+
+    if(_mm_movemask_epi8(ok) != 0xffff)
+        return false;
+
+    for(int i = 0; i < 6; i++)
+        storeSse41(v[i], empty[i], cells + offsets[i]);
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+__attribute__((target("avx2")))
+static inline __m256i validAvx2(__m256i v, __m256i& empty)
+{
+    // bytes of 0x80 and up are negative and fail the digit range
+    __m256i digit = _mm256_and_si256(
+                        _mm256_cmpgt_epi8(v, _mm256_set1_epi8('0')),
+                        _mm256_cmpgt_epi8(_mm256_set1_epi8(':'), v));
+
+    empty = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('.')),
+                            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('0')));
+
+    return _mm256_or_si256(digit, empty);
+}
+
+//----------------------------------------------------------------------------
+__attribute__((target("avx2")))
+static inline void storeAvx2(__m256i v, __m256i empty, int* cells)
+{
+    // empty spaces are all ones, which is -1 once sign extended
+    __m256i val = _mm256_or_si256(_mm256_andnot_si256(empty,
+                                      _mm256_sub_epi8(v,
+                                          _mm256_set1_epi8('0'))),
+                                  empty);
+    __m128i lo = _mm256_castsi256_si128(val);
+    __m128i hi = _mm256_extracti128_si256(val, 1);
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(cells),
+                        _mm256_cvtepi8_epi32(lo));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(cells + 8),
+                        _mm256_cvtepi8_epi32(_mm_srli_si128(lo, 8)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(cells + 16),
+                        _mm256_cvtepi8_epi32(hi));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(cells + 24),
+                        _mm256_cvtepi8_epi32(_mm_srli_si128(hi, 8)));
+}
+
+//----------------------------------------------------------------------------
+__attribute__((target("avx2")))
+bool parseCellsAvx2(const char* line, int* cells)
+{
+    // the last load covers characters 49 through 80, overlapping the
+    // second, so nothing past the 81st character is touched
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(line));
+    __m256i b = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(line + 32));
+    __m256i c = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(line + 49));
+    __m256i emptyA, emptyB, emptyC;
+
+    __m256i ok = _mm256_and_si256(validAvx2(a, emptyA),
+                     _mm256_and_si256(validAvx2(b, emptyB),
+                                      validAvx2(c, emptyC)));
+
+    if(_mm256_movemask_epi8(ok) != -1)
+        return false;
+
+    storeAvx2(a, emptyA, cells);
+    storeAvx2(b, emptyB, cells + 32);
+    storeAvx2(c, emptyC, cells + 49);
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * Pick the fastest parser the processor supports
+ */
+static bool (*chooseParser())(const char*, int*)
+{
+    __builtin_cpu_init();
+
+    if(__builtin_cpu_supports("avx2"))
+        return parseCellsAvx2;
+
+    if(__builtin_cpu_supports("sse4.1"))
+        return parseCellsSse41;
+
+    return parseCellsScalar;
+}
+
+//----------------------------------------------------------------------------
+bool parseCells(const char* line, int* cells)
+{
+    static bool (* const parser)(const char*, int*) = chooseParser();
+
+    return parser(line, cells);
+}
@@ -0,0 +1,55 @@
+#ifndef LINEPARSER_H_INCLUDED
+#define LINEPARSER_H_INCLUDED
+
+/**
+ * \file
+ * Parsers turning 81 characters into board cells
+ *
+ * Every parser takes exactly 81 characters. Digits 1-9 become their
+ * value, '.' and '0' become -1, and any other character makes the whole
+ * line invalid. Nothing is written unless the line is valid.
+ */
+
+/**
+ * Parse a line one character at a time
+ *
+ * @param line 81 characters to parse
+ * @param cells 81 cells to fill
+ *
+ * @return true if the line was valid
+ */
+bool parseCellsScalar(const char* line, int* cells);
+
+/**
+ * Parse a line sixteen characters at a time with SSE4.1
+ * Only call this if the processor supports SSE4.1.
+ *
+ * @param line 81 characters to parse
+ * @param cells 81 cells to fill
+ *
+ * @return true if the line was valid
+ */
+bool parseCellsSse41(const char* line, int* cells);
+
+/**
+ * Parse a line with three 32 character loads using AVX2
+ * Only call this if the processor supports AVX2.
+ *
+ * @param line 81 characters to parse
+ * @param cells 81 cells to fill
+ *
+ * @return true if the line was valid
+ */
+bool parseCellsAvx2(const char* line, int* cells);
+
+/**
+ * Parse a line with the fastest parser the processor supports
+ * The choice is made once, on the first call.
+ *
+ * @param line 81 characters to parse
+ * @param cells 81 cells to fill
+ *
+ * @return true if the line was valid
+ */
+bool parseCells(const char* line, int* cells);
+#endif
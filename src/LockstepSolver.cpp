@@ -0,0 +1,237 @@
+#include <chrono>
+#include <cstring>
+
+#include "LockstepSolver.h"
+
+const int LockstepSolver::LANES;
+
+/**
+ * One 16 bit lane per board, bit d - 1 standing for the number d
+ */
+typedef unsigned short Lanes __attribute__((vector_size(32)));
+
+static const unsigned short ALL = 0x1ff;
+
+/**
+ * Boards laid out cell by cell, each cell holding every board's value
+ */
+struct LockstepState
+{
+    Lanes cells[81];            ///< Bit of the number in each cell, 0 empty
+    Lanes bad;                  ///< All ones in lanes that contradicted
+    Lanes passes;               ///< Passes that changed each board
+    Lanes blockSingles;         ///< Numbers placed by block
+    Lanes rowSingles;           ///< Numbers placed by row
+    Lanes colSingles;           ///< Numbers placed by column
+};
+
+/**
+ * Cells of every block, row, and column, in that order
+ */
+struct Units
+{
+    unsigned char cell[27][9];
+
+    Units()
+    {
+        for(int u = 0; u < 9; u++)
+        {
+            for(int i = 0; i < 9; i++)
+            {
+                this->cell[u][i] = ((u / 3) * 3 + i / 3) * 9 +
+                                   (u % 3) * 3 + i % 3;
+                this->cell[9 + u][i] = u * 9 + i;
+                this->cell[18 + u][i] = i * 9 + u;
+            }
+        }
+    }
+};
+
+static const Units UNITS;
+
+/**
+ * Determine whether any lane is non zero
+ */
+static inline bool any(const Lanes& v)
+{
+    unsigned short lanes[LockstepSolver::LANES];
+    std::memcpy(lanes, &v, sizeof(v));
+
+    unsigned short all = 0;
+    for(int i = 0; i < LockstepSolver::LANES; i++)
+        all |= lanes[i];
+
+    return all != 0;
+}
+
+/**
+ * Place every number that has only one space left in a block, row, or
+ * column, pass after pass, until no board changes
+ *
+ * @param s boards to work on
+ * @param budget most passes, 0 for no limit
+ */
+__attribute__((target_clones("avx2", "default")))
+static void propagate(LockstepState& s, int budget)
+{
+    const Lanes all = {ALL, ALL, ALL, ALL, ALL, ALL, ALL, ALL,
+                       ALL, ALL, ALL, ALL, ALL, ALL, ALL, ALL};
+    const Lanes zero = {};
+    const Lanes one = zero + 1;
+
+    for(int pass = 0; budget == 0 || pass < budget; pass++)
+    {
+        Lanes present[27];
+        Lanes cand[81];
+        Lanes changed = zero;
+
+        for(int u = 0; u < 27; u++)
+        {
+            present[u] = zero;
+            for(int i = 0; i < 9; i++)
+                present[u] |= s.cells[UNITS.cell[u][i]];
+        }
+
+        // numbers that could still go in each empty space
+        for(int c = 0; c < 81; c++)
+        {
+            Lanes taken = present[(c / 27) * 3 + (c % 9) / 3] |
+                          present[9 + c / 9] | present[18 + c % 9];
+            Lanes empty = (Lanes)(s.cells[c] == zero);
+
+            cand[c] = ~taken & all & empty;
+        }
+
+        for(int u = 0; u < 27; u++)
+        {
+            Lanes once = zero;
+            Lanes twice = zero;
+
+            for(int i = 0; i < 9; i++)
+            {
+                Lanes c = cand[UNITS.cell[u][i]];
+                twice |= once & c;
+                once |= c;
+            }
+
+            // a missing number with nowhere to go is a contradiction
+            s.bad |= (Lanes)((all & ~present[u] & ~once) != zero);
+
+            Lanes single = once & ~twice;
+            Lanes* count = (u < 9) ? &s.blockSingles :
+                           (u < 18) ? &s.rowSingles : &s.colSingles;
+
+            for(int i = 0; i < 9; i++)
+            {
+                int cell = UNITS.cell[u][i];
+                Lanes place = cand[cell] & single;
+
+                // a space claimed twice, or already filled this pass,
+                // waits for the next pass
+                Lanes ok = (Lanes)((place & (place - one)) == zero) &
+                           (Lanes)(s.cells[cell] == zero);
+                place &= ok;
+
+                s.cells[cell] |= place;
+                changed |= place;
+                *count += (Lanes)(place != zero) & one;
+            }
+        }
+
+        changed = (Lanes)(changed != zero) & ~s.bad;
+        s.passes += changed & one;
+
+        if(!any(changed))
+            break;
+    }
+}
+
+//----------------------------------------------------------------------------
+LockstepSolver::LockstepSolver()
+{
+    this->budget = 0;
+    this->search = false;
+}
+
+//----------------------------------------------------------------------------
+void LockstepSolver::solve(const Board* in, int n, Result* out)
+{
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+
+    LockstepState s;
+    unsigned short cells[81][LANES];
+
+    std::memset(cells, 0, sizeof(cells));
+    std::memset(&s, 0, sizeof(s));
+
+    for(int b = 0; b < n; b++)
+    {
+        for(int c = 0; c < 81; c++)
+        {
+            int val = in[b].getCell(c / 9, c % 9);
+
+            // anything but 1-9 is left for the fallback
+            if(val == -1)
+                continue;
+            else if(val >= 1 && val <= 9)
+                cells[c][b] = 1 << (val - 1);
+            else
+                s.bad[b] = 0xffff;
+        }
+    }
+
+    for(int c = 0; c < 81; c++)
+        std::memcpy(&s.cells[c], cells[c], sizeof(Lanes));
+
+    propagate(s, this->budget);
+
+    for(int c = 0; c < 81; c++)
+        std::memcpy(cells[c], &s.cells[c], sizeof(Lanes));
+
+    long long nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now() - start).count();
+
+    for(int b = 0; b < n; b++)
+    {
+        // a solved board has every number once in every unit
+        bool solved = (s.bad[b] == 0);
+
+        for(int u = 0; u < 27 && solved; u++)
+        {
+            unsigned short seen = 0;
+
+            for(int i = 0; i < 9; i++)
+                seen |= cells[UNITS.cell[u][i]][b];
+
+            solved = (seen == ALL);
+        }
+
+        if(!solved)
+        {
+            this->fallback.board = in[b];
+            this->fallback.budget = this->budget;
+            this->fallback.search = this->search;
+            this->fallback.solveDriver();
+
+            out[b].solution = this->fallback.board;
+            out[b].stats = this->fallback.stats;
+            continue;
+        }
+
+        for(int c = 0; c < 81; c++)
+            out[b].solution.setCell(c / 9, c % 9,
+                                    __builtin_ctz(cells[c][b]) + 1);
+
+        SolveStats& stats = out[b].stats;
+        stats = SolveStats();
+        stats.status = SOLVED;
+        stats.blockSingles = s.blockSingles[b];
+        stats.rowSingles = s.rowSingles[b];
+        stats.colSingles = s.colSingles[b];
+        stats.placements = stats.blockSingles + stats.rowSingles +
+                           stats.colSingles;
+        stats.passes = s.passes[b];
+        stats.nanos = nanos / n;
+    }
+}
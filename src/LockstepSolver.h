@@ -0,0 +1,49 @@
+#ifndef LOCKSTEPSOLVER_H_INCLUDED
+#define LOCKSTEPSOLVER_H_INCLUDED
+
+#include <iostream>
+#include <vector>
+
+#include "Board.h"
+#include "SudokuSolver.h"
+#include "SolveBatch.h"
+
+/**
+ * The LockstepSolver class solves several boards at once. The boards are
+ * interleaved so that every SIMD lane holds the same cell of a different
+ * board, and the cross checks of crossCheckBlock(), crossCheckRow(), and
+ * crossCheckCol() run on all of them together.
+ *
+ * Boards that are not solved this way, because they get stuck, run out of
+ * budget, or contradict themselves, are handed to a SudokuSolver so their
+ * results are exactly what solveDriver() gives, guessing if search is set.
+ */
+class LockstepSolver
+{
+    private:
+        SudokuSolver fallback;      ///< Solver for boards that stall
+
+    public:
+        static const int LANES = 16;    ///< Boards solved together
+
+        int budget;                 ///< Most passes per board, 0 for no limit
+        bool search;                ///< Guess on boards that get stuck
+
+        /**
+         * Default Constructor
+         */
+        LockstepSolver();
+
+        /**
+         * Solve up to LANES boards together
+         * Solved boards have the same solution as solveDriver() gives;
+         * their placement counts come from the lockstep passes and their
+         * time is the time of the whole group shared out evenly.
+         *
+         * @param in boards to solve
+         * @param n number of boards, at most LANES
+         * @param out results, one for each board
+         */
+        void solve(const Board* in, int n, Result* out);
+};
+#endif
@@ -0,0 +1,225 @@
+#include <algorithm>
+
+#include "LockstepSolver.h"
+#include "MicroBatcher.h"
+#include "ThreadPool.h"
+
+//----------------------------------------------------------------------------
+MicroBatcher::MicroBatcher()
+    : windowNanos(0), target(1000), batches(0), boards(0)
+{
+    this->queued = 0;
+    this->stopping = false;
+    this->maxBatch = 256;
+    this->maxWindow = 200;
+}
+
+//----------------------------------------------------------------------------
+MicroBatcher::~MicroBatcher()
+{
+    this->stop();
+}
+
+//----------------------------------------------------------------------------
+void MicroBatcher::start()
+{
+    this->stop();
+
+    this->stopping = false;
+    this->windowNanos = this->maxWindow * 1000;
+    this->dispatcher = std::thread(&MicroBatcher::dispatch, this);
+}
+
+//----------------------------------------------------------------------------
+void MicroBatcher::stop()
+{
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        this->stopping = true;
+    }
+
+    this->arrived.notify_one();
+
+    if(this->dispatcher.joinable())
+        this->dispatcher.join();
+}
+
+//----------------------------------------------------------------------------
+void MicroBatcher::submit(const Board* boards, size_t n, bool search,
+                          int budget, const Done& done)
+{
+    if(n == 0)
+    {
+        done(nullptr, 0);
+        return;
+    }
+
+    std::shared_ptr<Pending> req(new Pending());
+    req->boards.assign(boards, boards + n);
+    req->results.resize(n);
+    req->taken = 0;
+    req->left = n;
+    req->search = search;
+    req->budget = budget;
+    req->done = done;
+    req->arrival = Clock::now();
+    req->waited = 0;
+
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        this->queue.push_back(req);
+        this->queued += n;
+    }
+
+    this->arrived.notify_one();
+}
+
+//----------------------------------------------------------------------------
+long long MicroBatcher::window() const
+{
+    return this->windowNanos / 1000;
+}
+
+//----------------------------------------------------------------------------
+void MicroBatcher::take(std::vector<Board>& batch,
+                        std::vector<Segment>& segments, BatchOptions& opts)
+{
+    const Pending& front = *this->queue.front();
+    bool search = front.search;
+    int budget = front.budget;
+    size_t kept = 0;
+    Clock::time_point now = Clock::now();
+
+    opts.search = search;
+    opts.budget = budget;
+
+    for(size_t i = 0; i < this->queue.size(); i++)
+    {
+        std::shared_ptr<Pending>& req = this->queue[i];
+        size_t room = this->maxBatch - batch.size();
+
+        if(room > 0 && req->search == search && req->budget == budget)
+        {
+            size_t n = std::min(room, req->boards.size() - req->taken);
+
+            if(req->taken == 0)
+                req->waited = std::chrono::duration_cast<
+                    std::chrono::nanoseconds>(now - req->arrival).count();
+
+            Segment seg = {req, req->taken, n};
+            segments.push_back(seg);
+            batch.insert(batch.end(), req->boards.begin() + req->taken,
+                         req->boards.begin() + req->taken + n);
+
+            req->taken += n;
+            this->queued -= n;
+        }
+
+        // requests with boards left keep their place in line
+        if(req->taken < req->boards.size())
+            std::swap(this->queue[kept++], req);
+    }
+
+    this->queue.resize(kept);
+}
+
+//----------------------------------------------------------------------------
+void MicroBatcher::adapt(Clock::duration tail, size_t requests)
+{
+    long long took = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         tail).count();
+    long long limit = this->target * 1000;
+    long long w = this->windowNanos;
+
+    if(took > limit || requests < 2)
+        w /= 2;
+    else if(took < limit / 2)
+        w = std::min(w + this->maxWindow * 1000 / 16 + 1,
+                     this->maxWindow * 1000);
+
+    this->windowNanos = w;
+}
+
+//----------------------------------------------------------------------------
+void MicroBatcher::dispatch()
+{
+    std::vector<Board> batch;
+    std::vector<Result> results;
+    std::vector<Segment> segments;
+    SudokuSolver solver;
+
+    while(true)
+    {
+        BatchOptions opts;
+        batch.clear();
+        segments.clear();
+
+        {
+            std::unique_lock<std::mutex> guard(this->lock);
+
+            this->arrived.wait(guard, [this]()
+            {
+                return !this->queue.empty() || this->stopping;
+            });
+
+            if(this->queue.empty())
+                return;
+
+            // wait for more boards until the oldest request's window ends
+            Clock::time_point deadline = this->queue.front()->arrival +
+                std::chrono::nanoseconds(this->windowNanos.load());
+
+            this->arrived.wait_until(guard, deadline, [this]()
+            {
+                return this->queued >= static_cast<size_t>(this->maxBatch) ||
+                       this->stopping;
+            });
+
+            this->take(batch, segments, opts);
+        }
+
+        results.resize(batch.size());
+
+        // a lone board is not worth a trip through the pool
+        if(batch.size() == 1)
+        {
+            solver.board = batch[0];
+            solver.budget = opts.budget;
+            solver.search = opts.search;
+            solver.solveDriver();
+
+            results[0].solution = solver.board;
+            results[0].stats = solver.stats;
+        }
+        else
+        {
+            opts.threads = std::max(ThreadPool::shared().size(), 1);
+            opts.lockstep = batch.size() >= LockstepSolver::LANES;
+            solveBatch(batch.data(), batch.size(), results.data(), opts);
+        }
+
+        Clock::time_point now = Clock::now();
+        Clock::duration tail = Clock::duration::zero();
+        size_t at = 0;
+
+        for(size_t i = 0; i < segments.size(); i++)
+        {
+            Segment& seg = segments[i];
+
+            std::copy(results.begin() + at, results.begin() + at + seg.count,
+                      seg.req->results.begin() + seg.first);
+            at += seg.count;
+
+            seg.req->left -= seg.count;
+            if(seg.req->left == 0)
+            {
+                tail = std::max(tail, now - seg.req->arrival);
+                seg.req->done(seg.req->results.data(), seg.req->waited);
+            }
+        }
+
+        this->batches++;
+        this->boards += batch.size();
+        this->adapt(tail, segments.size());
+    }
+}
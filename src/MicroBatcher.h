@@ -0,0 +1,157 @@
+#ifndef MICROBATCHER_H_INCLUDED
+#define MICROBATCHER_H_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "SolveBatch.h"
+
+/**
+ * The MicroBatcher class gathers the boards of many small requests into
+ * batches, so they are solved together through solveBatch(), in lockstep
+ * groups on the shared ThreadPool, instead of one at a time.
+ *
+ * A batch is sent off once it holds maxBatch boards, or once the oldest
+ * request has waited for the window. Only requests with the same search
+ * flag and budget share a batch. The window adapts to the load: it is
+ * halved whenever a request of a batch took longer than the latency
+ * target, from submit() to its results, or when a batch held a single
+ * request, since waiting then only added latency. It grows a step at a
+ * time, up to maxWindow, while batches gather several requests and every
+ * request finishes within half of the target.
+ */
+class MicroBatcher
+{
+    public:
+        /**
+         * Called once with the results of every board of a request, in
+         * the order the boards were given, and the nanoseconds it waited
+         * before its first board was solved
+         */
+        typedef std::function<void(const Result* results, long long waited)>
+            Done;
+
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        /**
+         * A request waiting for results
+         */
+        struct Pending
+        {
+            std::vector<Board> boards;      ///< Boards to solve
+            std::vector<Result> results;    ///< Results so far
+            size_t taken;                   ///< Boards put in a batch
+            size_t left;                    ///< Boards without a result
+            bool search;                    ///< Guess on stuck boards
+            int budget;                     ///< Most passes per board
+            Done done;                      ///< Told when all are solved
+            Clock::time_point arrival;      ///< When it was submitted
+            long long waited;               ///< Nanoseconds until its first
+                                            ///< batch
+        };
+
+        /**
+         * Boards of one request that are part of a batch
+         */
+        struct Segment
+        {
+            std::shared_ptr<Pending> req;   ///< Request they come from
+            size_t first;                   ///< First board in the request
+            size_t count;                   ///< Number of boards
+        };
+
+        std::mutex lock;                    ///< Guards the queue
+        std::condition_variable arrived;    ///< Signalled on submit()
+        std::deque<std::shared_ptr<Pending>> queue;     ///< Requests with
+                                                        ///< boards left
+        size_t queued;                      ///< Boards not yet in a batch
+        bool stopping;                      ///< Set by stop()
+        std::thread dispatcher;             ///< Forms and solves batches
+        std::atomic<long long> windowNanos; ///< Current window
+
+        /**
+         * Body of the dispatcher thread
+         */
+        void dispatch();
+
+        /**
+         * Take the next batch from the queue, lock held
+         *
+         * @param batch boards of the batch
+         * @param segments requests the boards come from
+         * @param opts set to the options the batch is solved with
+         */
+        void take(std::vector<Board>& batch, std::vector<Segment>& segments,
+                  BatchOptions& opts);
+
+        /**
+         * Adjust the window after a batch
+         *
+         * @param tail longest time a request of the batch took
+         * @param requests number of requests in the batch
+         */
+        void adapt(Clock::duration tail, size_t requests);
+
+    public:
+        int maxBatch;               ///< Most boards in a batch
+        long long maxWindow;        ///< Longest window, in microseconds
+        std::atomic<long long> target;  ///< Latency target, in
+                                        ///< microseconds, may change while
+                                        ///< running
+        std::atomic<long long> batches;     ///< Batches solved
+        std::atomic<long long> boards;      ///< Boards solved
+
+        /**
+         * Default Constructor, 256 boards, a 200 microsecond window, and
+         * a 1 millisecond target
+         */
+        MicroBatcher();
+
+        /**
+         * Destructor, stops the dispatcher
+         */
+        ~MicroBatcher();
+
+        /**
+         * Start the dispatcher thread, with the window at its longest
+         */
+        void start();
+
+        /**
+         * Solve what is queued and stop the dispatcher thread
+         */
+        void stop();
+
+        /**
+         * Queue the boards of a request
+         *
+         * @param boards boards to solve, copied
+         * @param n number of boards
+         * @param search true to guess on boards that get stuck
+         * @param budget most passes per board, 0 for no limit
+         * @param done told the results, on the dispatcher thread, which
+         *        it holds up until it returns
+         */
+        void submit(const Board* boards, size_t n, bool search, int budget,
+                    const Done& done);
+
+        /**
+         * Get the current window
+         *
+         * @return window in microseconds
+         */
+        long long window() const;
+
+    private:
+        MicroBatcher(const MicroBatcher&);
+        MicroBatcher& operator=(const MicroBatcher&);
+};
+#endif
@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+
+#include <dirent.h>
+#include <sched.h>
+
+#include "NumaTopology.h"
+
+//----------------------------------------------------------------------------
+NumaTopology::NumaTopology()
+{
+}
+
+//----------------------------------------------------------------------------
+bool NumaTopology::load(const std::string& root)
+{
+    this->ids.clear();
+    this->cpus.clear();
+
+    DIR* dir = opendir(root.c_str());
+    if(dir == nullptr)
+        return false;
+
+    std::vector<int> found;
+    struct dirent* entry;
+
+    while((entry = readdir(dir)) != nullptr)
+    {
+        const char* name = entry->d_name;
+        char* end;
+
+        if(std::string(name).compare(0, 4, "node") != 0 || name[4] == '\0')
+            continue;
+
+        long id = std::strtol(name + 4, &end, 10);
+        if(*end == '\0' && id >= 0)
+            found.push_back(id);
+    }
+
+    closedir(dir);
+    std::sort(found.begin(), found.end());
+
+    for(int id: found)
+    {
+        std::ifstream file(root + "/node" + std::to_string(id) + "/cpulist");
+        std::string text;
+        std::vector<int> list;
+
+        if(!std::getline(file, text) || !parseCpuList(text, list) ||
+           list.empty())
+            continue;
+
+        this->ids.push_back(id);
+        this->cpus.push_back(list);
+    }
+
+    return !this->ids.empty();
+}
+
+//----------------------------------------------------------------------------
+void NumaTopology::keepAllowed()
+{
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+
+    if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+        return;
+
+    std::vector<int> ids;
+    std::vector<std::vector<int>> cpus;
+
+    for(size_t n = 0; n < this->ids.size(); n++)
+    {
+        std::vector<int> list;
+
+        for(int cpu: this->cpus[n])
+        {
+            if(cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))
+                list.push_back(cpu);
+        }
+
+        if(!list.empty())
+        {
+            ids.push_back(this->ids[n]);
+            cpus.push_back(list);
+        }
+    }
+
+    if(ids.empty())
+    {
+        std::vector<int> list;
+
+        for(int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+        {
+            if(CPU_ISSET(cpu, &allowed))
+                list.push_back(cpu);
+        }
+
+        ids.push_back(0);
+        cpus.push_back(list);
+    }
+
+    this->ids = ids;
+    this->cpus = cpus;
+}
+
+//----------------------------------------------------------------------------
+int NumaTopology::size() const
+{
+    return this->ids.size();
+}
+
+//----------------------------------------------------------------------------
+bool NumaTopology::parseCpuList(const std::string& text,
+                                std::vector<int>& list)
+{
+    const char* p = text.c_str();
+    list.clear();
+
+    while(*p != '\0' && *p != '\n')
+    {
+        char* end;
+        long first = std::strtol(p, &end, 10);
+        long last = first;
+
+        if(end == p || first < 0)
+            return false;
+
+        p = end;
+
+        if(*p == '-')
+        {
+            last = std::strtol(p + 1, &end, 10);
+
+            if(end == p + 1 || last < first)
+                return false;
+
+            p = end;
+        }
+
+        for(long cpu = first; cpu <= last; cpu++)
+            list.push_back(cpu);
+
+        if(*p == ',')
+            p++;
+        else if(*p != '\0' && *p != '\n')
+            return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,58 @@
+#ifndef NUMATOPOLOGY_H_INCLUDED
+#define NUMATOPOLOGY_H_INCLUDED
+
+#include <string>
+#include <vector>
+
+/**
+ * The NumaTopology class lists the NUMA nodes of the machine and the CPUs
+ * on each of them, as the kernel reports them under sysfs. Machines
+ * without NUMA support look like a single node holding every CPU.
+ */
+class NumaTopology
+{
+    public:
+        std::vector<int> ids;               ///< Number of each node
+        std::vector<std::vector<int>> cpus; ///< CPUs on each node
+
+        /**
+         * Default Constructor, no nodes
+         */
+        NumaTopology();
+
+        /**
+         * Read the nodes and their CPUs
+         * Nodes without CPUs, which only hold memory, are left out.
+         *
+         * @param root directory holding the node0, node1, ... entries
+         *
+         * @return false if no node with CPUs was found
+         */
+        bool load(const std::string& root = "/sys/devices/system/node");
+
+        /**
+         * Drop the CPUs the process may not run on, and the nodes left
+         * without any, falling back to a single node holding every CPU
+         * the process may run on
+         */
+        void keepAllowed();
+
+        /**
+         * Get the number of nodes
+         *
+         * @return number of nodes
+         */
+        int size() const;
+
+        /**
+         * Parse a CPU list in the kernel format, like "0-3,8,10-11"
+         *
+         * @param text list to parse
+         * @param list CPUs in the list, in order
+         *
+         * @return false if the list is malformed
+         */
+        static bool parseCpuList(const std::string& text,
+                                 std::vector<int>& list);
+};
+#endif
@@ -0,0 +1,372 @@
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "OutputBuffer.h"
+
+//----------------------------------------------------------------------------
+OutputBuffer::OutputBuffer(int fd, size_t capacity)
+{
+    this->fd = fd;
+    this->capacity = (capacity < 1024) ? 1024 : capacity;
+    this->buffer.resize(this->capacity);
+    this->used = 0;
+    this->failed = false;
+    this->ring = nullptr;
+    this->depth = 1;
+    this->cur = 0;
+    this->offset = 0;
+    this->headerDone = false;
+    this->layout = LINE;
+    this->content = SOLUTION;
+}
+
+//----------------------------------------------------------------------------
+OutputBuffer::~OutputBuffer()
+{
+    this->flush();
+    this->stopUring();
+}
+
+//----------------------------------------------------------------------------
+char* OutputBuffer::active()
+{
+    return this->buffer.data() + this->cur * this->capacity;
+}
+
+//----------------------------------------------------------------------------
+char* OutputBuffer::reserve(size_t n)
+{
+    if(this->used + n > this->capacity)
+    {
+        if(this->ring != nullptr && n <= this->capacity)
+            this->submitActive();
+        else
+            this->flush();
+
+        // a single append bigger than the buffer grows it for good
+        if(n > this->capacity)
+        {
+            this->stopUring();
+            this->capacity = n;
+            this->buffer.resize(n);
+        }
+    }
+
+    char* out = this->active() + this->used;
+    this->used += n;
+
+    return out;
+}
+
+//----------------------------------------------------------------------------
+void OutputBuffer::append(const char* data, size_t len)
+{
+    std::memcpy(this->reserve(len), data, len);
+}
+
+//----------------------------------------------------------------------------
+void OutputBuffer::appendLine(const Board& b)
+{
+    char* out = this->reserve(82);
+
+    b.writeLine(out);
+    out[81] = '\n';
+}
+
+//----------------------------------------------------------------------------
+void OutputBuffer::appendPretty(const Board& b)
+{
+    char* out = this->reserve(Board::PRETTY_SIZE);
+
+    // give back what the layout did not use
+    this->used -= Board::PRETTY_SIZE - b.writePretty(out);
+}
+
+//----------------------------------------------------------------------------
+void OutputBuffer::writeResult(const Board& puzzle, const Board& solution)
+{
+    if(this->layout == LINE)
+    {
+        if(this->content == PUZZLE_SOLUTION)
+        {
+            char* out = this->reserve(82);
+            puzzle.writeLine(out);
+            out[81] = ',';
+        }
+
+        this->appendLine(solution);
+    }
+    else
+    {
+        if(this->content == PUZZLE_SOLUTION)
+        {
+            this->appendPretty(puzzle);
+            this->append("\n", 1);
+        }
+
+        this->appendPretty(solution);
+        this->append("\n", 1);
+    }
+}
+
+//----------------------------------------------------------------------------
+void OutputBuffer::appendNumber(unsigned long long val)
+{
+    char digits[20];
+    int n = 0;
+
+    // digits come out backwards
+    do
+    {
+        digits[n++] = static_cast<char>('0' + val % 10);
+        val /= 10;
+    } while(val > 0);
+
+    char* out = this->reserve(n);
+    for(int i = 0; i < n; i++)
+        out[i] = digits[n - 1 - i];
+}
+
+//----------------------------------------------------------------------------
+void OutputBuffer::writeRecord(unsigned long long id, const Board& puzzle,
+                               const Board& solution, const SolveStats& stats)
+{
+    const char* status = SolveStats::statusName(stats.status);
+
+    if(this->layout == JSONL)
+    {
+        this->appendText("{\"id\":");
+        this->appendNumber(id);
+        this->appendText(",\"input\":\"");
+        puzzle.writeLine(this->reserve(81));
+        this->appendText("\",\"solution\":\"");
+        solution.writeLine(this->reserve(81));
+        this->appendText("\",\"status\":\"");
+        this->append(status, std::strlen(status));
+        this->appendText("\",\"placements\":");
+        this->appendNumber(stats.placements);
+        this->appendText(",\"search_nodes\":");
+        this->appendNumber(stats.searchNodes);
+        this->appendText(",\"strategies\":{\"block\":");
+        this->appendNumber(stats.blockSingles);
+        this->appendText(",\"row\":");
+        this->appendNumber(stats.rowSingles);
+        this->appendText(",\"col\":");
+        this->appendNumber(stats.colSingles);
+        this->appendText("},\"solve_ns\":");
+        this->appendNumber(stats.nanos);
+        this->appendText("}\n");
+    }
+    else if(this->layout == CSV)
+    {
+        if(!this->headerDone)
+        {
+            static const char header[] =
+                "id,input,solution,status,placements,search_nodes,"
+                "block_singles,row_singles,col_singles,solve_ns\n";
+
+            this->append(header, sizeof(header) - 1);
+            this->headerDone = true;
+        }
+
+        this->appendNumber(id);
+        this->appendText(",");
+        puzzle.writeLine(this->reserve(81));
+        this->appendText(",");
+        solution.writeLine(this->reserve(81));
+        this->appendText(",");
+        this->append(status, std::strlen(status));
+        this->appendText(",");
+        this->appendNumber(stats.placements);
+        this->appendText(",");
+        this->appendNumber(stats.searchNodes);
+        this->appendText(",");
+        this->appendNumber(stats.blockSingles);
+        this->appendText(",");
+        this->appendNumber(stats.rowSingles);
+        this->appendText(",");
+        this->appendNumber(stats.colSingles);
+        this->appendText(",");
+        this->appendNumber(stats.nanos);
+        this->appendText("\n");
+    }
+    else
+        this->writeResult(puzzle, solution);
+}
+
+//----------------------------------------------------------------------------
+bool OutputBuffer::flush()
+{
+    if(this->ring != nullptr)
+    {
+        this->submitActive();
+
+        for(int i = 0; i < this->depth; i++)
+            while(this->pending[i] > 0)
+                this->reap();
+
+        // leave the file position after everything written
+        lseek(this->fd, this->offset, SEEK_SET);
+
+        return !this->failed;
+    }
+
+    size_t done = 0;
+
+    while(done < this->used && !this->failed)
+    {
+        ssize_t n = ::write(this->fd, this->buffer.data() + done,
+                            this->used - done);
+
+        if(n < 0)
+        {
+            if(errno == EINTR)
+                continue;
+
+            this->failed = true;
+        }
+        else
+            done += n;
+    }
+
+    this->used = 0;
+
+    return !this->failed;
+}
+
+//----------------------------------------------------------------------------
+bool OutputBuffer::useUring(int depth)
+{
+    struct stat st;
+
+    if(this->ring != nullptr || depth < 2 || fstat(this->fd, &st) != 0 ||
+       !S_ISREG(st.st_mode))
+        return false;
+
+    this->flush();
+
+    off_t pos = lseek(this->fd, 0, SEEK_CUR);
+    if(pos < 0)
+        return false;
+
+    this->buffer.resize(this->capacity * depth);
+
+    std::vector<struct iovec> bufs(depth);
+    for(int i = 0; i < depth; i++)
+    {
+        bufs[i].iov_base = this->buffer.data() + i * this->capacity;
+        bufs[i].iov_len = this->capacity;
+    }
+
+    Uring* r = new Uring();
+    if(!r->init(depth) || !r->registerBuffers(bufs.data(), depth))
+    {
+        delete r;
+        this->buffer.resize(this->capacity);
+        return false;
+    }
+
+    this->ring = r;
+    this->depth = depth;
+    this->cur = 0;
+    this->offset = pos;
+    this->pending.assign(depth, 0);
+    this->pendingAt.assign(depth, 0);
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+void OutputBuffer::submitActive()
+{
+    if(this->used == 0)
+        return;
+
+    if(!this->ring->queueWrite(this->fd, this->cur, this->active(),
+                               this->used, this->offset, this->cur))
+    {
+        this->failed = true;
+        this->used = 0;
+        return;
+    }
+
+    this->pending[this->cur] = this->used;
+    this->pendingAt[this->cur] = this->offset;
+    this->offset += this->used;
+    this->ring->submit();
+
+    // the next buffer may still be on its way to the file
+    this->cur = (this->cur + 1) % this->depth;
+    this->used = 0;
+
+    while(this->pending[this->cur] > 0)
+        this->reap();
+}
+
+//----------------------------------------------------------------------------
+void OutputBuffer::reap()
+{
+    unsigned long long idx;
+    int res;
+
+    if(!this->ring->wait(idx, res))
+    {
+        // nothing more will complete, give up on everything in flight
+        this->failed = true;
+        this->pending.assign(this->depth, 0);
+        return;
+    }
+
+    size_t want = this->pending[idx];
+    size_t done = (res < 0) ? 0 : res;
+
+    if(res < 0)
+        this->failed = true;
+
+    // finish a short write by hand
+    while(!this->failed && done < want)
+    {
+        ssize_t n = pwrite(this->fd,
+                           this->buffer.data() + idx * this->capacity + done,
+                           want - done, this->pendingAt[idx] + done);
+        if(n < 0)
+        {
+            if(errno == EINTR)
+                continue;
+
+            this->failed = true;
+        }
+        else
+            done += n;
+    }
+
+    this->pending[idx] = 0;
+}
+
+//----------------------------------------------------------------------------
+void OutputBuffer::stopUring()
+{
+    if(this->ring == nullptr)
+        return;
+
+    for(int i = 0; i < this->depth; i++)
+        while(this->pending[i] > 0)
+            this->reap();
+
+    lseek(this->fd, this->offset, SEEK_SET);
+
+    // keep whatever is in the buffer being filled
+    if(this->cur != 0)
+        std::memmove(this->buffer.data(), this->active(), this->used);
+
+    delete this->ring;
+    this->ring = nullptr;
+    this->depth = 1;
+    this->cur = 0;
+    this->buffer.resize(this->capacity);
+}
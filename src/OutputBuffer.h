@@ -0,0 +1,190 @@
+#ifndef OUTPUTBUFFER_H_INCLUDED
+#define OUTPUTBUFFER_H_INCLUDED
+
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "Board.h"
+#include "SudokuSolver.h"
+#include "Uring.h"
+
+/**
+ * The OutputBuffer class formats results straight into a large reusable
+ * buffer and hands it to the file descriptor with a few large writes.
+ *
+ * Output to a regular file can also be written through io_uring, with
+ * several buffers in flight while the next one is being filled.
+ */
+class OutputBuffer
+{
+    private:
+        int fd;                     ///< Descriptor the buffer is written to
+        std::vector<char> buffer;   ///< Formatted output not yet written
+        size_t capacity;            ///< Bytes in the buffer being filled
+        size_t used;                ///< Number of bytes held in the buffer
+        bool failed;                ///< True once a write has failed
+
+        Uring* ring;                ///< Ring for async writes, null if unused
+        int depth;                  ///< Number of buffers, 1 without a ring
+        int cur;                    ///< Buffer being filled
+        off_t offset;               ///< File offset of the next write
+        std::vector<size_t> pending;    ///< Bytes in flight for each buffer
+        std::vector<off_t> pendingAt;   ///< File offset of each write
+        bool headerDone;            ///< True once the CSV header is written
+
+        /**
+         * Access the buffer being filled
+         *
+         * @return start of the buffer
+         */
+        char* active();
+
+        /**
+         * Queue the buffer being filled and move on to the next one
+         */
+        void submitActive();
+
+        /**
+         * Wait for one write to complete
+         */
+        void reap();
+
+        /**
+         * Wait for every write and stop using the ring
+         */
+        void stopUring();
+
+        /**
+         * Make room for a number of bytes, flushing if needed
+         *
+         * @param n number of bytes about to be appended
+         *
+         * @return pointer to where the bytes go
+         */
+        char* reserve(size_t n);
+
+    public:
+        /**
+         * Layout of each board written out
+         */
+        enum Layout
+        {
+            LINE,                   ///< 81 characters on one line
+            PRETTY,                 ///< Bordered grid used by Board::display
+            JSONL,                  ///< One JSON object per line
+            CSV                     ///< Comma separated, after a header line
+        };
+
+        /**
+         * Boards written out for each result
+         */
+        enum Content
+        {
+            SOLUTION,               ///< Only the solved board
+            PUZZLE_SOLUTION         ///< The puzzle followed by the solution
+        };
+
+        Layout layout;              ///< Layout used by writeResult()
+        Content content;            ///< Content used by writeResult()
+
+        /**
+         * Constructor
+         *
+         * @param fd descriptor to write to
+         * @param capacity size of the buffer, flushed when it would overflow
+         */
+        OutputBuffer(int fd = 1, size_t capacity = 1 << 20);
+
+        /**
+         * Destructor, writes out anything left in the buffer
+         */
+        ~OutputBuffer();
+
+        /**
+         * Append raw bytes
+         *
+         * @param data bytes to append
+         * @param len number of bytes
+         */
+        void append(const char* data, size_t len);
+
+        /**
+         * Append a board as a line of 81 characters and a newline
+         *
+         * @param b board to append
+         */
+        void appendLine(const Board& b);
+
+        /**
+         * Append a board in the bordered layout
+         *
+         * @param b board to append
+         */
+        void appendPretty(const Board& b);
+
+        /**
+         * Append one result in the chosen layout and content
+         * With LINE layout both boards share a line, separated by a comma.
+         * With PRETTY layout the boards are separated by a blank line.
+         *
+         * @param puzzle board as it was read
+         * @param solution board as the solver left it
+         */
+        void writeResult(const Board& puzzle, const Board& solution);
+
+        /**
+         * Append a string literal, without its terminator
+         *
+         * @param text literal to append
+         */
+        template <size_t N>
+        void appendText(const char (&text)[N])
+        {
+            this->append(text, N - 1);
+        }
+
+        /**
+         * Append an unsigned number in decimal
+         *
+         * @param val number to append
+         */
+        void appendNumber(unsigned long long val);
+
+        /**
+         * Append one result with its solve statistics
+         * JSONL and CSV layouts write every field of the record, the other
+         * layouts write the boards as writeResult() does.
+         *
+         * @param id number identifying the puzzle
+         * @param puzzle board as it was read
+         * @param solution board as the solver left it
+         * @param stats counts from the solve
+         */
+        void writeRecord(unsigned long long id, const Board& puzzle,
+                         const Board& solution, const SolveStats& stats);
+
+        /**
+         * Write everything in the buffer to the descriptor
+         *
+         * @return false if a write has failed
+         */
+        bool flush();
+
+        /**
+         * Write through io_uring with several buffers in flight
+         * Only regular files are written this way.
+         *
+         * @param depth number of buffers, at least 2
+         *
+         * @return false if the output stays with plain writes
+         */
+        bool useUring(int depth = 4);
+
+    private:
+        OutputBuffer(const OutputBuffer&);
+        OutputBuffer& operator=(const OutputBuffer&);
+};
+#endif
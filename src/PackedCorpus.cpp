@@ -0,0 +1,266 @@
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "PackedCorpus.h"
+
+static const char HEADER_MAGIC[8] = {'S', 'D', 'K', 'P', 'A', 'C', 'K', '1'};
+static const char FOOTER_MAGIC[8] = {'S', 'D', 'K', 'I', 'N', 'D', 'X', '1'};
+static const size_t HEADER_SIZE = 16;
+static const size_t FOOTER_SIZE = 24;
+static const unsigned FLAG_IDS = 1;
+
+/**
+ * Store an integer in little endian order
+ */
+static void putLE(unsigned char* out, unsigned long long val, int bytes)
+{
+    for(int i = 0; i < bytes; i++)
+        out[i] = static_cast<unsigned char>(val >> (8 * i));
+}
+
+/**
+ * Load an integer stored in little endian order
+ */
+static unsigned long long getLE(const unsigned char* in, int bytes)
+{
+    unsigned long long val = 0;
+
+    for(int i = 0; i < bytes; i++)
+        val |= static_cast<unsigned long long>(in[i]) << (8 * i);
+
+    return val;
+}
+
+//----------------------------------------------------------------------------
+PackedWriter::PackedWriter()
+{
+    this->out = nullptr;
+    this->fd = -1;
+    this->ownsFd = false;
+    this->withIds = false;
+    this->count = 0;
+}
+
+//----------------------------------------------------------------------------
+PackedWriter::~PackedWriter()
+{
+    this->close();
+}
+
+//----------------------------------------------------------------------------
+bool PackedWriter::open(const char* path, bool withIds)
+{
+    this->close();
+
+    if(std::strcmp(path, "-") == 0)
+        this->fd = 1;
+    else
+    {
+        this->fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(this->fd < 0)
+            return false;
+
+        this->ownsFd = true;
+    }
+
+    this->out = new OutputBuffer(this->fd);
+    this->withIds = withIds;
+    this->count = 0;
+
+    unsigned char header[HEADER_SIZE];
+    std::memcpy(header, HEADER_MAGIC, 8);
+    putLE(header + 8, withIds ? FLAG_IDS : 0, 4);
+    putLE(header + 12, (withIds ? 8 : 0) + Board::PACKED_SIZE + 1, 4);
+    this->out->append(reinterpret_cast<char*>(header), HEADER_SIZE);
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+void PackedWriter::write(const Board& b, unsigned char status,
+                         unsigned long long id)
+{
+    unsigned char rec[8 + Board::PACKED_SIZE + 1];
+    int n = 0;
+
+    if(this->withIds)
+    {
+        putLE(rec, id, 8);
+        n = 8;
+    }
+
+    b.writePacked(rec + n);
+    n += Board::PACKED_SIZE;
+    rec[n++] = status;
+
+    this->out->append(reinterpret_cast<char*>(rec), n);
+    this->count++;
+}
+
+//----------------------------------------------------------------------------
+bool PackedWriter::close()
+{
+    if(this->out == nullptr)
+        return true;
+
+    unsigned char footer[FOOTER_SIZE];
+    putLE(footer, this->count, 8);
+    putLE(footer + 8, HEADER_SIZE, 8);
+    std::memcpy(footer + 16, FOOTER_MAGIC, 8);
+    this->out->append(reinterpret_cast<char*>(footer), FOOTER_SIZE);
+
+    bool ok = this->out->flush();
+    delete this->out;
+    this->out = nullptr;
+
+    if(this->ownsFd && ::close(this->fd) != 0)
+        ok = false;
+
+    this->fd = -1;
+    this->ownsFd = false;
+
+    return ok;
+}
+
+//----------------------------------------------------------------------------
+PackedReader::PackedReader()
+{
+    this->map = nullptr;
+    this->mapLen = 0;
+    this->records = nullptr;
+    this->recordSize = 0;
+    this->numRecords = 0;
+    this->withIds = false;
+}
+
+//----------------------------------------------------------------------------
+PackedReader::~PackedReader()
+{
+    this->close();
+}
+
+//----------------------------------------------------------------------------
+bool PackedReader::open(const char* path)
+{
+    this->close();
+
+    int fd = ::open(path, O_RDONLY);
+    if(fd < 0)
+        return false;
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+       static_cast<size_t>(st.st_size) < HEADER_SIZE + FOOTER_SIZE)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    void* m = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if(m == MAP_FAILED)
+        return false;
+
+    this->map = static_cast<const unsigned char*>(m);
+    this->mapLen = st.st_size;
+
+    const unsigned char* footer = this->map + this->mapLen - FOOTER_SIZE;
+    unsigned flags = getLE(this->map + 8, 4);
+    size_t recSize = getLE(this->map + 12, 4);
+    unsigned long long n = getLE(footer, 8);
+    unsigned long long offset = getLE(footer + 8, 8);
+    size_t expected = (flags & FLAG_IDS ? 8 : 0) + Board::PACKED_SIZE + 1;
+
+    // the records have to fill the space between header and footer exactly
+    if(std::memcmp(this->map, HEADER_MAGIC, 8) != 0 ||
+       std::memcmp(footer + 16, FOOTER_MAGIC, 8) != 0 ||
+       recSize != expected || offset != HEADER_SIZE ||
+       n != (this->mapLen - HEADER_SIZE - FOOTER_SIZE) / recSize ||
+       n * recSize != this->mapLen - HEADER_SIZE - FOOTER_SIZE)
+    {
+        this->close();
+        return false;
+    }
+
+    this->records = this->map + offset;
+    this->recordSize = recSize;
+    this->numRecords = n;
+    this->withIds = (flags & FLAG_IDS) != 0;
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+void PackedReader::close()
+{
+    if(this->map != nullptr)
+        munmap(const_cast<unsigned char*>(this->map), this->mapLen);
+
+    this->map = nullptr;
+    this->mapLen = 0;
+    this->records = nullptr;
+    this->recordSize = 0;
+    this->numRecords = 0;
+    this->withIds = false;
+}
+
+//----------------------------------------------------------------------------
+unsigned long long PackedReader::size() const
+{
+    return this->numRecords;
+}
+
+//----------------------------------------------------------------------------
+bool PackedReader::hasIds() const
+{
+    return this->withIds;
+}
+
+//----------------------------------------------------------------------------
+bool PackedReader::read(unsigned long long n, Board& b, unsigned char* status,
+                        unsigned long long* id) const
+{
+    if(n >= this->numRecords)
+        return false;
+
+    const unsigned char* rec = this->records + n * this->recordSize;
+
+    if(id != nullptr)
+        *id = this->withIds ? getLE(rec, 8) : 0;
+
+    if(this->withIds)
+        rec += 8;
+
+    if(status != nullptr)
+        *status = rec[Board::PACKED_SIZE];
+
+    return b.readPacked(rec);
+}
+
+//----------------------------------------------------------------------------
+bool PackedReader::isPacked(const char* path)
+{
+    char magic[8];
+    struct stat st;
+
+    // a pipe read here would lose the records for whoever reads it next,
+    // and packed corpora are mapped, so only regular files are looked into
+    if(stat(path, &st) != 0 || !S_ISREG(st.st_mode))
+        return false;
+
+    int fd = ::open(path, O_RDONLY);
+    if(fd < 0)
+        return false;
+
+    bool packed = ::read(fd, magic, 8) == 8 &&
+                  std::memcmp(magic, HEADER_MAGIC, 8) == 0;
+    ::close(fd);
+
+    return packed;
+}
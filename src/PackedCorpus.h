@@ -0,0 +1,164 @@
+#ifndef PACKEDCORPUS_H_INCLUDED
+#define PACKEDCORPUS_H_INCLUDED
+
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+#include "Board.h"
+#include "OutputBuffer.h"
+
+/**
+ * \file
+ * Binary corpus of packed boards
+ *
+ * Layout of a packed corpus file, all integers little endian
+ *
+ *     header   8 byte magic "SDKPACK1", 4 byte flags, 4 byte record size
+ *     records  [8 byte id] 41 byte board, 1 byte status
+ *     footer   8 byte record count, 8 byte offset of the first record,
+ *              8 byte magic "SDKINDX1"
+ *
+ * The id is only present when bit 0 of the flags is set. Every record has
+ * the same size, so the footer is all the index that is needed to seek to
+ * any record in constant time and to split a corpus into record ranges.
+ */
+
+/**
+ * The PackedWriter class writes boards out as a packed corpus.
+ */
+class PackedWriter
+{
+    private:
+        OutputBuffer* out;          ///< Buffer in front of the file
+        int fd;                     ///< File being written, -1 if closed
+        bool ownsFd;                ///< True if the file is closed by us
+        bool withIds;               ///< True if records carry an id
+        unsigned long long count;   ///< Number of records written
+
+    public:
+        /**
+         * Default Constructor
+         */
+        PackedWriter();
+
+        /**
+         * Destructor, finishes the file if it is still open
+         */
+        ~PackedWriter();
+
+        /**
+         * Create a file and write the header
+         *
+         * @param path file to create, "-" for standard output
+         * @param withIds true if every record carries a 64 bit id
+         *
+         * @return true if the file was created
+         */
+        bool open(const char* path, bool withIds);
+
+        /**
+         * Append a record
+         *
+         * @param b board to store
+         * @param status status byte stored with the board
+         * @param id id of the record, dropped if the file has no ids
+         */
+        void write(const Board& b, unsigned char status = 0,
+                   unsigned long long id = 0);
+
+        /**
+         * Write the footer and close the file
+         *
+         * @return false if any write failed
+         */
+        bool close();
+
+    private:
+        PackedWriter(const PackedWriter&);
+        PackedWriter& operator=(const PackedWriter&);
+};
+
+/**
+ * The PackedReader class maps a packed corpus and reads any record in
+ * constant time, without scanning the records before it.
+ */
+class PackedReader
+{
+    private:
+        const unsigned char* map;       ///< Start of the mapped file
+        size_t mapLen;                  ///< Length of the mapping
+        const unsigned char* records;   ///< Start of the first record
+        size_t recordSize;              ///< Bytes in each record
+        unsigned long long numRecords;  ///< Number of records in the file
+        bool withIds;                   ///< True if records carry an id
+
+    public:
+        /**
+         * Default Constructor
+         */
+        PackedReader();
+
+        /**
+         * Destructor, releases the mapping
+         */
+        ~PackedReader();
+
+        /**
+         * Map a packed corpus and check its header and footer
+         *
+         * @param path file to open
+         *
+         * @return true if the file is a valid packed corpus
+         */
+        bool open(const char* path);
+
+        /**
+         * Release the mapping
+         */
+        void close();
+
+        /**
+         * Access the number of records
+         *
+         * @return number of records in the corpus
+         */
+        unsigned long long size() const;
+
+        /**
+         * Determine whether the records carry ids
+         *
+         * @return true if every record has a 64 bit id
+         */
+        bool hasIds() const;
+
+        /**
+         * Read a single record
+         *
+         * @param n index of the record
+         * @param b board to read into
+         * @param status set to the status byte, if not null
+         * @param id set to the id of the record, 0 if there are none
+         *
+         * @return false if n is out of range or the record is malformed
+         */
+        bool read(unsigned long long n, Board& b,
+                  unsigned char* status = nullptr,
+                  unsigned long long* id = nullptr) const;
+
+        /**
+         * Determine whether a file starts like a packed corpus
+         * Only regular files are read, pipes and other special files are
+         * never packed.
+         *
+         * @param path file to check
+         *
+         * @return true if the file begins with the packed magic
+         */
+        static bool isPacked(const char* path);
+
+    private:
+        PackedReader(const PackedReader&);
+        PackedReader& operator=(const PackedReader&);
+};
+#endif
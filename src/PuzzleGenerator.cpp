@@ -0,0 +1,279 @@
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <thread>
+
+#include "PuzzleGenerator.h"
+#include "ThreadPool.h"
+
+/**
+ * Spread a number over all 64 bits, the splitmix64 finaliser
+ */
+static unsigned long long mix(unsigned long long x)
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+
+    return x ^ (x >> 31);
+}
+
+/**
+ * Numbers on the board by row, column and block, a bit for each
+ */
+struct Used
+{
+    int rows[9];
+    int cols[9];
+    int blocks[9];
+
+    /**
+     * Mark or unmark a number in a space
+     */
+    void flip(int cell, int val)
+    {
+        int bit = 1 << val;
+
+        this->rows[cell / 9] ^= bit;
+        this->cols[cell % 9] ^= bit;
+        this->blocks[(cell / 27) * 3 + (cell % 9) / 3] ^= bit;
+    }
+
+    /**
+     * Get the numbers seen from a space
+     */
+    int seen(int cell) const
+    {
+        return this->rows[cell / 9] | this->cols[cell % 9] |
+               this->blocks[(cell / 27) * 3 + (cell % 9) / 3];
+    }
+};
+
+/**
+ * Check whether the clues left force a number into an empty space, as the
+ * only number that fits there, or the only space in its row, column or
+ * block where it fits
+ * A forced number can be taken away without adding a solution, so the
+ * uniqueness check can be skipped.
+ *
+ * @param left clues left, -1 for empty spaces
+ * @param used numbers of the clues left
+ * @param cell empty space
+ * @param val number the space held
+ */
+static bool forced(const int* left, const Used& used, int cell, int val)
+{
+    static const int ALL = 0x3fe;
+    int bit = 1 << val;
+
+    if((used.seen(cell) | bit) == ALL)
+        return true;
+
+    int r = cell / 9;
+    int c = cell % 9;
+    int b = (r / 3) * 3 + c / 3;
+    bool row = true;
+    bool col = true;
+    bool block = true;
+
+    for(int i = 0; i < 9; i++)
+    {
+        int inRow = r * 9 + i;
+        int inCol = i * 9 + c;
+        int inBlock = ((b / 3) * 3 + i / 3) * 9 + (b % 3) * 3 + i % 3;
+
+        if(inRow != cell && left[inRow] == -1 && !(used.seen(inRow) & bit))
+            row = false;
+        if(inCol != cell && left[inCol] == -1 && !(used.seen(inCol) & bit))
+            col = false;
+        if(inBlock != cell && left[inBlock] == -1 &&
+           !(used.seen(inBlock) & bit))
+            block = false;
+    }
+
+    return row || col || block;
+}
+
+/**
+ * Check whether a puzzle made from a full grid has a solution other than
+ * the grid, one where an empty space holds another number than it did
+ * This tells the same as counting solutions up to 2, but it never goes
+ * looking for the grid again, and most other numbers are ruled out by the
+ * first cross checks.
+ *
+ * @param solver solver set to search, without a budget
+ * @param left clues of the puzzle, -1 for empty spaces
+ * @param used numbers of the clues
+ * @param cell empty space
+ * @param val number the space held in the grid
+ */
+static bool another(SudokuSolver& solver, int* left, const Used& used,
+                    int cell, int val)
+{
+    int fits = ~used.seen(cell) & ~(1 << val);
+    bool found = false;
+
+    for(int i = 1; i < 10 && !found; i++)
+    {
+        if(!(fits & (1 << i)))
+            continue;
+
+        left[cell] = i;
+        solver.board.loadCells(left);
+        found = solver.solveDriver();
+    }
+
+    left[cell] = -1;
+
+    return found;
+}
+
+//----------------------------------------------------------------------------
+PuzzleGenerator::PuzzleGenerator()
+{
+    this->seconds = 0;
+    this->seed = 1;
+    this->threads = 0;
+    this->count = 0;
+    this->clues = 0;
+}
+
+//----------------------------------------------------------------------------
+void PuzzleGenerator::generate(unsigned long long index, Board& puzzle,
+                               Board& solution, SolveStats& stats) const
+{
+    thread_local SudokuSolver solver;
+
+    std::mt19937_64 rng(mix(this->seed ^ mix(index)));
+
+    int grid[81];
+    int digits[9] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+    std::fill(grid, grid + 81, -1);
+
+    // the blocks on the diagonal share no row or column, so any numbers
+    // in them can be finished into a full grid
+    for(int b = 0; b < 9; b += 4)
+    {
+        std::shuffle(digits, digits + 9, rng);
+
+        for(int i = 0; i < 9; i++)
+            grid[((b / 3) * 3 + i / 3) * 9 + (b % 3) * 3 + i % 3] = digits[i];
+    }
+
+    solver.board.loadCells(grid);
+    solver.budget = 0;
+    solver.search = true;
+    solver.solveDriver();
+    solver.board.saveCells(grid);
+
+    int order[81];
+    int left[81];
+
+    for(int i = 0; i < 81; i++)
+        order[i] = i;
+    std::shuffle(order, order + 81, rng);
+    std::copy(grid, grid + 81, left);
+
+    Used used;
+    std::fill(used.rows, used.rows + 9, 0);
+    std::fill(used.cols, used.cols + 9, 0);
+    std::fill(used.blocks, used.blocks + 9, 0);
+    for(int cell = 0; cell < 81; cell++)
+        used.flip(cell, grid[cell]);
+
+    // a clue that has to stay now has to stay with fewer clues around it,
+    // so every clue is only tried once
+    for(int i = 0; i < 81; i++)
+    {
+        int cell = order[i];
+        int val = left[cell];
+        left[cell] = -1;
+        used.flip(cell, val);
+
+        if(forced(left, used, cell, val))
+            continue;
+
+        if(another(solver, left, used, cell, val))
+        {
+            left[cell] = val;
+            used.flip(cell, val);
+        }
+    }
+
+    puzzle.loadCells(left);
+    solution.loadCells(grid);
+
+    solver.board = puzzle;
+    solver.solveDriver();
+    stats = solver.stats;
+}
+
+//----------------------------------------------------------------------------
+bool PuzzleGenerator::run(long long n, OutputBuffer& out)
+{
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+
+    int workers = this->threads;
+    if(workers <= 0)
+        workers = std::max(1u, std::thread::hardware_concurrency());
+
+    size_t round = static_cast<size_t>(ROUND) * workers;
+    std::vector<Board> puzzles(round);
+    std::vector<Board> solutions(round);
+    std::vector<SolveStats> stats(round);
+
+    // the puzzle is the result, its solution only written when asked for
+    bool both = out.layout == OutputBuffer::JSONL ||
+                out.layout == OutputBuffer::CSV ||
+                out.content == OutputBuffer::PUZZLE_SOLUTION;
+    bool ok = true;
+
+    this->count = 0;
+    this->clues = 0;
+
+    for(long long first = 0; first < n && ok; first += round)
+    {
+        size_t m = std::min<long long>(round, n - first);
+
+        ThreadPool::shared().parallelFor(0, m, 1,
+                                         [&](size_t s, size_t e)
+        {
+            for(size_t i = s; i < e; i++)
+                this->generate(first + i, puzzles[i], solutions[i],
+                               stats[i]);
+        }, workers);
+
+        for(size_t i = 0; i < m; i++)
+        {
+            out.writeRecord(first + i + 1, puzzles[i],
+                            both ? solutions[i] : puzzles[i], stats[i]);
+            this->clues += puzzles[i].getFilled();
+        }
+
+        this->count += m;
+        ok = out.flush();
+    }
+
+    this->seconds = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start).count();
+
+    return ok;
+}
+
+//----------------------------------------------------------------------------
+void PuzzleGenerator::summary(std::ostream& outs) const
+{
+    double rate = 0;
+    double average = 0;
+
+    if(this->seconds > 0)
+        rate = this->count / this->seconds;
+
+    if(this->count > 0)
+        average = static_cast<double>(this->clues) / this->count;
+
+    outs << this->count << " unique puzzles, " << average
+         << " clues on average, in " << this->seconds << " s ("
+         << static_cast<long long>(rate) << " puzzles/s)\n";
+}
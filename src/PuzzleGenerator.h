@@ -0,0 +1,81 @@
+#ifndef PUZZLEGENERATOR_H_INCLUDED
+#define PUZZLEGENERATOR_H_INCLUDED
+
+#include <iostream>
+#include <vector>
+
+#include "Board.h"
+#include "OutputBuffer.h"
+#include "SudokuSolver.h"
+
+/**
+ * The PuzzleGenerator class makes puzzles with a unique solution. Each
+ * puzzle starts from a random full grid, found by filling the three
+ * blocks on the diagonal with random numbers and solving the rest with
+ * search. Its clues are then taken away in random order, and a clue stays
+ * gone only if the puzzle still has a single solution. A clue that the
+ * clues left still force, as the only number that fits its space or the
+ * only space for its number in a row, column or block, goes without a
+ * check. Otherwise the puzzle is solved once for each other number that
+ * fits the space, and the clue stays gone if none of them leads to a
+ * solution. The puzzles come out minimal: no clue left can be taken away
+ * without losing uniqueness.
+ *
+ * Every puzzle is made from its own random stream, seeded by the seed and
+ * its position, so the puzzles depend only on the seed and never on how
+ * many threads made them.
+ */
+class PuzzleGenerator
+{
+    private:
+        double seconds;             ///< Time spent in the last run
+
+        static const int ROUND = 64;    ///< Puzzles made per thread before
+                                        ///< writing them out
+
+    public:
+        unsigned long long seed;    ///< Seed of the whole run
+        int threads;                ///< Threads to make puzzles on, 0 for
+                                    ///< one per core
+        long long count;            ///< Puzzles made by the last run
+        long long clues;            ///< Clues left in all of them
+
+        /**
+         * Default Constructor, seed 1 and one thread per core
+         */
+        PuzzleGenerator();
+
+        /**
+         * Make one puzzle
+         * Safe to call from several threads at once.
+         *
+         * @param index position of the puzzle in the run
+         * @param puzzle set to the puzzle
+         * @param solution set to its solution
+         * @param stats set to the counts of solving the puzzle with search
+         */
+        void generate(unsigned long long index, Board& puzzle,
+                      Board& solution, SolveStats& stats) const;
+
+        /**
+         * Make puzzles on the shared pool and write them out in order
+         * LINE and PRETTY layouts write the puzzle, followed by its
+         * solution with the PUZZLE_SOLUTION content. JSONL and CSV
+         * layouts write both, with the counts of solving the puzzle.
+         * Puzzles are numbered from 1.
+         *
+         * @param n number of puzzles to make
+         * @param out buffer for the puzzles, flushed after every round
+         *
+         * @return false if writing out failed
+         */
+        bool run(long long n, OutputBuffer& out);
+
+        /**
+         * Print the counts and throughput of the last run
+         *
+         * @param outs output stream
+         */
+        void summary(std::ostream& outs) const;
+};
+#endif
@@ -0,0 +1,506 @@
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "PuzzleReader.h"
+
+//----------------------------------------------------------------------------
+PuzzleReader::PuzzleReader(size_t bufSize)
+{
+    this->fd = -1;
+    this->ownsFd = false;
+    this->map = nullptr;
+    this->mapLen = 0;
+    this->pos = 0;
+    this->buffer.resize(bufSize);
+    this->bufStart = 0;
+    this->bufEnd = 0;
+    this->eof = false;
+    this->skipping = false;
+    this->ring = nullptr;
+    this->async = false;
+    this->chunkSize = bufSize;
+    this->depth = 0;
+    this->fileSize = 0;
+    this->chunk = 0;
+    this->chunkPos = 0;
+    this->carryOut = false;
+    this->badChunk = ~0ULL;
+    this->failed = false;
+}
+
+//----------------------------------------------------------------------------
+PuzzleReader::~PuzzleReader()
+{
+    this->close();
+}
+
+//----------------------------------------------------------------------------
+bool PuzzleReader::open(const char* path)
+{
+    if(std::strcmp(path, "-") == 0)
+        return this->openFd(0);
+
+    this->close();
+
+    this->fd = ::open(path, O_RDONLY);
+    if(this->fd < 0)
+        return false;
+
+    this->ownsFd = true;
+
+    return this->prepare();
+}
+
+//----------------------------------------------------------------------------
+bool PuzzleReader::openFd(int fd)
+{
+    this->close();
+
+    this->fd = fd;
+    this->ownsFd = false;
+
+    return this->prepare();
+}
+
+//----------------------------------------------------------------------------
+bool PuzzleReader::prepare()
+{
+    struct stat st;
+
+    this->pos = 0;
+    this->buffer.resize(this->chunkSize);
+    this->bufStart = 0;
+    this->bufEnd = 0;
+    this->eof = false;
+    this->skipping = false;
+    this->failed = false;
+
+    if(fstat(this->fd, &st) != 0)
+        return false;
+
+    // pipes, terminals, and empty files go through the buffer
+    if(!S_ISREG(st.st_mode) || st.st_size == 0)
+        return true;
+
+    void* m = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, this->fd, 0);
+    if(m == MAP_FAILED)
+        return true;
+
+    // records are only ever visited once, front to back
+    madvise(m, st.st_size, MADV_SEQUENTIAL);
+
+    this->map = static_cast<const char*>(m);
+    this->mapLen = st.st_size;
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+bool PuzzleReader::openAsync(const char* path, int depth)
+{
+    // standard input is read through the buffer, as by open()
+    if(std::strcmp(path, "-") == 0)
+        return this->openFd(0);
+
+    this->close();
+
+    this->fd = ::open(path, O_RDONLY);
+    if(this->fd < 0)
+        return false;
+
+    this->ownsFd = true;
+
+    struct stat st;
+    if(fstat(this->fd, &st) != 0)
+        return false;
+
+    if(!S_ISREG(st.st_mode) || depth < 1)
+        return this->prepare();
+
+    this->async = true;
+    this->depth = depth;
+    this->fileSize = st.st_size;
+    this->buffer.resize(this->chunkSize * depth);
+    this->chunkLen.assign(depth, 0);
+    this->chunk = 0;
+    this->chunkPos = 0;
+    this->carry.clear();
+    this->carryOut = false;
+    this->badChunk = ~0ULL;
+    this->failed = false;
+
+    // every chunk buffer is registered so the kernel can skip mapping
+    // the pages on every read, without a ring chunks are read with pread
+    std::vector<struct iovec> bufs(depth);
+    for(int i = 0; i < depth; i++)
+    {
+        bufs[i].iov_base = this->buffer.data() + i * this->chunkSize;
+        bufs[i].iov_len = this->chunkSize;
+    }
+
+    this->ring = new Uring();
+    if(!this->ring->init(depth) ||
+       !this->ring->registerBuffers(bufs.data(), depth))
+    {
+        delete this->ring;
+        this->ring = nullptr;
+    }
+
+    posix_fadvise(this->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    for(int k = 0; k < depth; k++)
+        this->startChunk(k);
+
+    if(this->ring != nullptr)
+        this->ring->submit();
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+void PuzzleReader::close()
+{
+    // the kernel may still be writing into the chunk buffers
+    if(this->ring != nullptr)
+    {
+        for(int i = 0; i < this->depth; i++)
+        {
+            unsigned long long k;
+            int res;
+
+            while(this->chunkLen[i] < 0 && this->ring->wait(k, res))
+                this->chunkLen[k % this->depth] = 0;
+        }
+
+        delete this->ring;
+        this->ring = nullptr;
+    }
+
+    this->async = false;
+
+    if(this->map != nullptr)
+        munmap(const_cast<char*>(this->map), this->mapLen);
+
+    if(this->ownsFd && this->fd >= 0)
+        ::close(this->fd);
+
+    this->fd = -1;
+    this->ownsFd = false;
+    this->map = nullptr;
+    this->mapLen = 0;
+}
+
+//----------------------------------------------------------------------------
+bool PuzzleReader::isMapped() const
+{
+    return this->map != nullptr;
+}
+
+//----------------------------------------------------------------------------
+bool PuzzleReader::usesUring() const
+{
+    return this->ring != nullptr;
+}
+
+//----------------------------------------------------------------------------
+bool PuzzleReader::isAsync() const
+{
+    return this->async;
+}
+
+//----------------------------------------------------------------------------
+bool PuzzleReader::hasFailed() const
+{
+    return this->failed;
+}
+
+//----------------------------------------------------------------------------
+bool PuzzleReader::next(const char*& rec, int& len)
+{
+    if(this->async)
+        return this->nextAsync(rec, len);
+
+    if(this->map == nullptr)
+        return this->nextBuffered(rec, len);
+
+    if(this->pos >= this->mapLen)
+        return false;
+
+    const char* start = this->map + this->pos;
+    size_t left = this->mapLen - this->pos;
+    const char* nl = static_cast<const char*>(std::memchr(start, '\n', left));
+
+    // the last line need not end with a newline
+    size_t n = (nl == nullptr) ? left : nl - start;
+
+    rec = start;
+    len = n;
+    this->pos += n + 1;
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+bool PuzzleReader::nextBuffered(const char*& rec, int& len)
+{
+    if(this->fd < 0)
+        return false;
+
+    char* buf = this->buffer.data();
+    size_t cap = this->buffer.size();
+
+    while(true)
+    {
+        size_t left = this->bufEnd - this->bufStart;
+        char* start = buf + this->bufStart;
+        char* nl = static_cast<char*>(std::memchr(start, '\n', left));
+
+        if(nl != nullptr)
+        {
+            size_t n = nl - start;
+            this->bufStart += n + 1;
+
+            // the tail of an overlong line is dropped
+            if(this->skipping)
+            {
+                this->skipping = false;
+                continue;
+            }
+
+            rec = start;
+            len = n;
+            return true;
+        }
+
+        if(this->eof)
+        {
+            this->bufStart = this->bufEnd;
+
+            if(left == 0 || this->skipping)
+                return false;
+
+            rec = start;
+            len = left;
+            return true;
+        }
+
+        // a line that fills the whole buffer can not be a puzzle, hand it
+        // back as is and drop the rest of it
+        if(left == cap)
+        {
+            if(this->skipping)
+            {
+                this->bufStart = this->bufEnd;
+                continue;
+            }
+
+            rec = start;
+            len = left;
+            this->bufStart = this->bufEnd;
+            this->skipping = true;
+            return true;
+        }
+
+        // move the partial line to the front and read more behind it
+        if(this->bufStart > 0)
+        {
+            std::memmove(buf, start, left);
+            this->bufStart = 0;
+            this->bufEnd = left;
+        }
+
+        ssize_t got = ::read(this->fd, buf + this->bufEnd, cap - this->bufEnd);
+
+        if(got < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            this->failed = true;
+            got = 0;
+        }
+
+        if(got == 0)
+            this->eof = true;
+        else
+            this->bufEnd += got;
+    }
+}
+
+//----------------------------------------------------------------------------
+char* PuzzleReader::chunkBuffer(unsigned long long k)
+{
+    return this->buffer.data() + (k % this->depth) * this->chunkSize;
+}
+
+//----------------------------------------------------------------------------
+void PuzzleReader::startChunk(unsigned long long k)
+{
+    int idx = k % this->depth;
+    off_t offset = k * this->chunkSize;
+
+    if(offset >= this->fileSize)
+    {
+        this->chunkLen[idx] = 0;
+        return;
+    }
+
+    size_t len = this->fileSize - offset;
+    if(len > this->chunkSize)
+        len = this->chunkSize;
+
+    if(this->ring != nullptr &&
+       this->ring->queueRead(this->fd, idx, this->chunkBuffer(k), len,
+                             offset, k))
+    {
+        this->chunkLen[idx] = -1;
+        return;
+    }
+
+    this->chunkLen[idx] = this->readChunk(k, 0);
+}
+
+//----------------------------------------------------------------------------
+void PuzzleReader::awaitChunk(unsigned long long k)
+{
+    int idx = k % this->depth;
+
+    while(this->chunkLen[idx] < 0)
+    {
+        unsigned long long done;
+        int res;
+
+        // without the ring the chunk is read again by hand, which puts
+        // the same bytes in its buffer should the kernel still finish it
+        if(!this->ring->wait(done, res))
+        {
+            this->chunkLen[idx] = this->readChunk(k, 0);
+            break;
+        }
+
+        // finish a short read by hand, and redo a failed one
+        this->chunkLen[done % this->depth] =
+            this->readChunk(done, (res < 0) ? 0 : res);
+    }
+}
+
+//----------------------------------------------------------------------------
+long PuzzleReader::readChunk(unsigned long long k, size_t got)
+{
+    char* buf = this->chunkBuffer(k);
+    off_t offset = k * this->chunkSize;
+    size_t want = this->fileSize - offset;
+    if(want > this->chunkSize)
+        want = this->chunkSize;
+
+    while(got < want)
+    {
+        ssize_t n = pread(this->fd, buf + got, want - got, offset + got);
+
+        if(n < 0)
+        {
+            if(errno == EINTR)
+                continue;
+
+            if(k < this->badChunk)
+                this->badChunk = k;
+            return 0;
+        }
+
+        // the file got shorter since it was opened
+        if(n == 0)
+            break;
+
+        got += n;
+    }
+
+    return got;
+}
+
+//----------------------------------------------------------------------------
+bool PuzzleReader::nextAsync(const char*& rec, int& len)
+{
+    // a line handed out from the carry is done with now
+    if(this->carryOut)
+    {
+        this->carry.clear();
+        this->carryOut = false;
+    }
+
+    while(true)
+    {
+        if(static_cast<off_t>(this->chunk * this->chunkSize) >=
+           this->fileSize)
+        {
+            // the last line need not end with a newline
+            if(this->carry.empty())
+                return false;
+
+            rec = this->carry.data();
+            len = this->carry.size();
+            this->carryOut = true;
+            return true;
+        }
+
+        this->awaitChunk(this->chunk);
+
+        // records stop where the file could not be read
+        if(this->chunk >= this->badChunk)
+        {
+            this->failed = true;
+            return false;
+        }
+
+        char* buf = this->chunkBuffer(this->chunk);
+        size_t n = this->chunkLen[this->chunk % this->depth];
+
+        if(this->chunkPos < n)
+        {
+            char* start = buf + this->chunkPos;
+            size_t left = n - this->chunkPos;
+            char* nl = static_cast<char*>(std::memchr(start, '\n', left));
+            size_t lineLen = (nl == nullptr) ? left : nl - start;
+
+            // a line split across chunks is pieced together in the carry,
+            // an overlong line is cut off at the size of a chunk
+            if(nl == nullptr || !this->carry.empty())
+            {
+                size_t room = this->chunkSize - this->carry.size();
+                this->carry.insert(this->carry.end(), start,
+                                   start + (lineLen < room ? lineLen : room));
+            }
+
+            if(nl != nullptr)
+            {
+                this->chunkPos += lineLen + 1;
+
+                if(this->carry.empty())
+                {
+                    rec = start;
+                    len = lineLen;
+                }
+                else
+                {
+                    rec = this->carry.data();
+                    len = this->carry.size();
+                    this->carryOut = true;
+                }
+
+                return true;
+            }
+        }
+
+        // the chunk is used up, read the next one into its buffer
+        this->startChunk(this->chunk + this->depth);
+        if(this->ring != nullptr)
+            this->ring->submit();
+
+        this->chunk++;
+        this->chunkPos = 0;
+    }
+}
@@ -0,0 +1,205 @@
+#ifndef PUZZLEREADER_H_INCLUDED
+#define PUZZLEREADER_H_INCLUDED
+
+#include <cstddef>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "Uring.h"
+
+/**
+ * The PuzzleReader class splits an input file into records, one per line,
+ * without copying them. Regular files are memory mapped and records point
+ * straight into the mapping. Pipes and terminals are read through a
+ * buffer instead.
+ *
+ * Files opened with openAsync() are instead read ahead in large chunks,
+ * several at a time, through io_uring on registered buffers, or pread()
+ * when io_uring is not available. Records point into the chunk buffers.
+ */
+class PuzzleReader
+{
+    private:
+        int fd;                     ///< File being read, -1 if closed
+        bool ownsFd;                ///< True if the file is closed by us
+
+        const char* map;            ///< Start of the mapped file
+        size_t mapLen;              ///< Length of the mapping
+        size_t pos;                 ///< Offset of the next record
+
+        std::vector<char> buffer;   ///< Buffer for unmappable input
+        size_t bufStart;            ///< Start of the unread data
+        size_t bufEnd;              ///< End of the unread data
+        bool eof;                   ///< True once read() returns nothing
+        bool skipping;              ///< True while dropping an overlong line
+
+        Uring* ring;                ///< Ring for chunk reads, null if unused
+        bool async;                 ///< True when reading ahead in chunks
+        size_t chunkSize;           ///< Bytes in each chunk buffer
+        int depth;                  ///< Number of chunk buffers
+        off_t fileSize;             ///< Size of the file read in chunks
+        std::vector<long> chunkLen; ///< Bytes in each buffer, -1 in flight
+        unsigned long long chunk;   ///< Chunk holding the next record
+        size_t chunkPos;            ///< Offset of the next record in it
+        std::vector<char> carry;    ///< Line spanning two chunks
+        bool carryOut;              ///< True if carry was handed out
+        unsigned long long badChunk;    ///< First chunk that could not be
+                                        ///< read
+        bool failed;                ///< True once a read has failed
+
+        /**
+         * Set up reading for an open file descriptor
+         *
+         * @return true if the input could be prepared
+         */
+        bool prepare();
+
+        /**
+         * Fetch the next record when reading through the buffer
+         *
+         * @param rec set to the start of the record
+         * @param len set to the length of the record
+         *
+         * @return false when the input is exhausted
+         */
+        bool nextBuffered(const char*& rec, int& len);
+
+        /**
+         * Fetch the next record when reading ahead in chunks
+         *
+         * @param rec set to the start of the record
+         * @param len set to the length of the record
+         *
+         * @return false when the input is exhausted
+         */
+        bool nextAsync(const char*& rec, int& len);
+
+        /**
+         * Start reading a chunk into its buffer
+         *
+         * @param k index of the chunk in the file
+         */
+        void startChunk(unsigned long long k);
+
+        /**
+         * Wait until a chunk has been read
+         *
+         * @param k index of the chunk in the file
+         */
+        void awaitChunk(unsigned long long k);
+
+        /**
+         * Read the rest of a chunk with blocking reads
+         *
+         * @param k index of the chunk in the file
+         * @param got bytes of the chunk already in its buffer
+         *
+         * @return bytes of the chunk in its buffer, 0 if a read failed
+         */
+        long readChunk(unsigned long long k, size_t got);
+
+        /**
+         * Access the buffer of a chunk
+         *
+         * @param k index of the chunk in the file
+         *
+         * @return start of the buffer the chunk is read into
+         */
+        char* chunkBuffer(unsigned long long k);
+
+    public:
+        /**
+         * Default Constructor
+         *
+         * @param bufSize size of the buffer used for unmappable input
+         */
+        PuzzleReader(size_t bufSize = 1 << 20);
+
+        /**
+         * Destructor, closes the input
+         */
+        ~PuzzleReader();
+
+        /**
+         * Open a file for reading
+         *
+         * @param path file to open, "-" for standard input
+         *
+         * @return true if the file was opened
+         */
+        bool open(const char* path);
+
+        /**
+         * Read from a descriptor that is already open
+         * The descriptor is left open when the reader is closed.
+         *
+         * @param fd descriptor to read from
+         *
+         * @return true if the input could be prepared
+         */
+        bool openFd(int fd);
+
+        /**
+         * Open a file for reading ahead in chunks
+         * Standard input and files that are not regular files are read
+         * like open() would.
+         *
+         * @param path file to open, "-" for standard input
+         * @param depth number of chunks read ahead at once
+         *
+         * @return true if the file was opened
+         */
+        bool openAsync(const char* path, int depth = 4);
+
+        /**
+         * Release the mapping and close the input
+         */
+        void close();
+
+        /**
+         * Determine whether the input is memory mapped
+         *
+         * @return true if records point into a mapping of the file
+         */
+        bool isMapped() const;
+
+        /**
+         * Determine whether chunks are read through io_uring
+         *
+         * @return true if an io_uring instance is reading the chunks
+         */
+        bool usesUring() const;
+
+        /**
+         * Determine whether the input is read ahead in chunks
+         *
+         * @return true if openAsync() opened a regular file
+         */
+        bool isAsync() const;
+
+        /**
+         * Determine whether reading the input failed
+         * Records stop at the failed read, so a run that ends early can be
+         * told apart from one that reached the end of the input.
+         *
+         * @return true if a read failed since the input was opened
+         */
+        bool hasFailed() const;
+
+        /**
+         * Fetch the next record, without its newline
+         * The record stays valid until the next call.
+         *
+         * @param rec set to the start of the record
+         * @param len set to the length of the record
+         *
+         * @return false when the input is exhausted
+         */
+        bool next(const char*& rec, int& len);
+
+    private:
+        PuzzleReader(const PuzzleReader&);
+        PuzzleReader& operator=(const PuzzleReader&);
+};
+#endif
@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "ResultCache.h"
+
+const size_t ResultCache::ENTRY_BYTES = sizeof(Entry) + 48;
+
+//----------------------------------------------------------------------------
+ResultCache::ResultCache(size_t bytes, int shards)
+{
+    this->numShards = std::max(shards, 1);
+    this->shards.reset(new Shard[this->numShards]);
+
+    size_t total = bytes / ENTRY_BYTES;
+
+    for(int i = 0; i < this->numShards; i++)
+    {
+        Shard& s = this->shards[i];
+        s.capacity = total / this->numShards +
+                     (static_cast<size_t>(i) < total % this->numShards);
+        s.hand = 0;
+        s.hits = 0;
+        s.misses = 0;
+        s.evictions = 0;
+        s.index.reserve(s.capacity);
+    }
+}
+
+//----------------------------------------------------------------------------
+ResultCache::Shard& ResultCache::shardOf(const Key& key) const
+{
+    // the low bits pick the bucket within the shard
+    return this->shards[(key.hash >> 40) % this->numShards];
+}
+
+//----------------------------------------------------------------------------
+void ResultCache::makeKey(const Board& b, bool search, Key& key)
+{
+    b.writePacked(key.board);
+    key.search = search;
+
+    // FNV-1a, then mixed so every bit of the board reaches the top bits
+    unsigned long long h = 14695981039346656037ULL;
+    for(int i = 0; i < Board::PACKED_SIZE; i++)
+        h = (h ^ key.board[i]) * 1099511628211ULL;
+    h = (h ^ search) * 1099511628211ULL;
+
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+
+    key.hash = h;
+}
+
+//----------------------------------------------------------------------------
+bool ResultCache::find(const Key& key, Board& solution, SolveStats& stats)
+{
+    Shard& s = this->shardOf(key);
+    unsigned char packed[Board::PACKED_SIZE];
+
+    {
+        std::lock_guard<std::mutex> guard(s.lock);
+        std::unordered_map<unsigned long long, size_t>::const_iterator it =
+            s.index.find(key.hash);
+
+        if(it == s.index.end())
+        {
+            s.misses++;
+            return false;
+        }
+
+        Entry& e = s.slots[it->second];
+
+        if(e.key.search != key.search ||
+           std::memcmp(e.key.board, key.board, Board::PACKED_SIZE) != 0)
+        {
+            s.misses++;
+            return false;
+        }
+
+        e.referenced = true;
+        s.hits++;
+
+        std::memcpy(packed, e.solution, Board::PACKED_SIZE);
+        stats = e.stats;
+    }
+
+    solution.readPacked(packed);
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+void ResultCache::insert(const Key& key, const Board& solution,
+                         const SolveStats& stats)
+{
+    Shard& s = this->shardOf(key);
+
+    if(s.capacity == 0)
+        return;
+
+    unsigned char packed[Board::PACKED_SIZE];
+    solution.writePacked(packed);
+
+    std::lock_guard<std::mutex> guard(s.lock);
+    std::unordered_map<unsigned long long, size_t>::const_iterator it =
+        s.index.find(key.hash);
+    size_t slot;
+
+    if(it != s.index.end())
+    {
+        // the same board again, or another with the same hash
+        slot = it->second;
+    }
+    else if(s.slots.size() < s.capacity)
+    {
+        slot = s.slots.size();
+        s.slots.push_back(Entry());
+    }
+    else
+    {
+        // sweep the clock past entries found since it last came by
+        while(s.slots[s.hand].referenced)
+        {
+            s.slots[s.hand].referenced = false;
+            s.hand = (s.hand + 1) % s.capacity;
+        }
+
+        slot = s.hand;
+        s.hand = (s.hand + 1) % s.capacity;
+        s.index.erase(s.slots[slot].key.hash);
+        s.evictions++;
+    }
+
+    Entry& e = s.slots[slot];
+    e.key = key;
+    std::memcpy(e.solution, packed, Board::PACKED_SIZE);
+    e.stats = stats;
+    e.referenced = false;
+    s.index[key.hash] = slot;
+}
+
+//----------------------------------------------------------------------------
+bool ResultCache::solve(SudokuSolver& solver)
+{
+    return this->solve(solver, [](SudokuSolver& s) -> bool
+    {
+        return s.solveDriver();
+    });
+}
+
+//----------------------------------------------------------------------------
+bool ResultCache::solve(SudokuSolver& solver,
+                        const std::function<bool(SudokuSolver&)>& miss)
+{
+    if(solver.budget > 0)
+        return miss(solver);
+
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+
+    Key key;
+    makeKey(solver.board, solver.search, key);
+
+    if(this->find(key, solver.board, solver.stats))
+    {
+        solver.unsolvable = solver.stats.status == CONTRADICTION;
+        solver.stats.nanos =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+
+        return solver.stats.status == SOLVED;
+    }
+
+    miss(solver);
+
+    if(solver.stats.status != BUDGET)
+        this->insert(key, solver.board, solver.stats);
+
+    return solver.stats.status == SOLVED;
+}
+
+//----------------------------------------------------------------------------
+long long ResultCache::hits() const
+{
+    long long total = 0;
+
+    for(int i = 0; i < this->numShards; i++)
+    {
+        std::lock_guard<std::mutex> guard(this->shards[i].lock);
+        total += this->shards[i].hits;
+    }
+
+    return total;
+}
+
+//----------------------------------------------------------------------------
+long long ResultCache::misses() const
+{
+    long long total = 0;
+
+    for(int i = 0; i < this->numShards; i++)
+    {
+        std::lock_guard<std::mutex> guard(this->shards[i].lock);
+        total += this->shards[i].misses;
+    }
+
+    return total;
+}
+
+//----------------------------------------------------------------------------
+long long ResultCache::evictions() const
+{
+    long long total = 0;
+
+    for(int i = 0; i < this->numShards; i++)
+    {
+        std::lock_guard<std::mutex> guard(this->shards[i].lock);
+        total += this->shards[i].evictions;
+    }
+
+    return total;
+}
+
+//----------------------------------------------------------------------------
+size_t ResultCache::size() const
+{
+    size_t total = 0;
+
+    for(int i = 0; i < this->numShards; i++)
+    {
+        std::lock_guard<std::mutex> guard(this->shards[i].lock);
+        total += this->shards[i].slots.size();
+    }
+
+    return total;
+}
+
+//----------------------------------------------------------------------------
+size_t ResultCache::capacity() const
+{
+    size_t total = 0;
+
+    for(int i = 0; i < this->numShards; i++)
+        total += this->shards[i].capacity;
+
+    return total;
+}
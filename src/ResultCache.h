@@ -0,0 +1,181 @@
+#ifndef RESULTCACHE_H_INCLUDED
+#define RESULTCACHE_H_INCLUDED
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "SudokuSolver.h"
+
+/**
+ * The ResultCache class remembers the results of solves within a fixed
+ * number of bytes, so a board that was solved before is answered without
+ * solving it again.
+ *
+ * Boards are found by a 64 bit hash of the board and the search flag, and
+ * the packed board is kept to tell boards that share a hash apart. The
+ * entries are split over shards, each with its own lock, picked by the
+ * hash. When a shard is full the CLOCK policy chooses what to drop: every
+ * entry has a bit set when it is found, and the hand sweeping the shard
+ * clears set bits and evicts the first entry whose bit is already clear,
+ * so entries that are asked for again outlive ones seen only once.
+ */
+class ResultCache
+{
+    public:
+        /**
+         * What a board is found by
+         */
+        struct Key
+        {
+            unsigned long long hash;                    ///< Hash of the rest
+            unsigned char board[Board::PACKED_SIZE];    ///< Packed board
+            bool search;                                ///< Solver guesses
+        };
+
+    private:
+        /**
+         * A solve remembered
+         */
+        struct Entry
+        {
+            Key key;                                    ///< Board solved
+            unsigned char solution[Board::PACKED_SIZE]; ///< Board left
+            SolveStats stats;                           ///< Counts from it
+            bool referenced;                            ///< Found since the
+                                                        ///< hand went by
+        };
+
+        /**
+         * A share of the entries behind one lock
+         */
+        struct Shard
+        {
+            std::mutex lock;                ///< Guards the rest
+            std::unordered_map<unsigned long long, size_t> index;   ///< Slot
+                                                                    ///< by hash
+            std::vector<Entry> slots;       ///< Entries, grown to capacity
+            size_t capacity;                ///< Most entries kept
+            size_t hand;                    ///< Next slot the clock visits
+            long long hits;                 ///< Boards found
+            long long misses;               ///< Boards not found
+            long long evictions;            ///< Entries dropped for room
+        };
+
+        std::unique_ptr<Shard[]> shards;    ///< Shards of the cache
+        int numShards;                      ///< Number of shards
+
+        /**
+         * Pick the shard a key belongs to
+         */
+        Shard& shardOf(const Key& key) const;
+
+    public:
+        static const size_t ENTRY_BYTES;    ///< Bytes an entry costs,
+                                            ///< including its index
+
+        /**
+         * Constructor
+         *
+         * @param bytes memory the entries may take, 0 to keep none
+         * @param shards number of shards, more let more threads in at once
+         */
+        ResultCache(size_t bytes, int shards = 16);
+
+        /**
+         * Work out the key of a board
+         * The hash is also what SolutionStore files are laid out by, so it
+         * cannot change without making existing stores unreadable.
+         *
+         * @param b board to look for
+         * @param search true if the solver guesses
+         * @param key key of the board
+         */
+        static void makeKey(const Board& b, bool search, Key& key);
+
+        /**
+         * Look for the result of a board
+         *
+         * @param key key of the board
+         * @param solution board the solver left, set on a hit
+         * @param stats counts from the solve, set on a hit
+         *
+         * @return true if the board was found
+         */
+        bool find(const Key& key, Board& solution, SolveStats& stats);
+
+        /**
+         * Remember the result of a board, dropping another to make room
+         * if its shard is full
+         *
+         * @param key key of the board
+         * @param solution board the solver left
+         * @param stats counts from the solve
+         */
+        void insert(const Key& key, const Board& solution,
+                    const SolveStats& stats);
+
+        /**
+         * Solve the solver's board, from the cache if it was solved before
+         * On a hit the board and stats are as the solver would leave them,
+         * except that the time is that of the lookup. Solves with a budget
+         * bypass the cache, since their result depends on the budget.
+         *
+         * @param solver solver holding the board, left holding the result
+         *
+         * @return true if the board is solved
+         */
+        bool solve(SudokuSolver& solver);
+
+        /**
+         * Solve the solver's board, from the cache if it was solved before
+         * and otherwise with another function, such as a second cache
+         *
+         * @param solver solver holding the board, left holding the result
+         * @param miss solves boards that are not found, returning true if
+         *        the board is solved
+         *
+         * @return true if the board is solved
+         */
+        bool solve(SudokuSolver& solver,
+                   const std::function<bool(SudokuSolver&)>& miss);
+
+        /**
+         * Get the number of lookups that found their board
+         *
+         * @return number of hits
+         */
+        long long hits() const;
+
+        /**
+         * Get the number of lookups that did not
+         *
+         * @return number of misses
+         */
+        long long misses() const;
+
+        /**
+         * Get the number of entries dropped to make room
+         *
+         * @return number of evictions
+         */
+        long long evictions() const;
+
+        /**
+         * Get the number of entries held
+         *
+         * @return number of entries
+         */
+        size_t size() const;
+
+        /**
+         * Get the most entries the cache holds
+         *
+         * @return most entries
+         */
+        size_t capacity() const;
+};
+#endif
@@ -0,0 +1,401 @@
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "PackedCorpus.h"
+#include "PuzzleReader.h"
+#include "ShardRunner.h"
+
+/**
+ * Write a whole file under a temporary name, sync it, and rename it into
+ * place, so the file is either missing or complete
+ */
+static bool writeAtomically(const std::string& path, const std::string& text)
+{
+    std::string temp = path + ".tmp";
+    int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0)
+        return false;
+
+    bool ok = ::write(fd, text.data(), text.size()) ==
+                  static_cast<ssize_t>(text.size()) &&
+              fsync(fd) == 0;
+    ::close(fd);
+
+    return ok && rename(temp.c_str(), path.c_str()) == 0;
+}
+
+//----------------------------------------------------------------------------
+ShardRunner::ShardRunner()
+{
+    this->seconds = 0;
+    this->shards = 1;
+    this->resume = false;
+    this->uring = false;
+}
+
+//----------------------------------------------------------------------------
+std::string ShardRunner::partPath(int k, const char* ext) const
+{
+    return this->dir + "/shard-" + std::to_string(k) + "." + ext;
+}
+
+//----------------------------------------------------------------------------
+bool ShardRunner::checkPlan(const std::string& plan)
+{
+    std::string path = this->dir + "/plan";
+
+    if(this->resume)
+    {
+        std::ifstream in(path.c_str());
+        std::stringstream old;
+        old << in.rdbuf();
+
+        if(in.is_open())
+        {
+            if(old.str() == plan)
+                return true;
+
+            std::cerr << this->dir << " holds shards of another run"
+                      << std::endl;
+            return false;
+        }
+    }
+
+    // markers left by an earlier plan no longer apply
+    for(int k = 0; ; k++)
+    {
+        bool out = std::remove(this->partPath(k, "out").c_str()) == 0;
+        bool done = std::remove(this->partPath(k, "done").c_str()) == 0;
+
+        if(!out && !done && k >= this->shards)
+            break;
+    }
+
+    return writeAtomically(path, plan);
+}
+
+//----------------------------------------------------------------------------
+bool ShardRunner::readDone(int k)
+{
+    std::ifstream in(this->partPath(k, "done").c_str());
+    Shard& s = this->parts[k];
+
+    return static_cast<bool>(in >> s.count >> s.solved >> s.malformed
+                                >> s.seconds);
+}
+
+//----------------------------------------------------------------------------
+int ShardRunner::runShard(int k, const char* path, bool packed,
+                          BatchRunner& runner, const OutputBuffer& out)
+{
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+
+    std::string results = this->partPath(k, "out");
+    std::string temp = results + ".tmp";
+    const Shard& s = this->parts[k];
+
+    int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0)
+        return 1;
+
+    bool ok;
+    {
+        OutputBuffer buf(fd);
+        buf.layout = out.layout;
+        buf.content = out.content;
+
+        if(this->uring)
+            buf.useUring();
+
+        if(packed)
+        {
+            PackedReader in;
+            ok = in.open(path);
+            if(ok)
+                runner.run(in, s.first, s.last, buf);
+        }
+        else
+        {
+            PuzzleReader in;
+            ok = this->uring ? in.openAsync(path) : in.open(path);
+            if(ok)
+                runner.run(in, s.first, s.last, buf);
+
+            // a shard cut short by a failed read is not done
+            ok = ok && !in.hasFailed();
+        }
+
+        ok = ok && buf.flush();
+    }
+
+    ok = ok && fsync(fd) == 0;
+    ::close(fd);
+
+    if(!ok || rename(temp.c_str(), results.c_str()) != 0)
+        return 1;
+
+    double secs = std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - start).count();
+
+    std::ostringstream done;
+    done << runner.count << " " << runner.solved << " " << runner.malformed
+         << " " << secs << "\n";
+
+    return writeAtomically(this->partPath(k, "done"), done.str()) ? 0 : 1;
+}
+
+//----------------------------------------------------------------------------
+bool ShardRunner::merge(OutputBuffer& out)
+{
+    std::vector<char> buf(1 << 20);
+    bool csvHeader = false;
+
+    for(int k = 0; k < this->shards; k++)
+    {
+        std::string results = this->partPath(k, "out");
+        int fd = ::open(results.c_str(), O_RDONLY);
+        if(fd < 0)
+            return false;
+
+        // every shard starts its CSV output with the header
+        bool skipLine = out.layout == OutputBuffer::CSV && csvHeader;
+        ssize_t n;
+
+        while((n = ::read(fd, buf.data(), buf.size())) != 0)
+        {
+            if(n < 0 && errno == EINTR)
+                continue;
+
+            if(n < 0)
+            {
+                ::close(fd);
+                return false;
+            }
+
+            const char* data = buf.data();
+            csvHeader = true;
+
+            if(skipLine)
+            {
+                const char* nl = static_cast<const char*>(
+                    std::memchr(data, '\n', n));
+                size_t skip = nl ? nl - data + 1 : n;
+
+                skipLine = nl == nullptr;
+                data += skip;
+                n -= skip;
+            }
+
+            out.append(data, n);
+        }
+
+        ::close(fd);
+    }
+
+    if(!out.flush())
+        return false;
+
+    for(int k = 0; k < this->shards; k++)
+    {
+        std::remove(this->partPath(k, "out").c_str());
+        std::remove(this->partPath(k, "done").c_str());
+    }
+
+    std::remove((this->dir + "/plan").c_str());
+    rmdir(this->dir.c_str());
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+bool ShardRunner::run(const char* path, BatchRunner& runner,
+                      OutputBuffer& out)
+{
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+
+    // workers read the input again, so it has to be a file
+    struct stat st;
+    if(std::strcmp(path, "-") == 0 || stat(path, &st) != 0 ||
+       !S_ISREG(st.st_mode))
+    {
+        std::cerr << "Sharded runs need an input file" << std::endl;
+        return false;
+    }
+
+    bool packed = PackedReader::isPacked(path);
+    unsigned long long n = 0;
+
+    if(packed)
+    {
+        PackedReader in;
+
+        if(!in.open(path))
+        {
+            std::cerr << path << " is not a valid packed corpus" << std::endl;
+            return false;
+        }
+
+        n = in.size();
+    }
+    else
+    {
+        PuzzleReader in;
+        const char* rec;
+        int len;
+
+        if(!in.open(path))
+        {
+            std::cerr << "Unable to open " << path << std::endl;
+            return false;
+        }
+
+        while(in.next(rec, len))
+            n++;
+    }
+
+    if(this->shards < 1)
+        this->shards = 1;
+
+    if(this->dir.empty())
+        this->dir = std::string(path) + ".shards";
+
+    if(mkdir(this->dir.c_str(), 0755) != 0 && errno != EEXIST)
+    {
+        std::cerr << "Unable to create " << this->dir << std::endl;
+        return false;
+    }
+
+    std::ostringstream plan;
+    plan << "input " << path << "\n"
+         << "bytes " << st.st_size << "\n"
+         << "modified " << st.st_mtime << "\n"
+         << "records " << n << "\n"
+         << "shards " << this->shards << "\n"
+         << "layout " << out.layout << " " << out.content << "\n";
+
+    if(!this->checkPlan(plan.str()))
+        return false;
+
+    this->parts.assign(this->shards, Shard());
+    std::vector<pid_t> workers(this->shards, -1);
+
+    std::cout.flush();
+    std::cerr.flush();
+
+    for(int k = 0; k < this->shards; k++)
+    {
+        Shard& s = this->parts[k];
+        s.first = n * k / this->shards;
+        s.last = n * (k + 1) / this->shards;
+        s.resumed = this->resume && this->readDone(k);
+
+        if(s.resumed)
+            continue;
+
+        workers[k] = fork();
+
+        if(workers[k] == 0)
+            _exit(this->runShard(k, path, packed, runner, out));
+
+        if(workers[k] < 0)
+            std::cerr << "Unable to start shard " << k << std::endl;
+    }
+
+    bool failed = false;
+
+    for(int k = 0; k < this->shards; k++)
+    {
+        int status = 0;
+
+        if(this->parts[k].resumed)
+            continue;
+
+        if(workers[k] > 0)
+            while(waitpid(workers[k], &status, 0) < 0 && errno == EINTR)
+                ;
+
+        if(workers[k] < 0 || !WIFEXITED(status) ||
+           WEXITSTATUS(status) != 0 || !this->readDone(k))
+        {
+            std::cerr << "shard " << k << " failed";
+            if(workers[k] > 0 && WIFSIGNALED(status))
+                std::cerr << " (signal " << WTERMSIG(status) << ")";
+            std::cerr << std::endl;
+
+            failed = true;
+        }
+    }
+
+    if(failed)
+    {
+        std::cerr << "run again with --resume to redo the failed shards"
+                  << std::endl;
+        return false;
+    }
+
+    if(!this->merge(out))
+    {
+        std::cerr << "Unable to join the shards in " << this->dir
+                  << std::endl;
+        return false;
+    }
+
+    this->seconds = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start).count();
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+void ShardRunner::summary(std::ostream& outs) const
+{
+    long long count = 0;
+    long long solved = 0;
+    long long malformed = 0;
+
+    for(size_t k = 0; k < this->parts.size(); k++)
+    {
+        count += this->parts[k].count;
+        solved += this->parts[k].solved;
+        malformed += this->parts[k].malformed;
+    }
+
+    double rate = 0;
+
+    if(this->seconds > 0)
+        rate = count / this->seconds;
+
+    outs << count << " puzzles, "
+         << solved << " solved, "
+         << count - solved << " unsolved, "
+         << malformed << " malformed in "
+         << this->seconds << " s ("
+         << static_cast<long long>(rate) << " puzzles/s)\n";
+
+    for(size_t k = 0; k < this->parts.size(); k++)
+    {
+        const Shard& s = this->parts[k];
+        rate = 0;
+
+        if(s.seconds > 0)
+            rate = s.count / s.seconds;
+
+        outs << "  shard " << k << ": " << s.count << " puzzles";
+
+        if(s.resumed)
+            outs << " (resumed)\n";
+        else
+            outs << " (" << static_cast<long long>(rate) << " puzzles/s)\n";
+    }
+}
@@ -0,0 +1,137 @@
+#ifndef SHARDRUNNER_H_INCLUDED
+#define SHARDRUNNER_H_INCLUDED
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "BatchRunner.h"
+#include "OutputBuffer.h"
+
+/**
+ * The ShardRunner class splits a batch over several worker processes.
+ * Each worker takes a consecutive range of the input, records of a packed
+ * corpus or lines of a text file, solves it with its own copy of a
+ * BatchRunner, and writes the results to a file of its own in the shard
+ * directory. Once every worker has finished, the files are joined in
+ * input order, so the output is the same as a run in a single process.
+ *
+ * A worker that crashes does not stop the others. Every worker that
+ * finishes leaves a done marker next to its results, and a run with
+ * resume set only starts workers for the shards that have none, as long
+ * as the input, the number of shards, and the output layout have not
+ * changed since the shards were planned.
+ */
+class ShardRunner
+{
+    private:
+        /**
+         * How one shard of the input went
+         */
+        struct Shard
+        {
+            unsigned long long first;   ///< Records or lines before it
+            unsigned long long last;    ///< Records or lines up to its end
+            bool resumed;               ///< True if done by an earlier run
+            long long count;            ///< Number of puzzles read
+            long long solved;           ///< Number of puzzles solved
+            long long malformed;        ///< Number of records skipped
+            double seconds;             ///< Time the worker took
+        };
+
+        std::vector<Shard> parts;   ///< Shards of the last run
+        double seconds;             ///< Time spent in the last run
+
+        /**
+         * Name a file of the shard directory
+         *
+         * @param k shard the file belongs to
+         * @param ext kind of file, "out" or "done"
+         *
+         * @return path of the file
+         */
+        std::string partPath(int k, const char* ext) const;
+
+        /**
+         * Write the plan of the shards, or check it against the one an
+         * earlier run wrote when resuming
+         *
+         * @param plan description of the input, shards, and layout
+         *
+         * @return false if the plan could not be written, or differs from
+         *         the earlier one
+         */
+        bool checkPlan(const std::string& plan);
+
+        /**
+         * Read the done marker of a shard
+         *
+         * @param k shard to check
+         *
+         * @return true if the shard finished and its counts were read
+         */
+        bool readDone(int k);
+
+        /**
+         * Solve one shard and leave its results and done marker, in the
+         * worker process
+         *
+         * @param k shard to solve
+         * @param path input file
+         * @param packed true if the input is a packed corpus
+         * @param runner runner set up with the batch options
+         * @param out buffer whose layout the results are written in
+         *
+         * @return exit status of the worker
+         */
+        int runShard(int k, const char* path, bool packed,
+                     BatchRunner& runner, const OutputBuffer& out);
+
+        /**
+         * Join the results of every shard in input order and remove the
+         * shard directory
+         *
+         * @param out buffer for the results
+         *
+         * @return false if a shard file could not be read
+         */
+        bool merge(OutputBuffer& out);
+
+    public:
+        int shards;                 ///< Number of worker processes
+        bool resume;                ///< Keep the shards already done
+        bool uring;                 ///< Read and write every shard through
+                                    ///< io_uring
+        std::string dir;            ///< Shard directory, the input path
+                                    ///< with ".shards" added if empty
+
+        /**
+         * Default Constructor
+         */
+        ShardRunner();
+
+        /**
+         * Solve a file on several worker processes
+         * Workers are forked from the calling process, which must not
+         * have started any threads yet if the runner is to use the shared
+         * ThreadPool, as forked workers only keep the calling thread.
+         *
+         * @param path input file, a packed corpus or puzzles one per line
+         * @param runner runner set up with the batch options, used by
+         *        every worker
+         * @param out buffer for the results, flushed at the end
+         *
+         * @return false if the input could not be read or a shard
+         *         failed, in which case nothing is written to out
+         */
+        bool run(const char* path, BatchRunner& runner, OutputBuffer& out);
+
+        /**
+         * Print the counts and throughput of the last run and of each
+         * shard
+         *
+         * @param outs output stream
+         */
+        void summary(std::ostream& outs) const;
+};
+#endif
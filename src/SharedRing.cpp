@@ -0,0 +1,392 @@
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "SharedRing.h"
+
+static const char MAGIC[8] = {'S', 'D', 'K', 'R', 'I', 'N', 'G', '1'};
+static const unsigned BYTE_ORDER_MARK = 0x01020304;
+static const size_t HEADER_SIZE = 4096;
+static const size_t CONTROL_OFFSET = 64;
+static const size_t MIN_SLOTS = 16;
+static const size_t MAX_SLOTS = 1 << 20;
+
+/**
+ * Checks made before going to sleep, when not polling
+ */
+static const int SPIN_LIMIT = 256;
+
+/**
+ * Checks between giving up the core while polling, a power of two
+ */
+static const int YIELD_EVERY = 256;
+
+static_assert(sizeof(RingRequest) == 64, "request slots are 64 bytes");
+static_assert(sizeof(RingResult) == 128, "result slots are 128 bytes");
+static_assert(CONTROL_OFFSET + 2 * sizeof(SharedRing::Control) <= HEADER_SIZE,
+              "control blocks fit in the header");
+
+typedef std::chrono::steady_clock Clock;
+
+/**
+ * Let a spinning core breathe between checks
+ */
+static inline void relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+/**
+ * Sleep while a futex word holds a value, across processes
+ */
+static void futexWait(std::atomic<unsigned>* word, unsigned val, long nanos)
+{
+    timespec ts;
+    ts.tv_sec = nanos / 1000000000;
+    ts.tv_nsec = nanos % 1000000000;
+
+    syscall(SYS_futex, reinterpret_cast<unsigned*>(word), FUTEX_WAIT, val,
+            &ts, nullptr, 0);
+}
+
+/**
+ * Wake everything sleeping on a futex word
+ */
+static void futexWake(std::atomic<unsigned>* word)
+{
+    syscall(SYS_futex, reinterpret_cast<unsigned*>(word), FUTEX_WAKE,
+            INT_MAX, nullptr, nullptr, 0);
+}
+
+//----------------------------------------------------------------------------
+SharedRing::SharedRing()
+{
+    this->ctrl = nullptr;
+    this->slots = nullptr;
+    this->slotSize = 0;
+    this->mask = 0;
+}
+
+//----------------------------------------------------------------------------
+void SharedRing::attach(Control* ctrl, unsigned char* slots, size_t slotSize,
+                        size_t count)
+{
+    this->ctrl = ctrl;
+    this->slots = slots;
+    this->slotSize = slotSize;
+    this->mask = count - 1;
+}
+
+//----------------------------------------------------------------------------
+void* SharedRing::claim(size_t i)
+{
+    unsigned long long head = this->ctrl->head.load(std::memory_order_relaxed);
+    unsigned long long tail = this->ctrl->tail.load(std::memory_order_acquire);
+
+    if(head + i - tail > this->mask)
+        return nullptr;
+
+    return this->slots + ((head + i) & this->mask) * this->slotSize;
+}
+
+//----------------------------------------------------------------------------
+void SharedRing::publish(size_t n)
+{
+    unsigned long long head = this->ctrl->head.load(std::memory_order_relaxed);
+    this->ctrl->head.store(head + n, std::memory_order_release);
+
+    this->wakeOther();
+}
+
+//----------------------------------------------------------------------------
+size_t SharedRing::available() const
+{
+    return this->ctrl->head.load(std::memory_order_acquire) -
+           this->ctrl->tail.load(std::memory_order_relaxed);
+}
+
+//----------------------------------------------------------------------------
+void* SharedRing::at(size_t i)
+{
+    unsigned long long tail = this->ctrl->tail.load(std::memory_order_relaxed);
+
+    return this->slots + ((tail + i) & this->mask) * this->slotSize;
+}
+
+//----------------------------------------------------------------------------
+void SharedRing::release(size_t n)
+{
+    unsigned long long tail = this->ctrl->tail.load(std::memory_order_relaxed);
+    this->ctrl->tail.store(tail + n, std::memory_order_release);
+
+    this->wakeOther();
+}
+
+//----------------------------------------------------------------------------
+size_t SharedRing::size() const
+{
+    return this->mask + 1;
+}
+
+//----------------------------------------------------------------------------
+void SharedRing::wakeOther()
+{
+    // the index store must be seen before sleeping is checked, pairing
+    // with the fence in waitFor(), or both sides could miss each other
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if(this->ctrl->sleeping.load(std::memory_order_relaxed) > 0)
+    {
+        this->ctrl->wake.fetch_add(1);
+        futexWake(&this->ctrl->wake);
+    }
+}
+
+//----------------------------------------------------------------------------
+template <typename Ready>
+bool SharedRing::waitFor(Ready ready, bool poll, int timeoutMs)
+{
+    Clock::time_point end = Clock::now() + std::chrono::milliseconds(timeoutMs);
+
+    for(int spins = 0; ; spins++)
+    {
+        if(ready())
+            return true;
+
+        if(poll || spins < SPIN_LIMIT)
+        {
+            relax();
+
+            // a poller sharing its core with the other side lets it run
+            if((spins & (YIELD_EVERY - 1)) == YIELD_EVERY - 1)
+            {
+                std::this_thread::yield();
+
+                if(Clock::now() >= end)
+                    return false;
+            }
+
+            continue;
+        }
+
+        long long left = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             end - Clock::now()).count();
+        if(left <= 0)
+            return false;
+
+        // say so before the last look, so a publish after it wakes us
+        unsigned seen = this->ctrl->wake.load();
+        this->ctrl->sleeping.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if(!ready())
+            futexWait(&this->ctrl->wake, seen, left);
+
+        this->ctrl->sleeping.fetch_sub(1);
+    }
+}
+
+//----------------------------------------------------------------------------
+bool SharedRing::waitData(bool poll, int timeoutMs)
+{
+    return this->waitFor([this]() { return this->available() > 0; }, poll,
+                         timeoutMs);
+}
+
+//----------------------------------------------------------------------------
+bool SharedRing::waitRoom(bool poll, int timeoutMs)
+{
+    return this->waitFor([this]() { return this->claim() != nullptr; }, poll,
+                         timeoutMs);
+}
+
+//----------------------------------------------------------------------------
+SharedChannel::SharedChannel()
+{
+    this->map = nullptr;
+    this->mapLen = 0;
+    this->fd = -1;
+}
+
+//----------------------------------------------------------------------------
+SharedChannel::~SharedChannel()
+{
+    this->close();
+}
+
+//----------------------------------------------------------------------------
+bool SharedChannel::attachRings()
+{
+    unsigned requestSize;
+    unsigned resultSize;
+    unsigned order;
+    unsigned n;
+
+    std::memcpy(&requestSize, this->map + 8, 4);
+    std::memcpy(&resultSize, this->map + 12, 4);
+    std::memcpy(&order, this->map + 16, 4);
+    std::memcpy(&n, this->map + 20, 4);
+
+    if(std::memcmp(this->map, MAGIC, 8) != 0 ||
+       requestSize != sizeof(RingRequest) ||
+       resultSize != sizeof(RingResult) || order != BYTE_ORDER_MARK ||
+       n < MIN_SLOTS || n > MAX_SLOTS || (n & (n - 1)) != 0 ||
+       this->mapLen != HEADER_SIZE + n * (requestSize + resultSize))
+        return false;
+
+    SharedRing::Control* ctrl = reinterpret_cast<SharedRing::Control*>(
+                                    this->map + CONTROL_OFFSET);
+    unsigned char* first = this->map + HEADER_SIZE;
+
+    this->requests.attach(ctrl, first, sizeof(RingRequest), n);
+    this->results.attach(ctrl + 1, first + n * sizeof(RingRequest),
+                         sizeof(RingResult), n);
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+bool SharedChannel::create(const char* path, size_t slots)
+{
+    this->close();
+
+    size_t n = MIN_SLOTS;
+    while(n < slots && n < MAX_SLOTS)
+        n *= 2;
+
+    std::string tmp = std::string(path) + ".tmp" + std::to_string(getpid());
+    size_t len = HEADER_SIZE + n * (sizeof(RingRequest) + sizeof(RingResult));
+
+    int f = ::open(tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0660);
+    if(f < 0)
+        return false;
+
+    void* m = MAP_FAILED;
+    if(ftruncate(f, len) == 0)
+        m = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, f, 0);
+
+    if(m == MAP_FAILED)
+    {
+        ::close(f);
+        unlink(tmp.c_str());
+        return false;
+    }
+
+    this->map = static_cast<unsigned char*>(m);
+    this->mapLen = len;
+    this->fd = f;
+
+    unsigned requestSize = sizeof(RingRequest);
+    unsigned resultSize = sizeof(RingResult);
+    unsigned count = n;
+
+    std::memcpy(this->map, MAGIC, 8);
+    std::memcpy(this->map + 8, &requestSize, 4);
+    std::memcpy(this->map + 12, &resultSize, 4);
+    std::memcpy(this->map + 16, &BYTE_ORDER_MARK, 4);
+    std::memcpy(this->map + 20, &count, 4);
+
+    SharedRing::Control* ctrl = reinterpret_cast<SharedRing::Control*>(
+                                    this->map + CONTROL_OFFSET);
+    new (ctrl) SharedRing::Control();
+    new (ctrl + 1) SharedRing::Control();
+
+    if(!this->attachRings() || rename(tmp.c_str(), path) != 0)
+    {
+        unlink(tmp.c_str());
+        this->close();
+        return false;
+    }
+
+    this->created = path;
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+bool SharedChannel::open(const char* path, int timeoutMs)
+{
+    this->close();
+
+    int f = ::open(path, O_RDWR);
+    if(f < 0)
+        return false;
+
+    struct stat st;
+
+    if(flock(f, LOCK_EX | LOCK_NB) != 0 || fstat(f, &st) != 0 ||
+       static_cast<size_t>(st.st_size) < HEADER_SIZE)
+    {
+        ::close(f);
+        return false;
+    }
+
+    void* m = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                   f, 0);
+    if(m == MAP_FAILED)
+    {
+        ::close(f);
+        return false;
+    }
+
+    this->map = static_cast<unsigned char*>(m);
+    this->mapLen = st.st_size;
+    this->fd = f;
+
+    if(!this->attachRings())
+    {
+        this->close();
+        return false;
+    }
+
+    // the daemon publishes results before releasing their requests, so
+    // once the requests are gone every result left is in the ring
+    Clock::time_point end = Clock::now() + std::chrono::milliseconds(timeoutMs);
+
+    while(this->requests.available() > 0)
+    {
+        if(Clock::now() >= end)
+        {
+            this->close();
+            return false;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    this->results.release(this->results.available());
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+void SharedChannel::close()
+{
+    if(this->map != nullptr)
+        munmap(this->map, this->mapLen);
+
+    if(this->fd >= 0)
+        ::close(this->fd);
+
+    if(!this->created.empty())
+        unlink(this->created.c_str());
+
+    this->map = nullptr;
+    this->mapLen = 0;
+    this->fd = -1;
+    this->created.clear();
+    this->requests = SharedRing();
+    this->results = SharedRing();
+}
@@ -0,0 +1,275 @@
+#ifndef SHAREDRING_H_INCLUDED
+#define SHAREDRING_H_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Board.h"
+#include "SudokuSolver.h"
+
+/**
+ * \file
+ * Rings of solve requests and results in shared memory
+ *
+ * Layout of a channel file, integers in the byte order of the machine,
+ * which the header records
+ *
+ *     header    8 byte magic "SDKRING1", 4 byte request slot size, 4 byte
+ *               result slot size, 4 byte byte order mark 0x01020304,
+ *               4 byte slot count (a power of two), zero padding to 64
+ *               bytes, then the control blocks of the request ring and
+ *               the result ring, padded to 4096 bytes
+ *     requests  slot count RingRequest slots
+ *     results   slot count RingResult slots
+ *
+ * Each ring has a single producer and a single consumer. The producer
+ * fills slots past the head and then moves the head; the consumer reads
+ * slots from the tail up to the head and then moves the tail. Either side
+ * that finds nothing to do may sleep on a futex in the control block, and
+ * the other side only makes the system call to wake it when it said it
+ * was going to sleep.
+ */
+
+/**
+ * A request as it lies in a slot
+ */
+struct RingRequest
+{
+    unsigned long long id;      ///< Id chosen by the client
+    unsigned flags;             ///< FLAG_SEARCH or nothing
+    int budget;                 ///< Most passes, 0 for no limit
+    unsigned char board[Board::PACKED_SIZE];    ///< Packed board
+    unsigned char padding[7];   ///< Rounds the slot to 64 bytes
+};
+
+/**
+ * A result as it lies in a slot
+ */
+struct RingResult
+{
+    unsigned long long id;      ///< Id of the request answered
+    unsigned char solution[Board::PACKED_SIZE]; ///< Board left
+    unsigned char status;       ///< SolveStatus, or MALFORMED
+    int placements;             ///< Counts from the solve
+    int blockSingles;
+    int rowSingles;
+    int colSingles;
+    int passes;
+    long long searchNodes;
+    long long nanos;
+    unsigned char padding[40];  ///< Rounds the slot to 128 bytes
+};
+
+/**
+ * The SharedRing class is one side's view of a ring in a channel file.
+ * The producer claims and publishes slots, the consumer reads and
+ * releases them.
+ */
+class SharedRing
+{
+    public:
+        /**
+         * Indexes and wakeup word of a ring, as they lie in the file
+         */
+        struct Control
+        {
+            alignas(64) std::atomic<unsigned long long> head;   ///< Slots
+                                                                ///< published
+            alignas(64) std::atomic<unsigned long long> tail;   ///< Slots
+                                                                ///< released
+            alignas(64) std::atomic<unsigned> wake;     ///< Futex word, bumped
+                                                        ///< to wake a sleeper
+            std::atomic<unsigned> sleeping;             ///< Sides waiting
+                                                        ///< on wake
+        };
+
+    private:
+        Control* ctrl;              ///< Control block in the file
+        unsigned char* slots;       ///< First slot
+        size_t slotSize;            ///< Bytes in a slot
+        unsigned long long mask;    ///< Slot count less one
+
+        /**
+         * Sleep or spin until a condition holds
+         *
+         * @param ready true once there is something to do
+         * @param poll true to spin instead of sleeping
+         * @param timeoutMs milliseconds to wait at most
+         *
+         * @return false if the time ran out first
+         */
+        template <typename Ready>
+        bool waitFor(Ready ready, bool poll, int timeoutMs);
+
+        /**
+         * Wake the other side if it is asleep
+         */
+        void wakeOther();
+
+    public:
+        /**
+         * Default Constructor, attached to nothing
+         */
+        SharedRing();
+
+        /**
+         * Attach to a ring in a mapped channel file
+         *
+         * @param ctrl control block of the ring
+         * @param slots first slot of the ring
+         * @param slotSize bytes in a slot
+         * @param count number of slots, a power of two
+         */
+        void attach(Control* ctrl, unsigned char* slots, size_t slotSize,
+                    size_t count);
+
+        /**
+         * Get a free slot past the head, for the producer
+         *
+         * @param i slots past the head, for filling several before
+         *        publishing them together
+         *
+         * @return the slot, or nullptr if the ring is full that far
+         */
+        void* claim(size_t i = 0);
+
+        /**
+         * Hand filled slots to the consumer, for the producer
+         *
+         * @param n number of claimed slots to publish
+         */
+        void publish(size_t n = 1);
+
+        /**
+         * Count the slots waiting to be read, for the consumer
+         *
+         * @return published slots not yet released
+         */
+        size_t available() const;
+
+        /**
+         * Get a published slot, for the consumer
+         *
+         * @param i slots past the tail, less than available()
+         *
+         * @return the slot
+         */
+        void* at(size_t i);
+
+        /**
+         * Give read slots back to the producer, for the consumer
+         *
+         * @param n number of slots to release
+         */
+        void release(size_t n = 1);
+
+        /**
+         * Wait until a slot can be read, for the consumer
+         *
+         * @param poll true to spin instead of sleeping
+         * @param timeoutMs milliseconds to wait at most
+         *
+         * @return false if the time ran out first
+         */
+        bool waitData(bool poll, int timeoutMs);
+
+        /**
+         * Wait until a slot can be claimed, for the producer
+         *
+         * @param poll true to spin instead of sleeping
+         * @param timeoutMs milliseconds to wait at most
+         *
+         * @return false if the time ran out first
+         */
+        bool waitRoom(bool poll, int timeoutMs);
+
+        /**
+         * Get the number of slots
+         *
+         * @return slots in the ring
+         */
+        size_t size() const;
+};
+
+/**
+ * The SharedChannel class maps a channel file: a ring of requests from a
+ * client to the daemon and a ring of results back. The daemon creates
+ * the file and a client opens it, one client at a time. Both rings are
+ * single producer and single consumer; there is no ring shared by
+ * several clients, and open() takes a lock on the file so a second
+ * client is refused rather than corrupting the rings.
+ *
+ * A client fills request slots in place, packing its boards straight
+ * into them, and reads results from the slots they were written to, so
+ * nothing crosses between the processes but the slots themselves. Results
+ * come back in the order of the requests. A client must not have more
+ * requests outstanding than there are slots, so the daemon always has
+ * room for their results.
+ */
+class SharedChannel
+{
+    private:
+        unsigned char* map;         ///< Start of the mapped file
+        size_t mapLen;              ///< Length of the mapping
+        int fd;                     ///< File, locked while a client has it
+        std::string created;        ///< Path to remove on close, if made
+                                    ///< by create()
+
+        /**
+         * Check the header of a mapped file and attach the rings
+         *
+         * @return true if the file is a channel made by this build
+         */
+        bool attachRings();
+
+    public:
+        SharedRing requests;        ///< Requests from the client
+        SharedRing results;         ///< Results from the daemon
+
+        /**
+         * Default Constructor
+         */
+        SharedChannel();
+
+        /**
+         * Destructor, releases the mapping
+         */
+        ~SharedChannel();
+
+        /**
+         * Make a channel file for the daemon's end, replacing any there
+         * The file is made under another name and renamed into place, so
+         * a client never sees it half made.
+         *
+         * @param path file to create, under /dev/shm to keep it in memory
+         * @param slots slots in each ring, rounded up to a power of two
+         *
+         * @return true if the channel was created
+         */
+        bool create(const char* path, size_t slots);
+
+        /**
+         * Map a channel file for a client's end
+         * Fails if another client has it. Requests left by a client that
+         * went away are allowed to finish, up to timeoutMs, and their
+         * results are thrown away.
+         *
+         * @param path file to open
+         * @param timeoutMs milliseconds to wait for old requests at most
+         *
+         * @return true if the channel is ready for requests
+         */
+        bool open(const char* path, int timeoutMs = 1000);
+
+        /**
+         * Release the mapping, removing the file if create() made it
+         */
+        void close();
+
+    private:
+        SharedChannel(const SharedChannel&);
+        SharedChannel& operator=(const SharedChannel&);
+};
+#endif
@@ -0,0 +1,401 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "SolutionStore.h"
+
+static const char MAGIC[8] = {'S', 'D', 'K', 'S', 'T', 'O', 'R', '1'};
+static const unsigned BYTE_ORDER_MARK = 0x01020304;
+static const size_t HEADER_SIZE = 64;
+static const size_t MIN_SLOTS = 64;
+
+/**
+ * Name a file is made under before it is renamed into place
+ */
+static std::string tempName(const char* path)
+{
+    return std::string(path) + ".tmp" + std::to_string(getpid());
+}
+
+/**
+ * Rename a finished file into place and make the rename last
+ */
+static bool publish(const std::string& from, const char* path)
+{
+    if(rename(from.c_str(), path) != 0)
+    {
+        unlink(from.c_str());
+        return false;
+    }
+
+    std::string dir(path);
+    size_t slash = dir.rfind('/');
+    dir = (slash == std::string::npos) ? "." : dir.substr(0, slash + 1);
+
+    int dfd = ::open(dir.c_str(), O_RDONLY);
+    if(dfd >= 0)
+    {
+        fsync(dfd);
+        ::close(dfd);
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+SolutionStore::SolutionStore()
+{
+    this->map = nullptr;
+    this->mapLen = 0;
+    this->slots = nullptr;
+    this->numSlots = 0;
+    this->count = nullptr;
+    this->fd = -1;
+    this->durable = false;
+}
+
+//----------------------------------------------------------------------------
+SolutionStore::~SolutionStore()
+{
+    this->close();
+}
+
+//----------------------------------------------------------------------------
+bool SolutionStore::open(const char* path, bool writable)
+{
+    static_assert(sizeof(Slot) == 128, "store slots are 128 bytes");
+
+    this->close();
+
+    int f = ::open(path, writable ? O_RDWR : O_RDONLY);
+    if(f < 0)
+        return false;
+
+    // one writer at a time, readers need no lock
+    struct stat st;
+    if((writable && flock(f, LOCK_EX | LOCK_NB) != 0) ||
+       fstat(f, &st) != 0 || !S_ISREG(st.st_mode) ||
+       static_cast<size_t>(st.st_size) < HEADER_SIZE)
+    {
+        ::close(f);
+        return false;
+    }
+
+    void* m = mmap(nullptr, st.st_size,
+                   writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                   MAP_SHARED, f, 0);
+
+    if(m == MAP_FAILED)
+    {
+        ::close(f);
+        return false;
+    }
+
+    this->map = static_cast<unsigned char*>(m);
+    this->mapLen = st.st_size;
+
+    unsigned slotSize;
+    unsigned order;
+    unsigned long long n;
+    std::memcpy(&slotSize, this->map + 8, 4);
+    std::memcpy(&order, this->map + 12, 4);
+    std::memcpy(&n, this->map + 16, 8);
+
+    if(std::memcmp(this->map, MAGIC, 8) != 0 || slotSize != sizeof(Slot) ||
+       order != BYTE_ORDER_MARK || n == 0 || (n & (n - 1)) != 0 ||
+       n != (this->mapLen - HEADER_SIZE) / sizeof(Slot) ||
+       HEADER_SIZE + n * sizeof(Slot) != this->mapLen)
+    {
+        ::close(f);
+        this->close();
+        return false;
+    }
+
+    this->slots = reinterpret_cast<Slot*>(this->map + HEADER_SIZE);
+    this->numSlots = n;
+    this->count = reinterpret_cast<unsigned long long*>(this->map + 24);
+
+    if(writable)
+        this->fd = f;
+    else
+        ::close(f);
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+int SolutionStore::makeFile(const char* path, unsigned long long capacity)
+{
+    unsigned long long n = MIN_SLOTS;
+    while(n / 4 * 3 < capacity)
+        n *= 2;
+
+    int f = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(f < 0)
+        return -1;
+
+    unsigned char header[HEADER_SIZE] = {};
+    unsigned slotSize = sizeof(Slot);
+    std::memcpy(header, MAGIC, 8);
+    std::memcpy(header + 8, &slotSize, 4);
+    std::memcpy(header + 12, &BYTE_ORDER_MARK, 4);
+    std::memcpy(header + 16, &n, 8);
+
+    // the slots are left as a hole, which reads back as zeros
+    if(ftruncate(f, HEADER_SIZE + n * sizeof(Slot)) != 0 ||
+       pwrite(f, header, HEADER_SIZE, 0) != static_cast<ssize_t>(HEADER_SIZE))
+    {
+        ::close(f);
+        unlink(path);
+        return -1;
+    }
+
+    return f;
+}
+
+//----------------------------------------------------------------------------
+bool SolutionStore::create(const char* path, unsigned long long capacity)
+{
+    this->close();
+
+    std::string temp = tempName(path);
+    int f = makeFile(temp.c_str(), capacity);
+    if(f < 0)
+        return false;
+
+    bool synced = fsync(f) == 0;
+    ::close(f);
+
+    if(!synced)
+    {
+        unlink(temp.c_str());
+        return false;
+    }
+
+    return publish(temp, path) && this->open(path, true);
+}
+
+//----------------------------------------------------------------------------
+void SolutionStore::close()
+{
+    if(this->map != nullptr)
+        munmap(this->map, this->mapLen);
+
+    if(this->fd >= 0)
+        ::close(this->fd);
+
+    this->map = nullptr;
+    this->mapLen = 0;
+    this->slots = nullptr;
+    this->numSlots = 0;
+    this->count = nullptr;
+    this->fd = -1;
+}
+
+//----------------------------------------------------------------------------
+SolutionStore::Slot* SolutionStore::probe(const ResultCache::Key& key,
+                                          unsigned long long hash) const
+{
+    unsigned long long mask = this->numSlots - 1;
+
+    for(unsigned long long i = 0; i < this->numSlots; i++)
+    {
+        Slot* s = &this->slots[(hash + i) & mask];
+        unsigned long long h = __atomic_load_n(&s->hash, __ATOMIC_ACQUIRE);
+
+        if(h == 0)
+            return s;
+
+        if(h == hash && s->search == key.search &&
+           std::memcmp(s->board, key.board, Board::PACKED_SIZE) == 0)
+            return s;
+    }
+
+    return nullptr;
+}
+
+//----------------------------------------------------------------------------
+bool SolutionStore::find(const ResultCache::Key& key, Board& solution,
+                         SolveStats& stats) const
+{
+    if(this->map == nullptr)
+        return false;
+
+    // 0 marks a free slot
+    unsigned long long hash = key.hash ? key.hash : 1;
+    const Slot* s = this->probe(key, hash);
+
+    if(s == nullptr || __atomic_load_n(&s->hash, __ATOMIC_ACQUIRE) == 0)
+        return false;
+
+    solution.readPacked(s->solution);
+    stats.status = static_cast<SolveStatus>(s->status);
+    stats.placements = s->placements;
+    stats.blockSingles = s->blockSingles;
+    stats.rowSingles = s->rowSingles;
+    stats.colSingles = s->colSingles;
+    stats.passes = s->passes;
+    stats.searchNodes = s->searchNodes;
+    stats.nanos = 0;
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+void SolutionStore::fill(Slot* s, const ResultCache::Key& key,
+                         unsigned long long hash, const Board& solution,
+                         const SolveStats& stats)
+{
+    std::memcpy(s->board, key.board, Board::PACKED_SIZE);
+    s->search = key.search;
+    solution.writePacked(s->solution);
+    s->status = static_cast<unsigned char>(stats.status);
+    s->placements = stats.placements;
+    s->blockSingles = stats.blockSingles;
+    s->rowSingles = stats.rowSingles;
+    s->colSingles = stats.colSingles;
+    s->passes = stats.passes;
+    s->searchNodes = stats.searchNodes;
+
+    // the entry has to be on disk before the hash that makes it visible
+    long page = sysconf(_SC_PAGESIZE);
+    unsigned char* start = reinterpret_cast<unsigned char*>(
+        reinterpret_cast<std::uintptr_t>(s) & ~(page - 1));
+    size_t len = reinterpret_cast<unsigned char*>(s + 1) - start;
+
+    if(this->durable)
+        msync(start, len, MS_SYNC);
+
+    __atomic_store_n(&s->hash, hash, __ATOMIC_RELEASE);
+    __atomic_fetch_add(this->count, 1, __ATOMIC_RELAXED);
+
+    if(this->durable)
+        msync(start, len, MS_SYNC);
+}
+
+//----------------------------------------------------------------------------
+bool SolutionStore::insert(const ResultCache::Key& key, const Board& solution,
+                           const SolveStats& stats)
+{
+    if(this->fd < 0)
+        return false;
+
+    unsigned long long hash = key.hash ? key.hash : 1;
+
+    std::lock_guard<std::mutex> guard(this->insertLock);
+    Slot* s = this->probe(key, hash);
+
+    if(s == nullptr)
+        return false;
+
+    if(s->hash != 0)
+        return true;
+
+    if(this->size() >= this->capacity())
+        return false;
+
+    this->fill(s, key, hash, solution, stats);
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+bool SolutionStore::solve(SudokuSolver& solver,
+                          const std::function<bool(SudokuSolver&)>& miss)
+{
+    if(solver.budget > 0 || this->map == nullptr)
+        return miss(solver);
+
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+
+    ResultCache::Key key;
+    ResultCache::makeKey(solver.board, solver.search, key);
+
+    if(this->find(key, solver.board, solver.stats))
+    {
+        solver.unsolvable = solver.stats.status == CONTRADICTION;
+        solver.stats.nanos =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+
+        return solver.stats.status == SOLVED;
+    }
+
+    miss(solver);
+
+    if(solver.stats.status != BUDGET)
+        this->insert(key, solver.board, solver.stats);
+
+    return solver.stats.status == SOLVED;
+}
+
+//----------------------------------------------------------------------------
+unsigned long long SolutionStore::size() const
+{
+    if(this->count == nullptr)
+        return 0;
+
+    return __atomic_load_n(this->count, __ATOMIC_RELAXED);
+}
+
+//----------------------------------------------------------------------------
+unsigned long long SolutionStore::capacity() const
+{
+    return this->numSlots / 4 * 3;
+}
+
+//----------------------------------------------------------------------------
+bool SolutionStore::isWritable() const
+{
+    return this->fd >= 0;
+}
+
+//----------------------------------------------------------------------------
+bool SolutionStore::build(const char* path, const Board* puzzles,
+                          const Result* results, size_t n, bool search)
+{
+    std::string temp = tempName(path);
+    int f = makeFile(temp.c_str(), n);
+    if(f < 0)
+        return false;
+    ::close(f);
+
+    SolutionStore store;
+    if(!store.open(temp.c_str(), true))
+    {
+        unlink(temp.c_str());
+        return false;
+    }
+
+    ResultCache::Key key;
+
+    for(size_t i = 0; i < n; i++)
+    {
+        if(results[i].stats.status == BUDGET)
+            continue;
+
+        ResultCache::makeKey(puzzles[i], search, key);
+        store.insert(key, results[i].solution, results[i].stats);
+    }
+
+    bool synced = msync(store.map, store.mapLen, MS_SYNC) == 0 &&
+                  fsync(store.fd) == 0;
+    store.close();
+
+    if(!synced)
+    {
+        unlink(temp.c_str());
+        return false;
+    }
+
+    return publish(temp, path);
+}
@@ -0,0 +1,225 @@
+#ifndef SOLUTIONSTORE_H_INCLUDED
+#define SOLUTIONSTORE_H_INCLUDED
+
+#include <cstddef>
+#include <functional>
+#include <mutex>
+
+#include "ResultCache.h"
+#include "SolveBatch.h"
+#include "SudokuSolver.h"
+
+/**
+ * \file
+ * Solution store kept in a file and read through mmap
+ *
+ * Layout of a store file, integers in the byte order of the machine that
+ * made it, which the header records
+ *
+ *     header   8 byte magic "SDKSTOR1", 4 byte slot size, 4 byte byte
+ *              order mark 0x01020304, 8 byte slot count (a power of two),
+ *              8 byte entry count, zero padding to 64 bytes
+ *     slots    128 bytes each, see SolutionStore::Slot
+ *
+ * A board lives in the first free slot at or after its hash modulo the
+ * slot count, wrapping around. A slot is free while its hash is 0, and an
+ * entry is written in full before its hash is set, so a writer that dies
+ * part way through leaves the slot free. Entries are never changed or
+ * removed once their hash is set.
+ */
+
+/**
+ * The SolutionStore class keeps the results of solves in a file that
+ * outlives the program, so a known board is answered by mapping the file
+ * and probing it, without solving or parsing anything.
+ *
+ * Any number of processes may map a store to read it, but only one at a
+ * time may open it for writing, which holds a lock on the file. Threads
+ * of that process may look up and insert at once. The file does not grow:
+ * inserts fail once three quarters of the slots are full, and a bigger
+ * store is made with build().
+ */
+class SolutionStore
+{
+    private:
+        /**
+         * An entry as it lies in the file
+         */
+        struct Slot
+        {
+            unsigned long long hash;    ///< Hash of the board, 0 if free
+            unsigned char board[Board::PACKED_SIZE];    ///< Packed board
+            unsigned char search;       ///< 1 if the solver guessed
+            unsigned char solution[Board::PACKED_SIZE]; ///< Board left
+            unsigned char status;       ///< How the solve ended
+            int placements;             ///< Counts from the solve
+            int blockSingles;
+            int rowSingles;
+            int colSingles;
+            int passes;
+            long long searchNodes;
+            unsigned char padding[8];   ///< Rounds the slot to 128 bytes
+        };
+
+        unsigned char* map;         ///< Start of the mapped file
+        size_t mapLen;              ///< Length of the mapping
+        Slot* slots;                ///< First slot
+        unsigned long long numSlots;    ///< Number of slots
+        unsigned long long* count;  ///< Entry count in the header
+        int fd;                     ///< File held open and locked while
+                                    ///< writable, -1 otherwise
+        std::mutex insertLock;      ///< Guards inserts within the process
+
+        /**
+         * Find the slot holding a board, or the free slot it would go in
+         *
+         * @param key key of the board
+         * @param hash hash the board is stored under
+         *
+         * @return the slot, or nullptr if the store is full without it
+         */
+        Slot* probe(const ResultCache::Key& key,
+                    unsigned long long hash) const;
+
+        /**
+         * Write an entry into a free slot and then publish it
+         */
+        void fill(Slot* s, const ResultCache::Key& key,
+                  unsigned long long hash, const Board& solution,
+                  const SolveStats& stats);
+
+        /**
+         * Make a store file holding nothing
+         *
+         * @param path file to create
+         * @param capacity entries the store must have room for
+         *
+         * @return descriptor of the file, -1 if it could not be made
+         */
+        static int makeFile(const char* path, unsigned long long capacity);
+
+    public:
+        bool durable;   ///< Flush every insert to disk, so entries survive
+                        ///< losing power and not only the program dying
+
+        /**
+         * Default Constructor
+         */
+        SolutionStore();
+
+        /**
+         * Destructor, releases the mapping and the lock
+         */
+        ~SolutionStore();
+
+        /**
+         * Map a store file and check its header
+         *
+         * @param path file to open
+         * @param writable true to insert as well as look up, which fails
+         *        if another process has the store open for writing
+         *
+         * @return true if the file is a valid store and could be opened
+         */
+        bool open(const char* path, bool writable = false);
+
+        /**
+         * Create an empty store and open it for writing
+         * The file is made under another name and renamed into place, so
+         * it is either missing or complete.
+         *
+         * @param path file to create, replacing any there
+         * @param capacity entries the store must have room for
+         *
+         * @return true if the store was created
+         */
+        bool create(const char* path, unsigned long long capacity);
+
+        /**
+         * Release the mapping and the lock
+         */
+        void close();
+
+        /**
+         * Look for the result of a board
+         * Safe to call while this or another process inserts.
+         *
+         * @param key key of the board
+         * @param solution board the solver left, set on a hit
+         * @param stats counts from the solve, set on a hit
+         *
+         * @return true if the board was found
+         */
+        bool find(const ResultCache::Key& key, Board& solution,
+                  SolveStats& stats) const;
+
+        /**
+         * Add the result of a board, unless it is already there
+         *
+         * @param key key of the board
+         * @param solution board the solver left
+         * @param stats counts from the solve
+         *
+         * @return false if the store is read only or full
+         */
+        bool insert(const ResultCache::Key& key, const Board& solution,
+                    const SolveStats& stats);
+
+        /**
+         * Solve the solver's board, from the store if it was solved before
+         * On a hit the board and stats are as the solver would leave them,
+         * except that the time is that of the lookup. New results are
+         * added if the store is writable. Solves with a budget bypass the
+         * store, since their result depends on the budget.
+         *
+         * @param solver solver holding the board, left holding the result
+         * @param miss solves boards that are not found, returning true if
+         *        the board is solved
+         *
+         * @return true if the board is solved
+         */
+        bool solve(SudokuSolver& solver,
+                   const std::function<bool(SudokuSolver&)>& miss);
+
+        /**
+         * Get the number of entries
+         *
+         * @return number of entries
+         */
+        unsigned long long size() const;
+
+        /**
+         * Get the most entries the store takes
+         *
+         * @return three quarters of the slots
+         */
+        unsigned long long capacity() const;
+
+        /**
+         * Determine whether the store takes inserts
+         *
+         * @return true if the store is open for writing
+         */
+        bool isWritable() const;
+
+        /**
+         * Write a store holding the results of a solved batch
+         * The file is made under another name and renamed into place, so
+         * it is either missing or complete.
+         *
+         * @param path file to create, replacing any there
+         * @param puzzles boards that were solved
+         * @param results results of solveBatch() for them
+         * @param n number of boards
+         * @param search true if the batch was solved with guessing
+         *
+         * @return true if the store was written
+         */
+        static bool build(const char* path, const Board* puzzles,
+                          const Result* results, size_t n, bool search);
+
+    private:
+        SolutionStore(const SolutionStore&);
+        SolutionStore& operator=(const SolutionStore&);
+};
+#endif
@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <thread>
+
+#include "LockstepSolver.h"
+#include "SolveBatch.h"
+#include "ThreadPool.h"
+
+/**
+ * Boards handed to a thread at a time, one lockstep group
+ */
+static const size_t BLOCK = LockstepSolver::LANES;
+
+/**
+ * Solve boards in to out one at a time, or a lockstep group at a time
+ */
+static void solveRange(const Board* in, Result* out, size_t n, bool lockstep,
+                       SudokuSolver& solver, LockstepSolver& group)
+{
+    if(lockstep)
+    {
+        for(size_t i = 0; i < n; i += BLOCK)
+            group.solve(in + i, std::min(BLOCK, n - i), out + i);
+
+        return;
+    }
+
+    for(size_t i = 0; i < n; i++)
+    {
+        solver.board = in[i];
+        solver.solveDriver();
+
+        out[i].solution = solver.board;
+        out[i].stats = solver.stats;
+    }
+}
+
+//----------------------------------------------------------------------------
+BatchOptions::BatchOptions()
+{
+    this->threads = 0;
+    this->budget = 0;
+    this->lockstep = false;
+    this->search = false;
+}
+
+//----------------------------------------------------------------------------
+void solveBatch(const Board* in, size_t n, Result* out,
+                const BatchOptions& opts)
+{
+    int threads = opts.threads;
+    if(threads <= 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    ThreadPool::shared().parallelFor(0, n, BLOCK,
+                                     [&](size_t start, size_t end)
+    {
+        thread_local SudokuSolver solver;
+        thread_local LockstepSolver group;
+
+        solver.budget = opts.budget;
+        solver.search = opts.search;
+        group.budget = opts.budget;
+        group.search = opts.search;
+
+        solveRange(in + start, out + start, end - start, opts.lockstep,
+                   solver, group);
+    }, threads);
+}
@@ -0,0 +1,55 @@
+#ifndef SOLVEBATCH_H_INCLUDED
+#define SOLVEBATCH_H_INCLUDED
+
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+#include "Board.h"
+#include "SudokuSolver.h"
+
+/**
+ * \file
+ * Library entry point for solving many boards at once
+ */
+
+/**
+ * Outcome of solving one board
+ */
+struct Result
+{
+    Board solution;             ///< Board as the solver left it
+    SolveStats stats;           ///< Counts from the solve
+};
+
+/**
+ * Settings for solveBatch()
+ */
+struct BatchOptions
+{
+    int threads;                ///< Threads to solve on, 0 for one per core
+    int budget;                 ///< Most passes per board, 0 for no limit
+    bool lockstep;              ///< Solve LockstepSolver::LANES at a time
+    bool search;                ///< Guess on boards that get stuck
+
+    /**
+     * Default Constructor, one thread per core, no budget, one board at a
+     * time, and no guessing
+     */
+    BatchOptions();
+};
+
+/**
+ * Solve a run of boards
+ * The work is split into blocks on the shared ThreadPool, and each thread
+ * reuses one SudokuSolver for every board it takes. Solving a single board
+ * gives the same result as SudokuSolver::solveDriver().
+ *
+ * @param in boards to solve
+ * @param n number of boards
+ * @param out results, one for each board, in the same order
+ * @param opts settings for the batch
+ */
+void solveBatch(const Board* in, size_t n, Result* out,
+                const BatchOptions& opts);
+#endif
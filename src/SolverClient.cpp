@@ -0,0 +1,76 @@
+#include <cstring>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "SolverClient.h"
+
+//----------------------------------------------------------------------------
+SolverClient::SolverClient()
+{
+    this->fd = -1;
+}
+
+//----------------------------------------------------------------------------
+SolverClient::~SolverClient()
+{
+    this->close();
+}
+
+//----------------------------------------------------------------------------
+bool SolverClient::connect(const char* path)
+{
+    this->close();
+
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+
+    if(std::strlen(path) >= sizeof(addr.sun_path))
+        return false;
+
+    std::strcpy(addr.sun_path, path);
+
+    this->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(this->fd < 0)
+        return false;
+
+    if(::connect(this->fd, reinterpret_cast<sockaddr*>(&addr),
+                 sizeof(addr)) != 0)
+    {
+        this->close();
+        return false;
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+void SolverClient::close()
+{
+    if(this->fd >= 0)
+        ::close(this->fd);
+
+    this->fd = -1;
+}
+
+//----------------------------------------------------------------------------
+bool SolverClient::send(unsigned id, unsigned flags, unsigned budget,
+                        const Board* boards, size_t n, unsigned deadline)
+{
+    std::lock_guard<std::mutex> guard(this->sendLock);
+
+    this->out.clear();
+    appendRequest(this->out, id, flags, budget, boards, n, deadline);
+
+    return this->fd >= 0 && writeAll(this->fd, this->out.data(),
+                                     this->out.size());
+}
+
+//----------------------------------------------------------------------------
+bool SolverClient::receive(SolveResponse& resp)
+{
+    return this->fd >= 0 && readFrame(this->fd, this->in) &&
+           parseResponse(this->in.data(), this->in.size(), resp);
+}
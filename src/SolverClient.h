@@ -0,0 +1,76 @@
+#ifndef SOLVERCLIENT_H_INCLUDED
+#define SOLVERCLIENT_H_INCLUDED
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+
+#include "SolverProtocol.h"
+
+/**
+ * The SolverClient class talks to a SolverDaemon over its socket.
+ * One thread may send while another receives, so requests can be kept
+ * in flight while earlier responses are read.
+ */
+class SolverClient
+{
+    private:
+        int fd;                     ///< Socket, -1 if not connected
+        std::string out;            ///< Frame being sent
+        std::string in;             ///< Frame being received
+        std::mutex sendLock;        ///< Keeps requests whole
+
+    public:
+        /**
+         * Default Constructor
+         */
+        SolverClient();
+
+        /**
+         * Destructor, closes the connection
+         */
+        ~SolverClient();
+
+        /**
+         * Connect to a daemon
+         *
+         * @param path file system path of the daemon's socket
+         *
+         * @return true if the daemon accepted the connection
+         */
+        bool connect(const char* path);
+
+        /**
+         * Close the connection
+         */
+        void close();
+
+        /**
+         * Send a request without waiting for its response
+         *
+         * @param id id of the request, returned with its response
+         * @param flags FLAG_SEARCH or nothing
+         * @param budget most passes per board, 0 for no limit
+         * @param boards boards to solve
+         * @param n number of boards
+         * @param deadline microseconds to answer in, 0 for no limit
+         *
+         * @return false if the connection failed
+         */
+        bool send(unsigned id, unsigned flags, unsigned budget,
+                  const Board* boards, size_t n, unsigned deadline = 0);
+
+        /**
+         * Wait for the next response
+         *
+         * @param resp response read
+         *
+         * @return false if the connection closed or failed
+         */
+        bool receive(SolveResponse& resp);
+
+    private:
+        SolverClient(const SolverClient&);
+        SolverClient& operator=(const SolverClient&);
+};
+#endif
@@ -0,0 +1,616 @@
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <iostream>
+#include <utility>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "LockstepSolver.h"
+#include "SolverDaemon.h"
+#include "SudokuSolver.h"
+
+/**
+ * Guess at the nanoseconds a pass takes, until some are timed
+ */
+static const long long INITIAL_PASS_NANOS = 2000;
+
+/**
+ * Milliseconds the ring thread sleeps before looking at stop() again
+ */
+static const int RING_WAIT_MS = 100;
+
+/**
+ * Most ring requests solved together
+ */
+static const size_t RING_RUN = 1024;
+
+/**
+ * Raise an atomic maximum to val
+ */
+static void raise(std::atomic<long long>& max, long long val)
+{
+    long long seen = max;
+
+    while(seen < val && !max.compare_exchange_weak(seen, val))
+        ;
+}
+
+//----------------------------------------------------------------------------
+SolverDaemon::Connection::Connection(int fd)
+    : broken(false), done(false), tasks(ThreadPool::shared())
+{
+    this->fd = fd;
+    this->closing = false;
+    this->pending = 0;
+}
+
+//----------------------------------------------------------------------------
+SolverDaemon::SolverDaemon()
+    : stopping(false), passNanos(INITIAL_PASS_NANOS), requests(0),
+      puzzles(0), queued(0), peakQueued(0), busy(0), late(0), waitNanos(0),
+      maxWaitNanos(0)
+{
+    this->listenFd = -1;
+    this->threads = 0;
+    this->coalesce = false;
+    this->maxQueue = 0;
+    this->reportEvery = 0;
+    this->busyPoll = false;
+    this->ringOpen = false;
+}
+
+//----------------------------------------------------------------------------
+SolverDaemon::~SolverDaemon()
+{
+    if(this->listenFd >= 0)
+    {
+        close(this->listenFd);
+        unlink(this->path.c_str());
+    }
+}
+
+//----------------------------------------------------------------------------
+bool SolverDaemon::listen(const char* path)
+{
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+
+    if(std::strlen(path) >= sizeof(addr.sun_path))
+        return false;
+
+    std::strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd < 0)
+        return false;
+
+    unlink(path);
+
+    if(bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+       ::listen(fd, 128) != 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    this->listenFd = fd;
+    this->path = path;
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+bool SolverDaemon::listenRing(const char* path, size_t slots)
+{
+    this->ringOpen = this->channel.create(path, slots);
+
+    return this->ringOpen;
+}
+
+//----------------------------------------------------------------------------
+void SolverDaemon::serve()
+{
+    int workers = this->threads > 0 ? this->threads
+                                    : std::thread::hardware_concurrency();
+    ThreadPool::shared().reserve(workers);
+
+    if(this->coalesce)
+        this->batcher.start();
+
+    std::thread ring;
+    if(this->ringOpen)
+        ring = std::thread(&SolverDaemon::serveRing, this);
+
+    std::thread reporter;
+    if(this->reportEvery > 0)
+    {
+        reporter = std::thread([this]()
+        {
+            std::unique_lock<std::mutex> guard(this->reportLock);
+
+            while(!this->served.wait_for(guard,
+                      std::chrono::seconds(this->reportEvery),
+                      [this]() { return this->stopping.load(); }))
+                this->report(std::cerr);
+        });
+    }
+
+    while(!this->stopping)
+    {
+        int fd = accept(this->listenFd, nullptr, nullptr);
+
+        if(fd < 0)
+        {
+            if(errno == EINTR || errno == ECONNABORTED)
+                continue;
+
+            break;
+        }
+
+        std::shared_ptr<Connection> conn(new Connection(fd));
+
+        this->reap(false);
+        this->conns.push_back(conn);
+        this->readers.push_back(std::thread(&SolverDaemon::serveConnection,
+                                            this, conn));
+    }
+
+    // hang up on the clients, which ends their reader threads
+    for(size_t i = 0; i < this->conns.size(); i++)
+        shutdown(this->conns[i]->fd, SHUT_RD);
+
+    this->reap(true);
+    this->batcher.stop();
+
+    if(ring.joinable())
+        ring.join();
+
+    if(reporter.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> guard(this->reportLock);
+            this->stopping = true;
+        }
+
+        this->served.notify_one();
+        reporter.join();
+    }
+}
+
+//----------------------------------------------------------------------------
+void SolverDaemon::reap(bool all)
+{
+    size_t kept = 0;
+
+    for(size_t i = 0; i < this->conns.size(); i++)
+    {
+        if(all || this->conns[i]->done)
+        {
+            this->readers[i].join();
+            close(this->conns[i]->fd);
+            continue;
+        }
+
+        std::swap(this->conns[kept], this->conns[i]);
+        std::swap(this->readers[kept], this->readers[i]);
+        kept++;
+    }
+
+    this->conns.resize(kept);
+    this->readers.resize(kept);
+}
+
+//----------------------------------------------------------------------------
+void SolverDaemon::stop()
+{
+    this->stopping = true;
+
+    // wakes the accept() in serve()
+    if(this->listenFd >= 0)
+        shutdown(this->listenFd, SHUT_RDWR);
+}
+
+//----------------------------------------------------------------------------
+void SolverDaemon::serveConnection(std::shared_ptr<Connection> conn)
+{
+    std::string body;
+
+    // a client slow to read its responses holds up only its own writer,
+    // never the batcher or the workers answering everyone else
+    std::thread writer(&SolverDaemon::writeResponses, this, std::ref(*conn));
+
+    while(!conn->broken && readFrame(conn->fd, body))
+    {
+        std::shared_ptr<SolveRequest> req(new SolveRequest());
+
+        if(!parseRequest(body.data(), body.size(), *req))
+        {
+            std::string out;
+            appendResponse(out, 0, RESPONSE_BAD_REQUEST, *req, nullptr);
+
+            this->send(*conn, out);
+            break;
+        }
+
+        Clock::time_point arrival = Clock::now();
+
+        if(!this->admit(*conn, *req))
+            continue;
+
+        if(!this->coalesce)
+        {
+            conn->tasks.run([this, conn, req, arrival]()
+            {
+                this->answer(*conn, *req, arrival);
+            });
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(conn->pendingLock);
+            conn->pending++;
+        }
+
+        // budgets are rounded to powers of two so requests with deadlines
+        // can still share batches
+        int budget = this->budgetFor(*req, arrival,
+                                     this->batcher.window() * 1000);
+        if(req->deadline > 0)
+            while(budget & (budget - 1))
+                budget &= budget - 1;
+
+        this->batcher.submit(req->boards.data(), req->boards.size(),
+                             (req->flags & FLAG_SEARCH) != 0, budget,
+                             [this, conn, req, arrival](const Result* results,
+                                                        long long waited)
+        {
+            this->respond(*conn, *req, results, arrival, waited);
+
+            std::lock_guard<std::mutex> guard(conn->pendingLock);
+            if(--conn->pending == 0)
+                conn->drained.notify_all();
+        });
+    }
+
+    // responses still being solved go out before the client is told
+    // the daemon is done with it, the socket is closed by reap()
+    conn->tasks.wait();
+    {
+        std::unique_lock<std::mutex> guard(conn->pendingLock);
+        conn->drained.wait(guard, [&conn]() { return conn->pending == 0; });
+    }
+    {
+        std::lock_guard<std::mutex> guard(conn->writeLock);
+        conn->closing = true;
+    }
+    conn->queued.notify_one();
+    writer.join();
+    shutdown(conn->fd, SHUT_RDWR);
+    conn->done = true;
+}
+
+//----------------------------------------------------------------------------
+void SolverDaemon::serveRing()
+{
+    SharedRing& in = this->channel.requests;
+    SharedRing& out = this->channel.results;
+    std::vector<Board> boards;
+    std::vector<Result> results;
+    std::vector<bool> valid;
+    SudokuSolver solver;
+
+    while(!this->stopping)
+    {
+        if(!in.waitData(this->busyPoll, RING_WAIT_MS))
+            continue;
+
+        size_t n = std::min(in.available(), RING_RUN);
+        Clock::time_point arrival = Clock::now();
+
+        // the ring keeps a client to its slots rather than to maxQueue,
+        // but its boards still count towards the queue the socket
+        // clients are admitted against, and towards the report
+        raise(this->peakQueued, this->queued += n);
+
+        // requests asking for the same thing are solved together, each
+        // run starting at the tail once the one before is released
+        while(n > 0)
+        {
+            const RingRequest* first = static_cast<RingRequest*>(in.at(0));
+            size_t m = 1;
+
+            while(m < n)
+            {
+                const RingRequest* r = static_cast<RingRequest*>(in.at(m));
+                if(r->flags != first->flags || r->budget != first->budget)
+                    break;
+                m++;
+            }
+
+            boards.resize(m);
+            results.resize(m);
+            valid.resize(m);
+
+            long long waited =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    Clock::now() - arrival).count();
+
+            for(size_t k = 0; k < m; k++)
+            {
+                const RingRequest* r = static_cast<RingRequest*>(in.at(k));
+                valid[k] = boards[k].readPacked(r->board);
+            }
+
+            if(m == 1)
+            {
+                solver.board = boards[0];
+                solver.budget = first->budget;
+                solver.search = (first->flags & FLAG_SEARCH) != 0;
+                solver.solveDriver();
+
+                results[0].solution = solver.board;
+                results[0].stats = solver.stats;
+            }
+            else
+            {
+                BatchOptions opts;
+                opts.threads = std::max(ThreadPool::shared().size(), 1);
+                opts.budget = first->budget;
+                opts.search = (first->flags & FLAG_SEARCH) != 0;
+                opts.lockstep = m >= static_cast<size_t>(
+                                         LockstepSolver::LANES);
+
+                solveBatch(boards.data(), m, results.data(), opts);
+            }
+
+            // a client keeps no more requests out than there are slots,
+            // so this only waits on one that broke that promise
+            size_t claimed = 0;
+
+            for(size_t k = 0; k < m; k++)
+            {
+                RingResult* r = static_cast<RingResult*>(out.claim(claimed));
+
+                while(r == nullptr)
+                {
+                    out.publish(claimed);
+                    claimed = 0;
+
+                    if(this->stopping)
+                    {
+                        this->queued -= n;
+                        return;
+                    }
+
+                    out.waitRoom(this->busyPoll, RING_WAIT_MS);
+                    r = static_cast<RingResult*>(out.claim());
+                }
+
+                const RingRequest* req = static_cast<RingRequest*>(
+                                             in.at(k));
+                const SolveStats& stats = results[k].stats;
+
+                std::memset(r, 0, sizeof(RingResult));
+                r->id = req->id;
+
+                if(valid[k])
+                {
+                    results[k].solution.writePacked(r->solution);
+                    r->status = static_cast<unsigned char>(stats.status);
+                }
+                else
+                {
+                    std::memcpy(r->solution, req->board, Board::PACKED_SIZE);
+                    r->status = MALFORMED;
+                }
+
+                r->placements = stats.placements;
+                r->blockSingles = stats.blockSingles;
+                r->rowSingles = stats.rowSingles;
+                r->colSingles = stats.colSingles;
+                r->passes = stats.passes;
+                r->searchNodes = stats.searchNodes;
+                r->nanos = stats.nanos;
+                claimed++;
+            }
+
+            // results go out before their requests are let go, which a
+            // client opening the channel relies on
+            out.publish(claimed);
+            in.release(m);
+
+            this->requests += m;
+            this->puzzles += m;
+            this->queued -= m;
+            this->waitNanos += waited * static_cast<long long>(m);
+            raise(this->maxWaitNanos, waited);
+            n -= m;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+bool SolverDaemon::admit(Connection& conn, const SolveRequest& req)
+{
+    long long n = req.boards.size();
+    long long depth = this->queued += n;
+
+    // an empty queue takes any request, however large
+    if(this->maxQueue == 0 || depth <= static_cast<long long>(this->maxQueue)
+       || depth == n)
+    {
+        raise(this->peakQueued, depth);
+        return true;
+    }
+
+    this->queued -= n;
+    this->busy++;
+
+    std::string out;
+    appendResponse(out, req.id, RESPONSE_BUSY, req, nullptr);
+
+    this->send(conn, out);
+
+    return false;
+}
+
+//----------------------------------------------------------------------------
+int SolverDaemon::budgetFor(const SolveRequest& req, Clock::time_point arrival,
+                            long long wait)
+{
+    int budget = static_cast<int>(std::min<unsigned>(req.budget, INT_MAX));
+
+    if(req.deadline == 0)
+        return budget;
+
+    long long left = req.deadline * 1000LL - wait -
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now() - arrival).count();
+
+    // a request already out of time still gets a pass, and its boards
+    // come back with the BUDGET status
+    long long passes = std::max(left / std::max(this->passNanos.load(), 1LL),
+                                1LL);
+    passes = std::min<long long>(passes, INT_MAX);
+
+    if(budget > 0 && budget < passes)
+        return budget;
+
+    return static_cast<int>(passes);
+}
+
+//----------------------------------------------------------------------------
+void SolverDaemon::answer(Connection& conn, const SolveRequest& req,
+                          Clock::time_point arrival)
+{
+    size_t n = req.boards.size();
+    std::vector<Result> results(n);
+    long long waited = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           Clock::now() - arrival).count();
+    int budget = this->budgetFor(req, arrival, 0);
+
+    if(n == 1)
+    {
+        thread_local SudokuSolver solver;
+
+        solver.board = req.boards[0];
+        solver.budget = budget;
+        solver.search = (req.flags & FLAG_SEARCH) != 0;
+        solver.solveDriver();
+
+        results[0].solution = solver.board;
+        results[0].stats = solver.stats;
+    }
+    else if(n > 1)
+    {
+        BatchOptions opts;
+        opts.threads = ThreadPool::shared().size();
+        opts.budget = budget;
+        opts.search = (req.flags & FLAG_SEARCH) != 0;
+
+        solveBatch(req.boards.data(), n, results.data(), opts);
+    }
+
+    this->respond(conn, req, results.data(), arrival, waited);
+}
+
+//----------------------------------------------------------------------------
+void SolverDaemon::respond(Connection& conn, const SolveRequest& req,
+                           const Result* results, Clock::time_point arrival,
+                           long long waited)
+{
+    size_t n = req.boards.size();
+    std::string out;
+    appendResponse(out, req.id, RESPONSE_OK, req, results);
+
+    // the time per pass follows recent solves, an eighth at a time
+    long long nanos = 0;
+    long long passes = 0;
+
+    for(size_t i = 0; i < n; i++)
+    {
+        if(req.valid[i])
+        {
+            nanos += results[i].stats.nanos;
+            passes += results[i].stats.passes;
+        }
+    }
+
+    if(passes > 0)
+    {
+        long long est = this->passNanos;
+        this->passNanos = est + (nanos / passes - est) / 8;
+    }
+
+    if(req.deadline > 0 &&
+       Clock::now() - arrival > std::chrono::microseconds(req.deadline))
+        this->late++;
+
+    this->requests++;
+    this->puzzles += n;
+    this->queued -= n;
+    this->waitNanos += waited;
+    raise(this->maxWaitNanos, waited);
+
+    this->send(conn, out);
+}
+
+//----------------------------------------------------------------------------
+void SolverDaemon::send(Connection& conn, const std::string& out)
+{
+    {
+        std::lock_guard<std::mutex> guard(conn.writeLock);
+        if(conn.broken)
+            return;
+
+        conn.outbox += out;
+    }
+
+    conn.queued.notify_one();
+}
+
+//----------------------------------------------------------------------------
+void SolverDaemon::writeResponses(Connection& conn)
+{
+    std::string out;
+
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> guard(conn.writeLock);
+            conn.queued.wait(guard, [&conn]()
+            {
+                return !conn.outbox.empty() || conn.closing;
+            });
+
+            if(conn.outbox.empty())
+                return;
+
+            // responses queued during the last write go out together
+            out.swap(conn.outbox);
+            conn.outbox.clear();
+        }
+
+        if(!conn.broken && !writeAll(conn.fd, out.data(), out.size()))
+            conn.broken = true;
+    }
+}
+
+//----------------------------------------------------------------------------
+void SolverDaemon::report(std::ostream& out) const
+{
+    long long answered = this->requests;
+
+    out << "queue: " << this->queued << " boards (" << this->peakQueued
+        << " at most), waits of "
+        << (answered > 0 ? this->waitNanos / answered / 1000 : 0)
+        << " us on average (" << this->maxWaitNanos / 1000
+        << " us at most), " << answered << " requests answered, "
+        << this->busy << " busy, " << this->late << " late" << std::endl;
+}
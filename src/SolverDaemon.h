@@ -0,0 +1,243 @@
+#ifndef SOLVERDAEMON_H_INCLUDED
+#define SOLVERDAEMON_H_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MicroBatcher.h"
+#include "SharedRing.h"
+#include "SolverProtocol.h"
+#include "ThreadPool.h"
+
+/**
+ * The SolverDaemon class answers solve requests on a Unix domain socket,
+ * so clients skip the cost of starting a process and warming it up for
+ * every batch. See SolverProtocol.h for the messages.
+ *
+ * Every connection gets a thread that reads its requests and hands each
+ * one to the shared ThreadPool as soon as it arrives, so a client can
+ * keep many requests in flight. Responses are written back as their
+ * requests finish.
+ *
+ * With coalesce set, requests go to a MicroBatcher instead, which solves
+ * the boards of many small requests together, trading a short wait for
+ * the throughput of lockstep batches.
+ *
+ * Once maxQueue boards are waiting or being solved, new requests are
+ * answered RESPONSE_BUSY at once, so an overloaded daemon sheds work
+ * instead of letting every request wait longer. A request's deadline is
+ * turned into a pass budget from the time left and the recent time per
+ * pass.
+ *
+ * A client on the same machine can skip the socket altogether through a
+ * SharedChannel made by listenRing(), which a thread of serve() drains.
+ * Its requests are solved in runs as they are found on the ring, without
+ * the MicroBatcher, and are never answered busy: the slots of the ring
+ * bound how many the client has outstanding, whatever maxQueue is. They
+ * are still counted in the queue that socket requests are admitted
+ * against, and in the metrics of report().
+ */
+class SolverDaemon
+{
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        /**
+         * A client connection
+         */
+        struct Connection
+        {
+            int fd;                     ///< Socket of the client
+            std::mutex writeLock;       ///< Guards outbox and closing
+            std::condition_variable queued; ///< Signalled when responses
+                                            ///< are queued
+            std::string outbox;         ///< Responses not yet written
+            bool closing;               ///< Set once nothing more is queued
+            std::atomic<bool> broken;   ///< Set when a write fails
+            std::atomic<bool> done;     ///< Set when its reader is done
+            ThreadPool::Group tasks;    ///< Requests being solved
+            std::mutex pendingLock;     ///< Guards pending
+            std::condition_variable drained;    ///< Signalled when pending
+                                                ///< drops to 0
+            int pending;                ///< Requests in the batcher
+
+            Connection(int fd);
+        };
+
+        int listenFd;                   ///< Listening socket, -1 if closed
+        std::string path;               ///< Path the socket is bound to
+        std::atomic<bool> stopping;     ///< Set by stop()
+        std::vector<std::shared_ptr<Connection>> conns;    ///< Open clients
+        std::vector<std::thread> readers;   ///< One thread for each client,
+                                            ///< only used by serve()
+        std::atomic<long long> passNanos;   ///< Recent nanoseconds per pass
+        std::mutex reportLock;              ///< Guards the report wait
+        std::condition_variable served;     ///< Signalled when serve() ends
+        SharedChannel channel;              ///< Rings for a local client
+        bool ringOpen;                      ///< True once listenRing() made
+                                            ///< the channel
+
+        /**
+         * Join the readers of clients that hung up and close their sockets
+         *
+         * @param all true to wait for every reader, not only finished ones
+         */
+        void reap(bool all);
+
+        /**
+         * Read requests from a client until it hangs up
+         *
+         * @param conn client to serve
+         */
+        void serveConnection(std::shared_ptr<Connection> conn);
+
+        /**
+         * Solve the requests on the shared memory rings until stop() is
+         * called
+         */
+        void serveRing();
+
+        /**
+         * Count a request's boards as queued, unless the queue is full
+         *
+         * @param conn client that sent it, told if it is busy
+         * @param req request to admit
+         *
+         * @return false if the request was turned away
+         */
+        bool admit(Connection& conn, const SolveRequest& req);
+
+        /**
+         * Work out the pass budget of a request from its deadline
+         *
+         * @param req request to solve
+         * @param arrival when it was read
+         * @param wait nanoseconds it is still expected to wait
+         *
+         * @return most passes per board, 0 for no limit
+         */
+        int budgetFor(const SolveRequest& req, Clock::time_point arrival,
+                      long long wait);
+
+        /**
+         * Solve a request and write its response
+         *
+         * @param conn client that sent it
+         * @param req request to answer
+         * @param arrival when it was read
+         */
+        void answer(Connection& conn, const SolveRequest& req,
+                    Clock::time_point arrival);
+
+        /**
+         * Queue the response to a solved request and count it
+         *
+         * @param conn client that sent it
+         * @param req request to answer
+         * @param results result for each board of the request
+         * @param arrival when it was read
+         * @param waited nanoseconds it waited to be solved
+         */
+        void respond(Connection& conn, const SolveRequest& req,
+                     const Result* results, Clock::time_point arrival,
+                     long long waited);
+
+        /**
+         * Queue responses for a client's writer, without blocking on the
+         * socket
+         *
+         * @param conn client to write to
+         * @param out whole frames to write
+         */
+        void send(Connection& conn, const std::string& out);
+
+        /**
+         * Write the responses queued for a client until it is closing
+         *
+         * @param conn client to write to
+         */
+        void writeResponses(Connection& conn);
+
+    public:
+        int threads;                    ///< Pool workers, 0 for one per core
+        bool coalesce;                  ///< Solve requests in micro-batches
+        MicroBatcher batcher;           ///< Forms the micro-batches
+        size_t maxQueue;                ///< Most boards waiting or being
+                                        ///< solved, 0 for no limit
+        int reportEvery;                ///< Seconds between reports from
+                                        ///< serve(), 0 for none
+        bool busyPoll;                  ///< Spin on the rings instead of
+                                        ///< sleeping when they are empty
+        std::atomic<long long> requests;    ///< Requests answered
+        std::atomic<long long> puzzles;     ///< Boards solved
+        std::atomic<long long> queued;      ///< Boards waiting or being
+                                            ///< solved
+        std::atomic<long long> peakQueued;  ///< Most boards queued at once
+        std::atomic<long long> busy;        ///< Requests turned away
+        std::atomic<long long> late;        ///< Requests answered after
+                                            ///< their deadline
+        std::atomic<long long> waitNanos;   ///< Total wait to be solved
+        std::atomic<long long> maxWaitNanos;    ///< Longest wait
+
+        /**
+         * Default Constructor
+         */
+        SolverDaemon();
+
+        /**
+         * Destructor, closes the socket
+         */
+        ~SolverDaemon();
+
+        /**
+         * Create the socket and start listening, replacing any socket
+         * file left at the path
+         *
+         * @param path file system path of the socket
+         *
+         * @return true if the socket is listening
+         */
+        bool listen(const char* path);
+
+        /**
+         * Make a shared memory channel for a client on the same machine,
+         * served alongside the socket
+         *
+         * @param path file for the channel, under /dev/shm to keep it in
+         *        memory, removed when the daemon is done
+         * @param slots slots in each of its rings
+         *
+         * @return true if the channel was made
+         */
+        bool listenRing(const char* path, size_t slots);
+
+        /**
+         * Accept and serve clients until stop() is called, then wait for
+         * the clients being served
+         */
+        void serve();
+
+        /**
+         * Make serve() return, safe to call from a signal handler
+         */
+        void stop();
+
+        /**
+         * Print the queue metrics on a line
+         *
+         * @param out stream to print to
+         */
+        void report(std::ostream& out) const;
+
+    private:
+        SolverDaemon(const SolverDaemon&);
+        SolverDaemon& operator=(const SolverDaemon&);
+};
+#endif
@@ -0,0 +1,198 @@
+#include <cerrno>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "SolverProtocol.h"
+
+static const size_t REQUEST_HEADER = 20;
+static const size_t RESPONSE_HEADER = 12;
+static const size_t RESULT_SIZE = 82;
+
+/**
+ * Add a 4 byte integer in little endian order
+ */
+static void putU32(std::string& out, unsigned val)
+{
+    char bytes[4];
+
+    for(int i = 0; i < 4; i++)
+        bytes[i] = static_cast<char>(val >> (8 * i));
+
+    out.append(bytes, 4);
+}
+
+/**
+ * Load a 4 byte integer stored in little endian order
+ */
+static unsigned getU32(const char* in)
+{
+    unsigned val = 0;
+
+    for(int i = 0; i < 4; i++)
+        val |= static_cast<unsigned>(static_cast<unsigned char>(in[i]))
+               << (8 * i);
+
+    return val;
+}
+
+//----------------------------------------------------------------------------
+void appendRequest(std::string& out, unsigned id, unsigned flags,
+                   unsigned budget, const Board* boards, size_t n,
+                   unsigned deadline)
+{
+    putU32(out, REQUEST_HEADER + 81 * n);
+    putU32(out, id);
+    putU32(out, flags);
+    putU32(out, budget);
+    putU32(out, deadline);
+    putU32(out, n);
+
+    size_t at = out.size();
+    out.resize(at + 81 * n);
+
+    for(size_t i = 0; i < n; i++)
+        boards[i].writeLine(&out[at + 81 * i]);
+}
+
+//----------------------------------------------------------------------------
+bool parseRequest(const char* body, size_t len, SolveRequest& req)
+{
+    if(len < REQUEST_HEADER)
+        return false;
+
+    size_t n = getU32(body + 16);
+    if(len != REQUEST_HEADER + 81 * n)
+        return false;
+
+    req.id = getU32(body);
+    req.flags = getU32(body + 4);
+    req.budget = getU32(body + 8);
+    req.deadline = getU32(body + 12);
+    req.boards.resize(n);
+    req.valid.resize(n);
+
+    for(size_t i = 0; i < n; i++)
+        req.valid[i] = req.boards[i].readLine(body + REQUEST_HEADER + 81 * i,
+                                              81);
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+void appendResponse(std::string& out, unsigned id, unsigned status,
+                    const SolveRequest& req, const Result* results)
+{
+    size_t n = (status == RESPONSE_OK) ? req.boards.size() : 0;
+
+    putU32(out, RESPONSE_HEADER + RESULT_SIZE * n);
+    putU32(out, id);
+    putU32(out, status);
+    putU32(out, n);
+
+    size_t at = out.size();
+    out.resize(at + RESULT_SIZE * n);
+
+    for(size_t i = 0; i < n; i++)
+    {
+        char* rec = &out[at + RESULT_SIZE * i];
+
+        if(req.valid[i])
+        {
+            results[i].solution.writeLine(rec);
+            rec[81] = static_cast<char>(results[i].stats.status);
+        }
+        else
+        {
+            std::memset(rec, '.', 81);
+            rec[81] = static_cast<char>(MALFORMED);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+bool parseResponse(const char* body, size_t len, SolveResponse& resp)
+{
+    if(len < RESPONSE_HEADER)
+        return false;
+
+    size_t n = getU32(body + 8);
+    if(len != RESPONSE_HEADER + RESULT_SIZE * n)
+        return false;
+
+    resp.id = getU32(body);
+    resp.status = getU32(body + 4);
+    resp.boards.resize(n);
+    resp.statuses.resize(n);
+
+    for(size_t i = 0; i < n; i++)
+    {
+        const char* rec = body + RESPONSE_HEADER + RESULT_SIZE * i;
+
+        resp.boards[i].readLine(rec, 81);
+        resp.statuses[i] = static_cast<unsigned char>(rec[81]);
+    }
+
+    return true;
+}
+
+/**
+ * Read exactly len bytes, retrying short reads
+ */
+static bool readAll(int fd, char* data, size_t len)
+{
+    while(len > 0)
+    {
+        ssize_t n = ::read(fd, data, len);
+
+        if(n < 0 && errno == EINTR)
+            continue;
+
+        if(n <= 0)
+            return false;
+
+        data += n;
+        len -= n;
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+bool readFrame(int fd, std::string& body)
+{
+    char prefix[4];
+
+    if(!readAll(fd, prefix, 4))
+        return false;
+
+    size_t len = getU32(prefix);
+    if(len > MAX_FRAME)
+        return false;
+
+    body.resize(len);
+
+    return len == 0 || readAll(fd, &body[0], len);
+}
+
+//----------------------------------------------------------------------------
+bool writeAll(int fd, const char* data, size_t len)
+{
+    while(len > 0)
+    {
+        // a client that went away must not kill the process
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+
+        if(n < 0 && errno == EINTR)
+            continue;
+
+        if(n <= 0)
+            return false;
+
+        data += n;
+        len -= n;
+    }
+
+    return true;
+}
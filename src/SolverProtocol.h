@@ -0,0 +1,147 @@
+#ifndef SOLVERPROTOCOL_H_INCLUDED
+#define SOLVERPROTOCOL_H_INCLUDED
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Board.h"
+#include "SolveBatch.h"
+
+/**
+ * \file
+ * Messages between the solver daemon and its clients
+ *
+ * Every message is a frame, a 4 byte length followed by that many bytes.
+ * All integers are little endian.
+ *
+ *     request   4 byte id, 4 byte flags, 4 byte budget, 4 byte deadline,
+ *               4 byte count, then count boards of 81 characters in the
+ *               line format
+ *     response  4 byte id, 4 byte status, 4 byte count,
+ *               then count results, each 81 characters of the board the
+ *               solver left and a 1 byte SolveStatus, or 255 for a board
+ *               that could not be read
+ *
+ * The id of a response is that of its request. A client may send any
+ * number of requests without waiting, and responses come back as their
+ * requests are done, which need not be the order they were sent in.
+ *
+ * The deadline is in microseconds from when the daemon reads the request,
+ * 0 for none. The daemon turns the time left into a pass budget, so
+ * boards it cannot finish in time come back with the BUDGET status. A
+ * daemon with too much work queued answers RESPONSE_BUSY, without any
+ * results, and the request may be sent again later.
+ */
+
+static const size_t MAX_FRAME = 64 << 20;       ///< Longest frame taken
+static const unsigned FLAG_SEARCH = 1;          ///< Request flag to guess
+static const unsigned char MALFORMED = 255;     ///< Result of a bad board
+
+/**
+ * Status of a whole response
+ */
+enum ResponseStatus
+{
+    RESPONSE_OK,                ///< Every board has a result
+    RESPONSE_BAD_REQUEST,       ///< The request could not be read
+    RESPONSE_BUSY               ///< The daemon has too much queued
+};
+
+/**
+ * A request as it is read off the wire
+ */
+struct SolveRequest
+{
+    unsigned id;                ///< Id chosen by the client
+    unsigned flags;             ///< FLAG_SEARCH or nothing
+    unsigned budget;            ///< Most passes per board, 0 for no limit
+    unsigned deadline;          ///< Microseconds to answer in, 0 for no
+                                ///< limit
+    std::vector<Board> boards;  ///< Boards to solve
+    std::vector<bool> valid;    ///< False for boards that could not be read
+};
+
+/**
+ * A response as it is read off the wire
+ */
+struct SolveResponse
+{
+    unsigned id;                ///< Id of the request answered
+    unsigned status;            ///< ResponseStatus of the whole response
+    std::vector<Board> boards;  ///< Boards the solver left
+    std::vector<unsigned char> statuses;    ///< SolveStatus of each board,
+                                            ///< or MALFORMED
+};
+
+/**
+ * Add a request frame to a buffer
+ *
+ * @param out buffer to add to
+ * @param id id of the request
+ * @param flags FLAG_SEARCH or nothing
+ * @param budget most passes per board, 0 for no limit
+ * @param boards boards to solve
+ * @param n number of boards
+ * @param deadline microseconds to answer in, 0 for no limit
+ */
+void appendRequest(std::string& out, unsigned id, unsigned flags,
+                   unsigned budget, const Board* boards, size_t n,
+                   unsigned deadline = 0);
+
+/**
+ * Read the body of a request frame
+ *
+ * @param body bytes after the length
+ * @param len number of bytes
+ * @param req request read
+ *
+ * @return false if the body is not a well formed request
+ */
+bool parseRequest(const char* body, size_t len, SolveRequest& req);
+
+/**
+ * Add a response frame to a buffer
+ *
+ * @param out buffer to add to
+ * @param id id of the request answered
+ * @param status ResponseStatus of the whole response
+ * @param req request answered, for the boards that could not be read
+ * @param results results for the boards of the request
+ */
+void appendResponse(std::string& out, unsigned id, unsigned status,
+                    const SolveRequest& req, const Result* results);
+
+/**
+ * Read the body of a response frame
+ *
+ * @param body bytes after the length
+ * @param len number of bytes
+ * @param resp response read
+ *
+ * @return false if the body is not a well formed response
+ */
+bool parseResponse(const char* body, size_t len, SolveResponse& resp);
+
+/**
+ * Read one frame from a socket
+ *
+ * @param fd socket to read
+ * @param body set to the bytes after the length
+ *
+ * @return false at the end of the stream, on an error, or if the frame
+ *         is longer than MAX_FRAME
+ */
+bool readFrame(int fd, std::string& body);
+
+/**
+ * Write a whole buffer to a socket
+ *
+ * @param fd socket to write
+ * @param data bytes to write
+ * @param len number of bytes
+ *
+ * @return false if the socket failed
+ */
+bool writeAll(int fd, const char* data, size_t len);
+#endif
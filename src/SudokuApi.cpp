@@ -0,0 +1,259 @@
+#include <climits>
+#include <vector>
+
+#include "LockstepSolver.h"
+#include "SolveBatch.h"
+#include "SudokuApi.h"
+#include "SudokuSolver.h"
+
+/**
+ * What a sudoku_solver handle points at
+ */
+struct sudoku_solver
+{
+    SudokuSolver solver;            ///< Solver for single boards
+    std::vector<Board> boards;      ///< Readable boards of a batch
+    std::vector<Result> results;    ///< Their results
+    std::vector<size_t> places;     ///< Where each came from in the batch
+};
+
+/**
+ * Load a caller's board into a Board
+ *
+ * @return false if a cell is above 9
+ */
+static bool load(const sudoku_board& in, Board& out)
+{
+    int cells[81];
+
+    for(int i = 0; i < 81; i++)
+    {
+        if(in.cells[i] > 9)
+            return false;
+
+        cells[i] = in.cells[i] == 0 ? -1 : in.cells[i];
+    }
+
+    out.loadCells(cells);
+
+    return true;
+}
+
+/**
+ * Copy a Board out into a caller's board
+ */
+static void save(const Board& in, sudoku_board& out)
+{
+    int cells[81];
+    in.saveCells(cells);
+
+    for(int i = 0; i < 81; i++)
+        out.cells[i] = static_cast<unsigned char>(cells[i] == -1 ? 0
+                                                                 : cells[i]);
+}
+
+/**
+ * Copy the counts of a solve out
+ */
+static void save(const SolveStats& in, sudoku_stats& out)
+{
+    out.status = in.status;
+    out.placements = in.placements;
+    out.passes = in.passes;
+    out.reserved = 0;
+    out.search_nodes = in.searchNodes;
+    out.nanos = in.nanos;
+}
+
+/**
+ * Counts of a board that could not be solved because it could not be read
+ */
+static void malformed(sudoku_stats& out)
+{
+    out = sudoku_stats();
+    out.status = SUDOKU_MALFORMED;
+}
+
+//----------------------------------------------------------------------------
+int sudoku_abi_version(void)
+{
+    return SUDOKU_ABI_VERSION;
+}
+
+//----------------------------------------------------------------------------
+sudoku_solver* sudoku_new(void)
+{
+    // the solver allocates as it is made, so nothrow new is not enough
+    try
+    {
+        return new sudoku_solver();
+    }
+    catch(...)
+    {
+        return nullptr;
+    }
+}
+
+//----------------------------------------------------------------------------
+void sudoku_free(sudoku_solver* solver)
+{
+    delete solver;
+}
+
+//----------------------------------------------------------------------------
+int sudoku_parse(const char* text, size_t len, sudoku_board* board)
+{
+    try
+    {
+        // a Board keeps its cells on the heap, so one is reused for every
+        // call on the thread rather than made for each
+        thread_local Board b;
+
+        if(len > INT_MAX)
+            return SUDOKU_MALFORMED;
+
+        if(!b.readLine(text, static_cast<int>(len)))
+            return SUDOKU_MALFORMED;
+
+        save(b, *board);
+
+        return 0;
+    }
+    catch(...)
+    {
+        return SUDOKU_ERROR;
+    }
+}
+
+//----------------------------------------------------------------------------
+void sudoku_format(const sudoku_board* board, char* text)
+{
+    for(int i = 0; i < 81; i++)
+        text[i] = board->cells[i] == 0 ? '.'
+                                       : static_cast<char>('0' +
+                                                           board->cells[i]);
+}
+
+//----------------------------------------------------------------------------
+int sudoku_solve(sudoku_solver* solver, sudoku_board* board, unsigned flags,
+                 int budget, sudoku_stats* stats)
+{
+    SudokuSolver& s = solver->solver;
+
+    if(!load(*board, s.board))
+    {
+        if(stats != nullptr)
+            malformed(*stats);
+
+        return SUDOKU_MALFORMED;
+    }
+
+    s.search = (flags & SUDOKU_SEARCH) != 0;
+    s.budget = budget > 0 ? budget : 0;
+
+    try
+    {
+        s.solveDriver();
+    }
+    catch(...)
+    {
+        return SUDOKU_ERROR;
+    }
+
+    save(s.board, *board);
+    if(stats != nullptr)
+        save(s.stats, *stats);
+
+    return s.stats.status;
+}
+
+//----------------------------------------------------------------------------
+long long sudoku_solve_batch(sudoku_solver* solver, sudoku_board* boards,
+                             size_t n, unsigned flags, int budget,
+                             int threads, sudoku_stats* stats)
+{
+    // boards that cannot be read are left out of the batch
+    size_t m = 0;
+
+    BatchOptions opts;
+    opts.threads = threads > 0 ? threads : 0;
+    opts.budget = budget > 0 ? budget : 0;
+    opts.search = (flags & SUDOKU_SEARCH) != 0;
+
+    // nothing the caller owns is written until the batch is solved, so a
+    // failure leaves it all as it was
+    try
+    {
+        // places grows last, so a batch that failed part way through
+        // growing them grows them all again
+        if(solver->places.size() < n)
+        {
+            solver->boards.resize(n);
+            solver->results.resize(n);
+            solver->places.resize(n);
+        }
+
+        for(size_t i = 0; i < n; i++)
+        {
+            if(load(boards[i], solver->boards[m]))
+                solver->places[m++] = i;
+        }
+
+        opts.lockstep = m >= static_cast<size_t>(LockstepSolver::LANES);
+
+        solveBatch(solver->boards.data(), m, solver->results.data(), opts);
+    }
+    catch(...)
+    {
+        return SUDOKU_ERROR;
+    }
+
+    // boards left out of the batch stay malformed
+    if(stats != nullptr)
+    {
+        for(size_t i = 0; i < n; i++)
+            malformed(stats[i]);
+    }
+
+    long long solved = 0;
+
+    for(size_t k = 0; k < m; k++)
+    {
+        const Result& r = solver->results[k];
+        size_t i = solver->places[k];
+
+        save(r.solution, boards[i]);
+        if(stats != nullptr)
+            save(r.stats, stats[i]);
+
+        solved += r.stats.status == SOLVED;
+    }
+
+    return solved;
+}
+
+//----------------------------------------------------------------------------
+long long sudoku_count_solutions(sudoku_solver* solver,
+                                 const sudoku_board* board, long long limit,
+                                 sudoku_board* solution)
+{
+    SudokuSolver& s = solver->solver;
+    long long found;
+
+    if(!load(*board, s.board))
+        return SUDOKU_MALFORMED;
+
+    try
+    {
+        found = s.countSolutions(limit);
+    }
+    catch(...)
+    {
+        return SUDOKU_ERROR;
+    }
+
+    if(solution != nullptr)
+        save(s.board, *solution);
+
+    return found;
+}
@@ -0,0 +1,172 @@
+#ifndef SUDOKUAPI_H_INCLUDED
+#define SUDOKUAPI_H_INCLUDED
+
+#include <stddef.h>
+
+/**
+ * \file
+ * C interface to the solver, built into libsudoku.so and libsudoku.a
+ *
+ * Every buffer belongs to the caller: boards are solved in place and
+ * counts are written to structs the caller passes in. The only memory
+ * the library keeps is in a sudoku_solver, which grows to fit the largest
+ * batch it has seen and is reused, so once warm a solver does not
+ * allocate per board; handing a batch to the thread pool costs a couple
+ * of small allocations however many boards it holds. A sudoku_solver may
+ * be used by one thread at a time; threads that solve at once each need
+ * their own.
+ *
+ * No C++ exception leaves the library. A call that fails inside it, for
+ * want of memory or threads, returns SUDOKU_ERROR and leaves the caller's
+ * boards and counts as they were.
+ *
+ * Functions are only ever added, and structs only grow into their
+ * reserved fields, so code built against this header keeps working with
+ * later libraries of the same SUDOKU_ABI_VERSION.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define SUDOKU_API __attribute__((visibility("default")))
+#else
+#define SUDOKU_API
+#endif
+
+#define SUDOKU_ABI_VERSION 1    /**< Changes when old callers would break */
+
+#define SUDOKU_SEARCH 1         /**< Flag to guess when cross checking is
+                                     stuck */
+
+#define SUDOKU_SOLVED 0         /**< Every space was filled */
+#define SUDOKU_STUCK 1          /**< No more numbers could be placed */
+#define SUDOKU_CONTRADICTION 2  /**< The board has no solution */
+#define SUDOKU_BUDGET 3         /**< The solve ran out of passes */
+#define SUDOKU_MALFORMED (-1)   /**< The board holds a cell above 9 */
+#define SUDOKU_ERROR (-2)       /**< The library failed, out of memory or
+                                     unable to start a thread */
+
+/**
+ * A board, row by row, 0 for an empty space and 1 to 9 otherwise
+ */
+typedef struct sudoku_board
+{
+    unsigned char cells[81];
+} sudoku_board;
+
+/**
+ * Counts kept while solving a board
+ */
+typedef struct sudoku_stats
+{
+    int status;                 /**< SUDOKU_SOLVED and so on */
+    int placements;             /**< Numbers placed on the board */
+    int passes;                 /**< Passes made over the whole board */
+    int reserved;               /**< Always 0 */
+    long long search_nodes;     /**< Guesses tried */
+    long long nanos;            /**< Time taken by the solve */
+} sudoku_stats;
+
+/**
+ * A solver and the memory it reuses between calls
+ */
+typedef struct sudoku_solver sudoku_solver;
+
+/**
+ * Get the version of the interface the library was built with
+ *
+ * @return SUDOKU_ABI_VERSION of the library
+ */
+SUDOKU_API int sudoku_abi_version(void);
+
+/**
+ * Make a solver
+ *
+ * @return the solver, or NULL if there is no memory for it
+ */
+SUDOKU_API sudoku_solver* sudoku_new(void);
+
+/**
+ * Release a solver and everything it kept
+ *
+ * @param solver solver from sudoku_new(), or NULL
+ */
+SUDOKU_API void sudoku_free(sudoku_solver* solver);
+
+/**
+ * Read a board written as a line of 81 characters, 1 to 9 for numbers
+ * and '.' or '0' for empty spaces, trailing whitespace ignored
+ *
+ * @param text characters to read, not NUL terminated
+ * @param len number of characters
+ * @param board set to the board read
+ *
+ * @return 0, or SUDOKU_MALFORMED if the text is not a board, leaving
+ *         board untouched, or SUDOKU_ERROR
+ */
+SUDOKU_API int sudoku_parse(const char* text, size_t len,
+                            sudoku_board* board);
+
+/**
+ * Write a board as a line of 81 characters, '.' for empty spaces
+ *
+ * @param board board to write
+ * @param text room for 81 characters, no NUL is added
+ */
+SUDOKU_API void sudoku_format(const sudoku_board* board, char* text);
+
+/**
+ * Solve a board in place
+ *
+ * @param solver solver to use
+ * @param board board to solve, left as far as the solver got
+ * @param flags SUDOKU_SEARCH or 0
+ * @param budget most passes, 0 for no limit
+ * @param stats set to the counts of the solve, or NULL
+ *
+ * @return status of the solve, SUDOKU_MALFORMED, or SUDOKU_ERROR
+ */
+SUDOKU_API int sudoku_solve(sudoku_solver* solver, sudoku_board* board,
+                            unsigned flags, int budget, sudoku_stats* stats);
+
+/**
+ * Solve many boards in place on the library's thread pool
+ *
+ * @param solver solver to use
+ * @param boards boards to solve
+ * @param n number of boards
+ * @param flags SUDOKU_SEARCH or 0
+ * @param budget most passes per board, 0 for no limit
+ * @param threads threads to solve on, 0 for one per core
+ * @param stats set to the counts of each board, or NULL
+ *
+ * @return number of boards solved, or SUDOKU_ERROR
+ */
+SUDOKU_API long long sudoku_solve_batch(sudoku_solver* solver,
+                                        sudoku_board* boards, size_t n,
+                                        unsigned flags, int budget,
+                                        int threads, sudoku_stats* stats);
+
+/**
+ * Count the solutions of a board, up to a limit
+ * A limit of 2 is enough to tell whether a puzzle has a unique solution.
+ *
+ * @param solver solver to use
+ * @param board board to count the solutions of
+ * @param limit most solutions to count
+ * @param solution set to the first solution found, or NULL
+ *
+ * @return number of solutions, no more than limit, SUDOKU_MALFORMED, or
+ *         SUDOKU_ERROR
+ */
+SUDOKU_API long long sudoku_count_solutions(sudoku_solver* solver,
+                                            const sudoku_board* board,
+                                            long long limit,
+                                            sudoku_board* solution);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
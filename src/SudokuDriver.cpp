@@ -1,21 +1,1093 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
 #include <iostream>
 #include <fstream>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "SudokuSolver.h"
+#include "BatchRunner.h"
+#include "PuzzleReader.h"
+#include "OutputBuffer.h"
+#include "PackedCorpus.h"
+#include "PuzzleGenerator.h"
+#include "SolveBatch.h"
+#include "SolutionStore.h"
+#include "ShardRunner.h"
+#include "SolverClient.h"
+#include "SharedRing.h"
+#include "SolverDaemon.h"
 
 /**
  * \file
  * Driver that runs the solver
  */
 
+/**
+ * Entries a store made by --batch --store has room for
+ */
+static const unsigned long long STORE_CAPACITY = 1 << 20;
+
+/**
+ * Print how the program is meant to be called
+ */
+void usage()
+{
+    std::cout << "Usage: bin/sudoku-solver [input file]\n"
+              << "       bin/sudoku-solver --batch [batch options]"
+              << " [input file | -]\n"
+              << "       bin/sudoku-solver --pack [--ids] [input file | -]"
+              << " [output file | -]\n"
+              << "       bin/sudoku-solver --unpack [input file]"
+              << " [output file | -]\n"
+              << "       bin/sudoku-solver --build-store [store options]"
+              << " store [input file | -]\n"
+              << "       bin/sudoku-solver --generate N [generate options]\n"
+              << "       bin/sudoku-solver --daemon socket [daemon options]\n"
+              << "       bin/sudoku-solver --client socket [client options]"
+              << " [input file | -]\n\n"
+              << "batch options:\n"
+              << "  --pretty       print solutions as bordered grids\n"
+              << "  --jsonl        print a JSON record for each puzzle\n"
+              << "  --csv          print a CSV record for each puzzle\n"
+              << "  --with-puzzle  print each puzzle before its solution\n"
+              << "  --threads N    solve on N threads, 0 for one per core\n"
+              << "  --uring        read and write files through io_uring\n"
+              << "  --lockstep     solve 16 puzzles at a time with SIMD\n"
+              << "  --numa         split the threads over the NUMA nodes\n"
+              << "  --search       guess on puzzles that get stuck\n"
+              << "  --canonical    reuse solves of equivalent puzzles\n"
+              << "  --cache-mb N   reuse solves of repeated puzzles, keeping\n"
+              << "                 up to N MB of them\n"
+              << "  --store FILE   answer puzzles kept in a solution store"
+              << " and keep\n"
+              << "                 new ones, creating it if needed\n"
+              << "  --shards N     solve on N worker processes, each writing"
+              << " its own\n"
+              << "                 results, joined in input order at the end\n"
+              << "  --shard-dir D  keep the shard results in D, the input"
+              << " with .shards\n"
+              << "                 added by default\n"
+              << "  --resume       only redo the shards an earlier run did"
+              << " not finish\n\n"
+              << "pack options:\n"
+              << "  --ids          number packed records in input order\n\n"
+              << "generate options:\n"
+              << "  --pretty       print puzzles as bordered grids\n"
+              << "  --jsonl        print a JSON record for each puzzle\n"
+              << "  --csv          print a CSV record for each puzzle\n"
+              << "  --with-solution  print each solution after its puzzle\n"
+              << "  --threads N    generate on N threads, 0 for one per core\n"
+              << "  --seed S       seed of the run, 1 by default\n\n"
+              << "store options:\n"
+              << "  --threads N    solve on N threads, 0 for one per core\n"
+              << "  --search       guess on puzzles that get stuck\n\n"
+              << "daemon options:\n"
+              << "  --threads N    solve on N threads, 0 for one per core\n"
+              << "  --window-us N  solve requests together in batches,"
+              << " waiting up to\n"
+              << "                 N microseconds to fill them\n"
+              << "  --max-batch N  puzzles in each of those batches, 256 by"
+              << " default\n"
+              << "  --slo-us N     shorten the wait when requests take longer"
+              << " than N\n"
+              << "                 microseconds, 1000 by default\n"
+              << "  --max-queue N  answer busy once N puzzles are waiting or"
+              << " being\n"
+              << "                 solved, 0 for no limit\n"
+              << "  --report-every S  print the queue metrics every S"
+              << " seconds\n"
+              << "  --ring FILE    also take requests from a local client"
+              << " through\n"
+              << "                 shared memory rings in FILE\n"
+              << "  --ring-slots N slots in each ring, 1024 by default\n"
+              << "  --busy-poll    spin on the rings instead of sleeping\n\n"
+              << "client options:\n"
+              << "  --search       guess on puzzles that get stuck\n"
+              << "  --batch-size N puzzles sent in each request, 256 by"
+              << " default\n"
+              << "  --depth N      requests in flight at once, 64 by default\n"
+              << "  --deadline-us N  give up on puzzles not solved within N"
+              << " microseconds\n"
+              << "  --ring         socket is the ring file of a daemon on"
+              << " this machine\n"
+              << "  --busy-poll    spin on the rings instead of sleeping"
+              << std::endl;
+}
+
+/**
+ * Solve every puzzle in a file, or standard input, one line at a time
+ *
+ * @param path file to read, "-" for standard input
+ * @param runner runner set up with the batch options
+ * @param uring true if files are read and written through io_uring
+ * @param out buffer for the results
+ *
+ * @return exit status of the program
+ */
+int runBatch(const char* path, BatchRunner& runner, bool uring,
+             OutputBuffer& out)
+{
+    PuzzleReader reader;
+    PackedReader packed;
+
+    // packed corpora are read record by record
+    if(std::strcmp(path, "-") != 0 && PackedReader::isPacked(path))
+    {
+        if(!packed.open(path))
+        {
+            std::cerr << path << " is not a valid packed corpus" << std::endl;
+            return -1;
+        }
+
+        runner.run(packed, 0, packed.size(), out);
+        runner.summary(std::cerr);
+
+        return out.flush() ? 0 : -1;
+    }
+
+    // regular files are mapped, pipes fall back to buffered reads
+    bool opened = uring ? reader.openAsync(path) : reader.open(path);
+
+    if(!opened)
+    {
+        std::cerr << "Unable to open " << path << std::endl;
+        return -1;
+    }
+
+    if(reader.isAsync() && !reader.usesUring())
+        std::cerr << "io_uring unavailable, reading with pread\n";
+
+    runner.run(reader, out);
+    runner.summary(std::cerr);
+
+    if(reader.hasFailed())
+    {
+        std::cerr << "Error reading " << path << std::endl;
+        out.flush();
+        return -1;
+    }
+
+    return out.flush() ? 0 : -1;
+}
+
+/**
+ * Read the next puzzle of a file in the line format
+ * Blank lines and comments are skipped as BatchRunner skips them, and
+ * malformed records are reported and skipped.
+ *
+ * @param reader file of puzzles
+ * @param b set to the puzzle read
+ * @param lineNum line number of the last line read, advanced past it
+ *
+ * @return false at the end of the file
+ */
+static bool nextPuzzle(PuzzleReader& reader, Board& b,
+                       unsigned long long& lineNum)
+{
+    const char* rec;
+    int len;
+
+    while(reader.next(rec, len))
+    {
+        lineNum++;
+
+        if(BatchRunner::isSkipped(rec, len))
+            continue;
+
+        if(b.readLine(rec, len))
+            return true;
+
+        std::cerr << "line " << lineNum << ": malformed record\n";
+    }
+
+    return false;
+}
+
+/**
+ * Convert puzzles in the line format to a packed corpus
+ *
+ * @param in file of puzzles, "-" for standard input
+ * @param outPath packed corpus to create, "-" for standard output
+ * @param withIds true if records are numbered in input order
+ *
+ * @return exit status of the program
+ */
+int pack(const char* in, const char* outPath, bool withIds)
+{
+    PuzzleReader reader;
+    PackedWriter writer;
+    Board b;
+
+    if(!reader.open(in))
+    {
+        std::cerr << "Unable to open " << in << std::endl;
+        return -1;
+    }
+
+    if(!writer.open(outPath, withIds))
+    {
+        std::cerr << "Unable to create " << outPath << std::endl;
+        return -1;
+    }
+
+    unsigned long long lineNum = 0;
+    unsigned long long id = 0;
+
+    while(nextPuzzle(reader, b, lineNum))
+        writer.write(b, 0, id++);
+
+    return writer.close() ? 0 : -1;
+}
+
+/**
+ * Convert a packed corpus back to puzzles in the line format
+ *
+ * @param in packed corpus to read
+ * @param out buffer the puzzles are written to
+ *
+ * @return exit status of the program
+ */
+int unpack(const char* in, OutputBuffer& out)
+{
+    PackedReader reader;
+    Board b;
+
+    if(!reader.open(in))
+    {
+        std::cerr << in << " is not a valid packed corpus" << std::endl;
+        return -1;
+    }
+
+    for(unsigned long long n = 0; n < reader.size(); n++)
+    {
+        if(!reader.read(n, b))
+        {
+            std::cerr << "record " << n << ": malformed record\n";
+            continue;
+        }
+
+        out.appendLine(b);
+    }
+
+    return out.flush() ? 0 : -1;
+}
+
+/**
+ * Solve a corpus and keep the results in a new solution store
+ *
+ * @param storePath store to create
+ * @param in puzzles in the line format or a packed corpus, "-" for
+ *        standard input
+ * @param opts settings for solving
+ *
+ * @return exit status of the program
+ */
+int buildStore(const char* storePath, const char* in,
+               const BatchOptions& opts)
+{
+    std::vector<Board> puzzles;
+    Board b;
+
+    if(std::strcmp(in, "-") != 0 && PackedReader::isPacked(in))
+    {
+        PackedReader packed;
+
+        if(!packed.open(in))
+        {
+            std::cerr << in << " is not a valid packed corpus" << std::endl;
+            return -1;
+        }
+
+        for(unsigned long long n = 0; n < packed.size(); n++)
+        {
+            if(packed.read(n, b))
+                puzzles.push_back(b);
+            else
+                std::cerr << "record " << n << ": malformed record\n";
+        }
+    }
+    else
+    {
+        PuzzleReader reader;
+
+        if(!reader.open(in))
+        {
+            std::cerr << "Unable to open " << in << std::endl;
+            return -1;
+        }
+
+        unsigned long long lineNum = 0;
+
+        while(nextPuzzle(reader, b, lineNum))
+            puzzles.push_back(b);
+    }
+
+    std::vector<Result> results(puzzles.size());
+    solveBatch(puzzles.data(), puzzles.size(), results.data(), opts);
+
+    if(!SolutionStore::build(storePath, puzzles.data(), results.data(),
+                             puzzles.size(), opts.search))
+    {
+        std::cerr << "Unable to create " << storePath << std::endl;
+        return -1;
+    }
+
+    std::cerr << puzzles.size() << " puzzles stored in " << storePath
+              << std::endl;
+
+    return 0;
+}
+
+/**
+ * Daemon stopped by SIGINT and SIGTERM
+ */
+static SolverDaemon* runningDaemon = nullptr;
+
+/**
+ * Stop the running daemon
+ */
+static void stopDaemon(int)
+{
+    if(runningDaemon != nullptr)
+        runningDaemon->stop();
+}
+
+/**
+ * Serve solve requests on a socket until interrupted
+ *
+ * @param sock path of the socket
+ * @param ring path of the shared memory channel, nullptr for none
+ * @param ringSlots slots in each of its rings
+ * @param daemon daemon set up with the daemon options
+ *
+ * @return exit status of the program
+ */
+int runDaemon(const char* sock, const char* ring, size_t ringSlots,
+              SolverDaemon& daemon)
+{
+    if(!daemon.listen(sock))
+    {
+        std::cerr << "Unable to listen on " << sock << std::endl;
+        return -1;
+    }
+
+    if(ring != nullptr && !daemon.listenRing(ring, ringSlots))
+    {
+        std::cerr << "Unable to make " << ring << std::endl;
+        return -1;
+    }
+
+    runningDaemon = &daemon;
+    signal(SIGINT, stopDaemon);
+    signal(SIGTERM, stopDaemon);
+
+    daemon.serve();
+
+    runningDaemon = nullptr;
+    std::cerr << daemon.requests << " requests, " << daemon.puzzles
+              << " puzzles" << std::endl;
+
+    if(daemon.coalesce)
+        std::cerr << daemon.batcher.batches << " batches, window "
+                  << daemon.batcher.window() << " us" << std::endl;
+
+    daemon.report(std::cerr);
+
+    return 0;
+}
+
+/**
+ * Milliseconds a ring client waits for a result before giving up on the
+ * daemon
+ */
+static const int RING_TIMEOUT_MS = 10000;
+
+/**
+ * Read the puzzles of a file for a client, reporting malformed records
+ *
+ * @param in file of puzzles, "-" for standard input
+ * @param puzzles puzzles read
+ *
+ * @return false if the file could not be opened
+ */
+static bool readPuzzles(const char* in, std::vector<Board>& puzzles)
+{
+    PuzzleReader reader;
+    Board b;
+
+    if(!reader.open(in))
+    {
+        std::cerr << "Unable to open " << in << std::endl;
+        return false;
+    }
+
+    unsigned long long lineNum = 0;
+
+    while(nextPuzzle(reader, b, lineNum))
+        puzzles.push_back(b);
+
+    return true;
+}
+
+/**
+ * Solve every puzzle in a file through a daemon and print the results in
+ * input order
+ *
+ * @param sock path of the daemon's socket
+ * @param in file of puzzles, "-" for standard input
+ * @param flags FLAG_SEARCH or nothing
+ * @param batchSize puzzles sent in each request
+ * @param depth most requests in flight at once
+ * @param deadline microseconds each request may take, 0 for no limit
+ * @param out buffer for the results
+ *
+ * @return exit status of the program
+ */
+int runClient(const char* sock, const char* in, unsigned flags,
+              size_t batchSize, int depth, unsigned deadline,
+              OutputBuffer& out)
+{
+    std::vector<Board> puzzles;
+
+    if(!readPuzzles(in, puzzles))
+        return -1;
+
+    SolverClient client;
+
+    if(!client.connect(sock))
+    {
+        std::cerr << "Unable to connect to " << sock << std::endl;
+        return -1;
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+
+    size_t numRequests = (puzzles.size() + batchSize - 1) / batchSize;
+    std::vector<Clock::time_point> sent(numRequests);
+    std::mutex lock;
+    std::condition_variable room;
+    std::deque<size_t> retries;
+    int inFlight = 0;
+    double limit = depth;
+    bool finished = false;
+
+    // busy answers halve the requests in flight and each answer lets
+    // them grow back a little, so a client settles at what the daemon
+    // can take
+    std::thread sender([&]()
+    {
+        size_t fresh = 0;
+
+        while(true)
+        {
+            size_t r;
+
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                room.wait(guard, [&]()
+                {
+                    return finished || (inFlight < static_cast<int>(limit) &&
+                           (!retries.empty() || fresh < numRequests));
+                });
+
+                if(finished)
+                    break;
+
+                if(!retries.empty())
+                {
+                    r = retries.front();
+                    retries.pop_front();
+                }
+                else
+                {
+                    r = fresh++;
+                    sent[r] = Clock::now();
+                }
+
+                inFlight++;
+            }
+
+            size_t first = r * batchSize;
+            size_t n = std::min(batchSize, puzzles.size() - first);
+
+            if(!client.send(r, flags, 0, &puzzles[first], n, deadline))
+                break;
+        }
+    });
+
+    // responses can overtake each other, so keep them until their turn
+    std::vector<SolveResponse> responses(numRequests);
+    std::vector<bool> arrived(numRequests, false);
+    size_t next = 0;
+    long long solved = 0;
+    long long busy = 0;
+    double latency = 0;
+    bool failed = false;
+    SolveResponse resp;
+
+    for(size_t r = 0; r < numRequests; )
+    {
+        failed = !client.receive(resp) || resp.id >= numRequests ||
+                 (resp.status != RESPONSE_OK && resp.status != RESPONSE_BUSY);
+
+        if(failed)
+            break;
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            inFlight--;
+
+            if(resp.status == RESPONSE_BUSY)
+            {
+                busy++;
+                limit = std::max(limit / 2, 1.0);
+                retries.push_back(resp.id);
+            }
+            else
+            {
+                limit = std::min(limit + 1 / limit, static_cast<double>(depth));
+                latency += std::chrono::duration<double>(
+                               Clock::now() - sent[resp.id]).count();
+            }
+        }
+        room.notify_one();
+
+        if(resp.status == RESPONSE_BUSY)
+            continue;
+
+        r++;
+
+        unsigned id = resp.id;
+        std::swap(responses[id], resp);
+        arrived[id] = true;
+
+        for(; next < numRequests && arrived[next]; next++)
+        {
+            SolveResponse& done = responses[next];
+
+            for(size_t i = 0; i < done.boards.size(); i++)
+            {
+                if(done.statuses[i] == SOLVED)
+                    solved++;
+
+                out.appendLine(done.boards[i]);
+            }
+
+            done = SolveResponse();
+        }
+    }
+
+    // the sender waits for room until told it is done
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        finished = true;
+    }
+    room.notify_one();
+
+    sender.join();
+
+    if(failed)
+    {
+        std::cerr << "Lost the connection to " << sock << std::endl;
+        return -1;
+    }
+
+    double seconds = std::chrono::duration<double>(Clock::now() - start)
+                         .count();
+    long long count = puzzles.size();
+
+    std::cerr << count << " puzzles, " << solved << " solved in " << seconds
+              << " s (" << static_cast<long long>(count / seconds)
+              << " puzzles/s), "
+              << static_cast<long long>(numRequests ? latency / numRequests
+                                                      * 1e6 : 0)
+              << " us per request";
+
+    if(busy > 0)
+        std::cerr << ", " << busy << " sent again after busy answers";
+
+    std::cerr << std::endl;
+
+    return out.flush() ? 0 : -1;
+}
+
+/**
+ * Solve every puzzle in a file through a daemon's shared memory rings and
+ * print the results in input order
+ *
+ * @param ring path of the daemon's channel file
+ * @param in file of puzzles, "-" for standard input
+ * @param flags FLAG_SEARCH or nothing
+ * @param busyPoll true to spin while waiting for results
+ * @param out buffer for the results
+ *
+ * @return exit status of the program
+ */
+int runRingClient(const char* ring, const char* in, unsigned flags,
+                  bool busyPoll, OutputBuffer& out)
+{
+    std::vector<Board> puzzles;
+
+    if(!readPuzzles(in, puzzles))
+        return -1;
+
+    SharedChannel channel;
+
+    if(!channel.open(ring))
+    {
+        std::cerr << "Unable to open " << ring << std::endl;
+        return -1;
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+
+    size_t count = puzzles.size();
+    size_t slots = channel.requests.size();
+    size_t sent = 0;
+    size_t received = 0;
+    long long solved = 0;
+    Board b;
+
+    while(received < count)
+    {
+        // boards are packed straight into the slots
+        size_t n = 0;
+
+        while(sent + n < count && sent + n - received < slots)
+        {
+            RingRequest* req = static_cast<RingRequest*>(
+                                   channel.requests.claim(n));
+            if(req == nullptr)
+                break;
+
+            req->id = sent + n;
+            req->flags = flags;
+            req->budget = 0;
+            puzzles[sent + n].writePacked(req->board);
+            n++;
+        }
+
+        if(n > 0)
+        {
+            channel.requests.publish(n);
+            sent += n;
+        }
+
+        // with nothing out, the daemon is only letting go of the last
+        // requests after sending their results
+        bool waited = (sent == received) ?
+            channel.requests.waitRoom(busyPoll, RING_TIMEOUT_MS) :
+            channel.results.waitData(busyPoll, RING_TIMEOUT_MS);
+
+        if(!waited)
+        {
+            std::cerr << "No answer through " << ring << std::endl;
+            return -1;
+        }
+
+        size_t ready = channel.results.available();
+
+        for(size_t i = 0; i < ready; i++)
+        {
+            const RingResult* res = static_cast<RingResult*>(
+                                        channel.results.at(i));
+
+            b.readPacked(res->solution);
+            if(res->status == SOLVED)
+                solved++;
+
+            out.appendLine(b);
+        }
+
+        channel.results.release(ready);
+        received += ready;
+    }
+
+    double seconds = std::chrono::duration<double>(Clock::now() - start)
+                         .count();
+
+    std::cerr << count << " puzzles, " << solved << " solved in " << seconds
+              << " s (" << static_cast<long long>(count / seconds)
+              << " puzzles/s)" << std::endl;
+
+    return out.flush() ? 0 : -1;
+}
+
 /**
  * Main function that handles reading and running the solver
  */
 int main(int argc, char** argv)
 {
+    if(argc >= 2 && std::strcmp(argv[1], "--batch") == 0)
+    {
+        OutputBuffer out(1);
+        BatchRunner runner;
+        const char* path = "-";
+        int paths = 0;
+        bool uring = false;
+        bool canonical = false;
+        long cacheMb = 0;
+        const char* storePath = nullptr;
+        ShardRunner sharded;
+
+        for(int i = 2; i < argc; i++)
+        {
+            if(std::strcmp(argv[i], "--pretty") == 0)
+                out.layout = OutputBuffer::PRETTY;
+            else if(std::strcmp(argv[i], "--jsonl") == 0)
+                out.layout = OutputBuffer::JSONL;
+            else if(std::strcmp(argv[i], "--csv") == 0)
+                out.layout = OutputBuffer::CSV;
+            else if(std::strcmp(argv[i], "--with-puzzle") == 0)
+                out.content = OutputBuffer::PUZZLE_SOLUTION;
+            else if(std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            {
+                runner.threads = std::atoi(argv[++i]);
+
+                if(runner.threads <= 0)
+                    runner.threads = std::thread::hardware_concurrency();
+            }
+            else if(std::strcmp(argv[i], "--uring") == 0)
+                uring = true;
+            else if(std::strcmp(argv[i], "--lockstep") == 0)
+                runner.lockstep = true;
+            else if(std::strcmp(argv[i], "--numa") == 0)
+                runner.numa = true;
+            else if(std::strcmp(argv[i], "--search") == 0)
+                runner.search = true;
+            else if(std::strcmp(argv[i], "--canonical") == 0)
+                canonical = true;
+            else if(std::strcmp(argv[i], "--shards") == 0 && i + 1 < argc)
+            {
+                sharded.shards = std::atoi(argv[++i]);
+
+                if(sharded.shards <= 0)
+                {
+                    usage();
+                    return -1;
+                }
+            }
+            else if(std::strcmp(argv[i], "--shard-dir") == 0 && i + 1 < argc)
+                sharded.dir = argv[++i];
+            else if(std::strcmp(argv[i], "--resume") == 0)
+                sharded.resume = true;
+            else if(std::strcmp(argv[i], "--store") == 0 && i + 1 < argc)
+                storePath = argv[++i];
+            else if(std::strcmp(argv[i], "--cache-mb") == 0 && i + 1 < argc)
+            {
+                cacheMb = std::atol(argv[++i]);
+
+                if(cacheMb <= 0)
+                {
+                    usage();
+                    return -1;
+                }
+            }
+            else if(argv[i][0] == '-' && argv[i][1] != '\0')
+            {
+                usage();
+                return -1;
+            }
+            else
+            {
+                path = argv[i];
+                paths++;
+            }
+        }
+
+        if(paths > 1)
+        {
+            usage();
+            return -1;
+        }
+
+        // the canonical cache gets the same memory, 64 MB if none is given
+        size_t cacheBytes = static_cast<size_t>(cacheMb) << 20;
+        std::unique_ptr<ResultCache> results;
+        std::unique_ptr<CanonicalCache> cache;
+
+        if(cacheMb > 0)
+        {
+            results.reset(new ResultCache(cacheBytes));
+            runner.results = results.get();
+        }
+
+        if(canonical)
+        {
+            cache.reset(cacheMb > 0 ? new CanonicalCache(cacheBytes)
+                                    : new CanonicalCache());
+            runner.cache = cache.get();
+        }
+
+        // another process writing the store leaves this one reading it
+        SolutionStore store;
+
+        if(storePath != nullptr)
+        {
+            // shard workers share the mapping, so only read it
+            bool opened = sharded.shards > 1
+                              ? store.open(storePath, false)
+                              : access(storePath, F_OK) == 0
+                                    ? store.open(storePath, true) ||
+                                      store.open(storePath, false)
+                                    : store.create(storePath, STORE_CAPACITY);
+
+            if(!opened)
+            {
+                std::cerr << "Unable to open store " << storePath
+                          << std::endl;
+                return -1;
+            }
+
+            runner.store = &store;
+        }
+
+        // writes to a pipe or terminal stay plain
+        if(uring)
+            out.useUring();
+
+        sharded.uring = uring;
+
+        if(sharded.shards > 1 || sharded.resume)
+        {
+            if(!sharded.run(path, runner, out))
+                return -1;
+
+            sharded.summary(std::cerr);
+
+            return 0;
+        }
+
+        return runBatch(path, runner, uring, out);
+    }
+
+    if(argc >= 3 && std::strcmp(argv[1], "--daemon") == 0)
+    {
+        SolverDaemon daemon;
+        const char* ring = nullptr;
+        long ringSlots = 1024;
+
+        for(int i = 3; i < argc; i++)
+        {
+            if(std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+                daemon.threads = std::max(std::atoi(argv[++i]), 0);
+            else if(std::strcmp(argv[i], "--window-us") == 0 && i + 1 < argc)
+            {
+                daemon.coalesce = true;
+                daemon.batcher.maxWindow = std::max(std::atoi(argv[++i]), 0);
+            }
+            else if(std::strcmp(argv[i], "--max-batch") == 0 && i + 1 < argc)
+                daemon.batcher.maxBatch = std::max(std::atoi(argv[++i]), 1);
+            else if(std::strcmp(argv[i], "--slo-us") == 0 && i + 1 < argc)
+                daemon.batcher.target = std::max(std::atoi(argv[++i]), 1);
+            else if(std::strcmp(argv[i], "--max-queue") == 0 && i + 1 < argc)
+                daemon.maxQueue = std::max(std::atol(argv[++i]), 0L);
+            else if(std::strcmp(argv[i], "--report-every") == 0 &&
+                    i + 1 < argc)
+                daemon.reportEvery = std::max(std::atoi(argv[++i]), 0);
+            else if(std::strcmp(argv[i], "--ring") == 0 && i + 1 < argc)
+                ring = argv[++i];
+            else if(std::strcmp(argv[i], "--ring-slots") == 0 && i + 1 < argc)
+                ringSlots = std::max(std::atol(argv[++i]), 1L);
+            else if(std::strcmp(argv[i], "--busy-poll") == 0)
+                daemon.busyPoll = true;
+            else
+            {
+                usage();
+                return -1;
+            }
+        }
+
+        return runDaemon(argv[2], ring, ringSlots, daemon);
+    }
+
+    if(argc >= 3 && std::strcmp(argv[1], "--client") == 0)
+    {
+        OutputBuffer out(1);
+        const char* path = "-";
+        int paths = 0;
+        unsigned flags = 0;
+        long batchSize = 256;
+        int depth = 64;
+        unsigned deadline = 0;
+        bool ring = false;
+        bool busyPoll = false;
+
+        for(int i = 3; i < argc; i++)
+        {
+            if(std::strcmp(argv[i], "--search") == 0)
+                flags |= FLAG_SEARCH;
+            else if(std::strcmp(argv[i], "--batch-size") == 0 && i + 1 < argc)
+                batchSize = std::atol(argv[++i]);
+            else if(std::strcmp(argv[i], "--depth") == 0 && i + 1 < argc)
+                depth = std::atoi(argv[++i]);
+            else if(std::strcmp(argv[i], "--deadline-us") == 0 &&
+                    i + 1 < argc)
+                deadline = std::max(std::atol(argv[++i]), 0L);
+            else if(std::strcmp(argv[i], "--ring") == 0)
+                ring = true;
+            else if(std::strcmp(argv[i], "--busy-poll") == 0)
+                busyPoll = true;
+            else if(argv[i][0] == '-' && argv[i][1] != '\0')
+                paths = 2;
+            else
+            {
+                path = argv[i];
+                paths++;
+            }
+        }
+
+        if(paths > 1 || batchSize <= 0 || depth <= 0)
+        {
+            usage();
+            return -1;
+        }
+
+        if(ring)
+            return runRingClient(argv[2], path, flags, busyPoll, out);
+
+        return runClient(argv[2], path, flags, batchSize, depth, deadline,
+                         out);
+    }
+
+    if(argc >= 3 && std::strcmp(argv[1], "--build-store") == 0)
+    {
+        BatchOptions opts;
+        const char* paths[2] = {nullptr, "-"};
+        int numPaths = 0;
+
+        for(int i = 2; i < argc; i++)
+        {
+            if(std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+                opts.threads = std::max(std::atoi(argv[++i]), 0);
+            else if(std::strcmp(argv[i], "--search") == 0)
+                opts.search = true;
+            else if(numPaths < 2 &&
+                    (argv[i][0] != '-' || std::strcmp(argv[i], "-") == 0))
+                paths[numPaths++] = argv[i];
+            else
+            {
+                usage();
+                return -1;
+            }
+        }
+
+        if(numPaths == 0)
+        {
+            usage();
+            return -1;
+        }
+
+        return buildStore(paths[0], paths[1], opts);
+    }
+
+    if(argc >= 3 && std::strcmp(argv[1], "--generate") == 0)
+    {
+        OutputBuffer out(1);
+        PuzzleGenerator generator;
+        long long n = std::atoll(argv[2]);
+
+        if(n <= 0)
+        {
+            usage();
+            return -1;
+        }
+
+        for(int i = 3; i < argc; i++)
+        {
+            if(std::strcmp(argv[i], "--pretty") == 0)
+                out.layout = OutputBuffer::PRETTY;
+            else if(std::strcmp(argv[i], "--jsonl") == 0)
+                out.layout = OutputBuffer::JSONL;
+            else if(std::strcmp(argv[i], "--csv") == 0)
+                out.layout = OutputBuffer::CSV;
+            else if(std::strcmp(argv[i], "--with-solution") == 0)
+                out.content = OutputBuffer::PUZZLE_SOLUTION;
+            else if(std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+                generator.threads = std::max(std::atoi(argv[++i]), 0);
+            else if(std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+                generator.seed = std::strtoull(argv[++i], nullptr, 10);
+            else
+            {
+                usage();
+                return -1;
+            }
+        }
+
+        if(!generator.run(n, out))
+        {
+            std::cerr << "Unable to write the puzzles" << std::endl;
+            return -1;
+        }
+
+        generator.summary(std::cerr);
+
+        return 0;
+    }
+
+    if(argc >= 2 && std::strcmp(argv[1], "--pack") == 0)
+    {
+        bool withIds = argc >= 3 && std::strcmp(argv[2], "--ids") == 0;
+        int first = withIds ? 3 : 2;
+
+        if(argc - first > 2)
+        {
+            usage();
+            return -1;
+        }
+
+        return pack(argc > first ? argv[first] : "-",
+                    argc > first + 1 ? argv[first + 1] : "-", withIds);
+    }
+
+    if(argc >= 3 && std::strcmp(argv[1], "--unpack") == 0)
+    {
+        if(argc > 4)
+        {
+            usage();
+            return -1;
+        }
+
+        if(argc == 3 || std::strcmp(argv[3], "-") == 0)
+        {
+            OutputBuffer out(1);
+            return unpack(argv[2], out);
+        }
+
+        int fd = open(argv[3], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(fd < 0)
+        {
+            std::cerr << "Unable to create " << argv[3] << std::endl;
+            return -1;
+        }
+
+        int status;
+        {
+            OutputBuffer out(fd);
+            status = unpack(argv[2], out);
+        }
+        close(fd);
+
+        return status;
+    }
+
     if(argc != 2)
     {
-        std::cout << "Usage: bin/sudoku-solver [input file]" << std::endl;
+        usage();
         return -1;
     }
 
@@ -23,7 +1095,18 @@ int main(int argc, char** argv)
     inf.open(argv[1]);
 
     SudokuSolver grid;
-    inf >> grid.board;
+
+    // a puzzle on a single line of 81 characters is parsed directly,
+    // anything else is read as the bordered layout
+    std::string first;
+    std::getline(inf, first);
+
+    if(!grid.board.readLine(first.data(), first.size()))
+    {
+        inf.clear();
+        inf.seekg(0);
+        inf >> grid.board;
+    }
 
     
     if(grid.solveDriver())
@@ -31,6 +1114,11 @@ int main(int argc, char** argv)
         std::cout << "\nSuccessfully solved:\n"
                   << grid.board << std::endl;
     }
+    else if(grid.unsolvable)
+    {
+        std::cout << "This board is unsolvable." << std::endl;
+        return -1;
+    }
     else
     {
         std::cout << "\nUnsuccessfully solved...\n"
@@ -1,18 +1,59 @@
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 
 #include "SudokuSolver.h"
 
+//----------------------------------------------------------------------------
+SolveStats::SolveStats()
+{
+    this->status = STUCK;
+    this->placements = 0;
+    this->blockSingles = 0;
+    this->rowSingles = 0;
+    this->colSingles = 0;
+    this->searchNodes = 0;
+    this->passes = 0;
+    this->nanos = 0;
+}
+
+//----------------------------------------------------------------------------
+const char* SolveStats::statusName(SolveStatus status)
+{
+    switch(status)
+    {
+        case SOLVED:
+            return "solved";
+        case STUCK:
+            return "stuck";
+        case CONTRADICTION:
+            return "contradiction";
+        case BUDGET:
+            return "budget";
+    }
+
+    return "unknown";
+}
+
 //----------------------------------------------------------------------------
 SudokuSolver::SudokuSolver()
 {
     
     // board constructor takes care of board
+    this->unsolvable = false;
+    this->budget = 0;
+    this->search = false;
+    this->cancel = nullptr;
 }
 
 //----------------------------------------------------------------------------
 SudokuSolver::SudokuSolver(const Board& b)
 {
     this->board = b;
+    this->unsolvable = false;
+    this->budget = 0;
+    this->search = false;
+    this->cancel = nullptr;
 }
 
 //----------------------------------------------------------------------------
@@ -20,6 +61,11 @@ SudokuSolver::SudokuSolver(const SudokuSolver& src)
 {
     // use copy constructor of Board class
     this->board = src.board;
+    this->unsolvable = src.unsolvable;
+    this->stats = src.stats;
+    this->budget = src.budget;
+    this->search = src.search;
+    this->cancel = src.cancel;
 }
 
 //----------------------------------------------------------------------------
@@ -43,32 +89,87 @@ bool SudokuSolver::operator<(const SudokuSolver& rhs) const
 //----------------------------------------------------------------------------
 bool SudokuSolver::solveDriver()
 {
-    Board oldBoard;
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+
+    int filled = this->board.getFilled();
+
+    this->unsolvable = false;
+    this->stats = SolveStats();
+
+    // an empty board has nothing to cross check
+    if(filled > 0)
+        this->propagate();
+
+    if(this->search && !this->unsolvable && this->stats.status != BUDGET &&
+       !this->board.isFull())
+    {
+        Arena& arena = Arena::local();
+        Arena::Mark top = arena.mark();
+
+        // a repeated number can never be guessed around
+        if(this->board.hasDuplicates() ||
+           (!this->guess(arena) && this->stats.status != BUDGET))
+            this->unsolvable = true;
+
+        arena.reset(top);
+    }
+
+    // guesses that were taken back placed numbers that are gone again
+    if(this->stats.searchNodes > 0)
+        this->stats.placements = this->board.getFilled() - filled;
+    else
+        this->stats.placements = this->stats.blockSingles +
+                                 this->stats.rowSingles +
+                                 this->stats.colSingles;
+
+    if(this->unsolvable)
+        this->stats.status = CONTRADICTION;
+    else if(this->board.isFull())
+        this->stats.status = SOLVED;
+    else if(this->stats.status != BUDGET)
+        this->stats.status = STUCK;
+
+    this->stats.nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - start).count();
+
+    return this->stats.status == SOLVED;
+
+}
+
+//----------------------------------------------------------------------------
+void SudokuSolver::propagate()
+{
+    bool changed = true;
 
-    while(!(this->board == oldBoard))
+    // every number placed is counted, so the board changed in a pass if
+    // the counts did
+    while(changed && !this->unsolvable)
     {
-        // keep track of the old board to track changes
-        oldBoard = this->board;
+        // give up once the passes run out or the caller gives up
+        if((this->budget > 0 && this->stats.passes == this->budget) ||
+           (this->cancel != nullptr &&
+            this->cancel->load(std::memory_order_relaxed)))
+        {
+            this->stats.status = BUDGET;
+            break;
+        }
+
+        this->stats.passes++;
 
+        int placed = this->stats.blockSingles + this->stats.rowSingles +
+                     this->stats.colSingles;
 
         // cross check all missing numbers in all blocks
         for(int b = 0; b < 9; b++)
         {
             for(int i = 1; i < 10; i++)
             {
-                /*
-                std::cerr << "Searching for " << i << " in block " << b
-                          << ": " << !(this->board.searchFor(b, i, 'b'))
-                          << "\n";
-                */
-
                 if(!(this->board.searchFor(b, i, 'b')))
                     this->crossCheckBlock(b, i);
             }
         }
 
-        
-
         // cross check all missing numbers in rows
         for(int r = 0; r < 9; r++)
         {
@@ -79,9 +180,6 @@ bool SudokuSolver::solveDriver()
             }
         }
 
-
-
-        
         // cross check all missing numbers in columns
         for(int c = 0; c < 9; c++)
         {
@@ -92,19 +190,93 @@ bool SudokuSolver::solveDriver()
             }
         }
 
+        changed = (this->stats.blockSingles + this->stats.rowSingles +
+                   this->stats.colSingles) != placed;
+    }
+}
 
-       
+//----------------------------------------------------------------------------
+int SudokuSolver::bestCell(bool* bestFits) const
+{
+    int best = -1;
+    int bestCount = 10;
+    bool fits[10];
+
+    for(int cell = 0; cell < 81 && bestCount > 1; cell++)
+    {
+        int r = cell / 9;
+        int c = cell % 9;
 
-        
-        // std::cerr << "\n" << this->board << "\n";
+        if(this->board.getCell(r, c) != -1)
+            continue;
+
+        int count = 0;
+        for(int i = 1; i < 10; i++)
+        {
+            fits[i] = !this->board.searchFor(r, i, 'r') &&
+                      !this->board.searchFor(c, i, 'c') &&
+                      !this->board.searchFor((r / 3) * 3 + c / 3, i, 'b');
+            count += fits[i];
+        }
 
+        if(count == 0)
+            return -1;
+
+        if(count < bestCount)
+        {
+            best = cell;
+            bestCount = count;
+            std::copy(fits, fits + 10, bestFits);
+        }
     }
 
-    if(!(this->board.isFull()))
+    return best;
+}
+
+//----------------------------------------------------------------------------
+bool SudokuSolver::guess(Arena& arena)
+{
+    bool bestFits[10];
+
+    // guess in the space with the fewest numbers that fit, a space
+    // nothing fits in means an earlier guess was wrong
+    int best = this->bestCell(bestFits);
+    if(best < 0)
         return false;
-    else
-        return true;
 
+    // each level of the search keeps the board it started from
+    Arena::Mark level = arena.mark();
+    int* saved = arena.allocate<int>(81);
+    this->board.saveCells(saved);
+
+    for(int i = 1; i < 10; i++)
+    {
+        if(!bestFits[i])
+            continue;
+
+        this->stats.searchNodes++;
+        this->board.setCell(best / 9, best % 9, i);
+        this->propagate();
+
+        if(this->stats.status != BUDGET && !this->unsolvable &&
+           (this->board.isFull() || this->guess(arena)))
+        {
+            arena.reset(level);
+            return true;
+        }
+
+        // take back the guess and everything that followed from it, also
+        // when the budget ran out under it, so a board left unfinished
+        // only holds numbers that did not depend on a guess
+        this->board.loadCells(saved);
+        this->unsolvable = false;
+
+        if(this->stats.status == BUDGET)
+            break;
+    }
+
+    arena.reset(level);
+    return false;
 }
 
 //----------------------------------------------------------------------------
@@ -117,14 +289,14 @@ void SudokuSolver::crossCheckBlock(int b, int toSearch)
     if(this->board.searchFor(b, toSearch, 'b'))
         return;
 
-    std::vector<bool> availSpace(9, false);
-    std::vector<int> block = this->board.getBlock(b);
+    bool availSpace[9];
 
     // find all empty block spaces
     for(int i = 0; i < 9; i++)
     {
-        if(block[i] == -1)
-            availSpace[i] = true;
+        int cell = this->board.getCell((b / 3) * 3 + i / 3,
+                                       (b % 3) * 3 + i % 3);
+        availSpace[i] = (cell == -1);
     }
 
 
@@ -178,10 +350,8 @@ void SudokuSolver::crossCheckBlock(int b, int toSearch)
     // spaces, declare the board unsolvable
     if(!(this->board.searchFor(b, toSearch, 'b')) && !found)
     {
-        std::cout << "This board is unsolvable.\n"
-                  << "It is impossible to enter a " << toSearch
-                  << " into block " << b << std::endl;
-        std::exit(-1);
+        this->unsolvable = true;
+        return;
     }
 
 
@@ -191,6 +361,7 @@ void SudokuSolver::crossCheckBlock(int b, int toSearch)
     int row = (b / 3) * 3 + (avail / 3);
     int col = (b % 3) * 3 + (avail % 3);
     this->board.setCell(row, col, toSearch);
+    this->stats.blockSingles++;
 }
 
 //----------------------------------------------------------------------------
@@ -200,15 +371,11 @@ void SudokuSolver::crossCheckRow(int r, int toSearch)
     if(this->board.searchFor(r, toSearch, 'r'))
         return;
 
-    std::vector<bool> availSpace(9, false);
-    std::vector<int> row = this->board.getRow(r);
+    bool availSpace[9];
 
     // if the cell is empty, add it to availability
     for(int i = 0; i < 9; i++)
-    {
-        if(row[i] == -1)
-            availSpace[i] = true;
-    }
+        availSpace[i] = (this->board.getCell(r, i) == -1);
 
        
 
@@ -271,16 +438,15 @@ void SudokuSolver::crossCheckRow(int r, int toSearch)
     // spaces, declare the board unsolvable
     if(!(this->board.searchFor(r, toSearch, 'r')) && !found)
     {
-        std::cout << "This board is unsolvable.\n"
-                  << "It is impossible to enter a " << toSearch
-                  << " into row " << r << std::endl;
-        std::exit(-1);
+        this->unsolvable = true;
+        return;
     }
 
 
 
     // set the value in the correct cell
     this->board.setCell(r, avail, toSearch);
+    this->stats.rowSingles++;
 
 }
 
@@ -292,16 +458,12 @@ void SudokuSolver::crossCheckCol(int c, int toSearch)
         return;
 
 
-    std::vector<bool> availSpace(9, false);
-    std::vector<int> col = this->board.getCol(c);
+    bool availSpace[9];
 
 
     // set empty spaces to available
     for(int i = 0; i < 9; i++)
-    {
-        if(col[i] == -1)
-            availSpace[i] = true;
-    }
+        availSpace[i] = (this->board.getCell(i, c) == -1);
 
 
     // search through the blocks to eliminate spaces
@@ -353,14 +515,13 @@ void SudokuSolver::crossCheckCol(int c, int toSearch)
     // spaces, declare the board unsolvable
     if(!(this->board.searchFor(c, toSearch, 'c')) && !found)
     {
-        std::cout << "This board is unsolvable.\n"
-                  << "It is impossible to enter a " << toSearch
-                  << " into column " << c << std::endl;
-        std::exit(-1);
+        this->unsolvable = true;
+        return;
     }
 
     // set the value
     this->board.setCell(avail, c, toSearch);
+    this->stats.colSingles++;
 
 }
 
@@ -369,3 +530,100 @@ void SudokuSolver::display(std::ostream& outs) const
 {
     outs << this->board;
 }
+
+//----------------------------------------------------------------------------
+long long SudokuSolver::countSolutions(long long limit)
+{
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+
+    int budget = this->budget;
+    const std::atomic<bool>* cancel = this->cancel;
+    int filled = this->board.getFilled();
+    long long found = 0;
+
+    this->budget = 0;
+    this->cancel = nullptr;
+    this->unsolvable = false;
+    this->stats = SolveStats();
+
+    Arena& arena = Arena::local();
+    Arena::Mark top = arena.mark();
+    int* given = arena.allocate<int>(81);
+    int* first = arena.allocate<int>(81);
+    this->board.saveCells(given);
+
+    // numbers placed by cross checking are forced, so they never rule
+    // out a solution, and a full board without repeats is one
+    if(!this->board.hasDuplicates())
+    {
+        if(filled > 0)
+            this->propagate();
+
+        if(this->unsolvable)
+            found = 0;
+        else if(this->board.isFull())
+        {
+            this->board.saveCells(first);
+            found = 1;
+        }
+        else
+            this->countFrom(arena, std::max(limit, 1LL), found, first);
+    }
+
+    this->board.loadCells(found > 0 ? first : given);
+    arena.reset(top);
+
+    this->budget = budget;
+    this->cancel = cancel;
+    this->unsolvable = found == 0;
+    this->stats.status = found > 0 ? SOLVED : CONTRADICTION;
+    this->stats.placements = this->board.getFilled() - filled;
+    this->stats.nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - start).count();
+
+    return found;
+}
+
+//----------------------------------------------------------------------------
+void SudokuSolver::countFrom(Arena& arena, long long limit, long long& found,
+                             int* first)
+{
+    bool bestFits[10];
+
+    int best = this->bestCell(bestFits);
+    if(best < 0)
+        return;
+
+    Arena::Mark level = arena.mark();
+    int* saved = arena.allocate<int>(81);
+    this->board.saveCells(saved);
+
+    for(int i = 1; i < 10 && found < limit; i++)
+    {
+        if(!bestFits[i])
+            continue;
+
+        this->stats.searchNodes++;
+        this->board.setCell(best / 9, best % 9, i);
+        this->propagate();
+
+        if(!this->unsolvable)
+        {
+            if(this->board.isFull())
+            {
+                if(found == 0)
+                    this->board.saveCells(first);
+
+                found++;
+            }
+            else
+                this->countFrom(arena, limit, found, first);
+        }
+
+        this->board.loadCells(saved);
+        this->unsolvable = false;
+    }
+
+    arena.reset(level);
+}
@@ -1,18 +1,111 @@
 #ifndef SUDOKUSOLVER_H_INCLUDED
 #define SUDOKUSOLVER_H_INCLUDED
 
+#include <atomic>
 #include <vector>
 #include <iostream>
 
+#include "Arena.h"
 #include "Board.h"
 
+/**
+ * How a solve ended
+ */
+enum SolveStatus
+{
+    SOLVED,                     ///< Every space was filled
+    STUCK,                      ///< No more numbers could be placed
+    CONTRADICTION,              ///< A number had no space left
+    BUDGET                      ///< The solve ran out of passes
+};
+
+/**
+ * Counts kept while solving a board
+ */
+struct SolveStats
+{
+    SolveStatus status;         ///< How the solve ended
+    int placements;             ///< Numbers placed on the board
+    int blockSingles;           ///< Numbers placed by crossCheckBlock()
+    int rowSingles;             ///< Numbers placed by crossCheckRow()
+    int colSingles;             ///< Numbers placed by crossCheckCol()
+    long long searchNodes;      ///< Guesses tried, 0 without a search
+    int passes;                 ///< Passes made over the whole board
+    long long nanos;            ///< Time taken by the solve
+
+    /**
+     * Default Constructor, every count starts at zero
+     */
+    SolveStats();
+
+    /**
+     * Name a status for output
+     *
+     * @param status status to name
+     *
+     * @return lower case name of the status
+     */
+    static const char* statusName(SolveStatus status);
+};
+
 /**
  * This class contains all methods focused on solving the sudoku board
  */
 class SudokuSolver
 {    
+    private:
+        /**
+         * Cross check every missing number of every block, row, and column
+         * over and over, until a pass places nothing, the board contradicts
+         * itself, or the budget runs out
+         */
+        void propagate();
+
+        /**
+         * Guess a number for the space with the fewest that fit, cross
+         * check, and go on guessing until the board is full, taking back
+         * guesses that lead to a contradiction
+         * The board each level starts from is kept in the arena and given
+         * back when the level is done.
+         *
+         * @param arena memory for the boards kept
+         *
+         * @return true if the board was filled
+         */
+        bool guess(Arena& arena);
+
+        /**
+         * Find the empty space with the fewest numbers that fit
+         *
+         * @param fits set to the numbers that fit there, by number
+         *
+         * @return the space, row by row from 0, or -1 if nothing fits in
+         *         some space
+         */
+        int bestCell(bool* fits) const;
+
+        /**
+         * Try every number that fits in the best space, cross check, and
+         * go on to count every way the board can be filled
+         *
+         * @param arena memory for the boards kept
+         * @param limit count to stop at
+         * @param found solutions counted so far
+         * @param first set to the cells of the first solution found
+         */
+        void countFrom(Arena& arena, long long limit, long long& found,
+                       int* first);
+
     public:
         Board board;                ///< Board that will be solved
+        bool unsolvable;            ///< Set when a number has no space left
+        SolveStats stats;           ///< Counts kept by the last solve
+        int budget;                 ///< Most passes a solve may make, 0 for
+                                    ///< no limit
+        bool search;                ///< Guess when cross checking gets stuck
+        const std::atomic<bool>* cancel;    ///< Once set, ends the solve as
+                                            ///< if the budget ran out, or
+                                            ///< nullptr
 
         /**
          * Default Constructor
@@ -64,11 +157,37 @@ class SudokuSolver
 
         /**
          * Driver for all solving processes
+         * Stops early and sets unsolvable if the board contradicts itself.
+         * The outcome and counts are left in stats.
+         *
+         * With search set, a board that gets stuck is finished by guessing,
+         * and a board with no solution at all is unsolvable. Memory for the
+         * search comes from the calling thread's Arena, so once it has
+         * grown, solving does not allocate.
+         *
+         * Setting cancel from another thread stops the solve before its
+         * next pass with the BUDGET status.
          *
          * @return true if the board is solved successfully
          */
         bool solveDriver();
 
+        /**
+         * Count the solutions of the board, up to a limit
+         * Every way of filling the board is tried, with cross checking
+         * between guesses, so a limit of 2 tells a puzzle with a unique
+         * solution from one with several. The budget, search flag and
+         * cancel are not used. The board is left as the first solution
+         * found, or as it was when there is none, and stats holds the
+         * counts, SOLVED if any solution was found and CONTRADICTION
+         * otherwise.
+         *
+         * @param limit most solutions to count, at least 1
+         *
+         * @return number of solutions, no more than limit
+         */
+        long long countSolutions(long long limit);
+
         /**
          * Overloaded Logical Equivalence Operator
          *
@@ -0,0 +1,449 @@
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "ThreadPool.h"
+
+const int ThreadPool::MAX_WORKERS;
+
+/**
+ * Pool the calling thread works for, if any
+ */
+static thread_local ThreadPool* currentPool = nullptr;
+
+/**
+ * Position of the calling thread in currentPool
+ */
+static thread_local int currentIndex = -1;
+
+//----------------------------------------------------------------------------
+ThreadPool::WorkDeque::Ring::Ring(long long size)
+{
+    this->size = size;
+    this->slots = new std::atomic<Task*>[size];
+}
+
+//----------------------------------------------------------------------------
+ThreadPool::WorkDeque::Ring::~Ring()
+{
+    delete[] this->slots;
+}
+
+//----------------------------------------------------------------------------
+ThreadPool::WorkDeque::WorkDeque() : top(0), bottom(0)
+{
+    this->ring = new Ring(32);
+}
+
+//----------------------------------------------------------------------------
+ThreadPool::WorkDeque::~WorkDeque()
+{
+    delete this->ring.load();
+
+    for(Ring* r: this->retired)
+        delete r;
+}
+
+//----------------------------------------------------------------------------
+void ThreadPool::WorkDeque::push(Task* t)
+{
+    long long b = this->bottom.load(std::memory_order_relaxed);
+    long long top = this->top.load(std::memory_order_acquire);
+    Ring* r = this->ring.load(std::memory_order_relaxed);
+
+    if(b - top > r->size - 1)
+    {
+        Ring* bigger = new Ring(r->size * 2);
+
+        for(long long i = top; i < b; i++)
+            bigger->slots[i & (bigger->size - 1)].store(
+                r->slots[i & (r->size - 1)].load(std::memory_order_relaxed),
+                std::memory_order_relaxed);
+
+        this->retired.push_back(r);
+        this->ring.store(bigger, std::memory_order_release);
+        r = bigger;
+    }
+
+    r->slots[b & (r->size - 1)].store(t, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    this->bottom.store(b + 1, std::memory_order_relaxed);
+}
+
+//----------------------------------------------------------------------------
+ThreadPool::Task* ThreadPool::WorkDeque::take()
+{
+    long long b = this->bottom.load(std::memory_order_relaxed) - 1;
+    Ring* r = this->ring.load(std::memory_order_relaxed);
+
+    this->bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    long long top = this->top.load(std::memory_order_relaxed);
+
+    if(top > b)
+    {
+        this->bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Task* t = r->slots[b & (r->size - 1)].load(std::memory_order_relaxed);
+
+    // the last task may be stolen from under us
+    if(top == b)
+    {
+        if(!this->top.compare_exchange_strong(top, top + 1,
+                                              std::memory_order_seq_cst,
+                                              std::memory_order_relaxed))
+            t = nullptr;
+
+        this->bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    return t;
+}
+
+//----------------------------------------------------------------------------
+ThreadPool::Task* ThreadPool::WorkDeque::steal()
+{
+    long long top = this->top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    long long b = this->bottom.load(std::memory_order_acquire);
+
+    if(top >= b)
+        return nullptr;
+
+    Ring* r = this->ring.load(std::memory_order_acquire);
+    Task* t = r->slots[top & (r->size - 1)].load(std::memory_order_relaxed);
+
+    if(!this->top.compare_exchange_strong(top, top + 1,
+                                          std::memory_order_seq_cst,
+                                          std::memory_order_relaxed))
+        return nullptr;
+
+    return t;
+}
+
+//----------------------------------------------------------------------------
+ThreadPool::Group::Group(ThreadPool& pool) : pool(pool), pending(0)
+{
+}
+
+//----------------------------------------------------------------------------
+ThreadPool::Group::~Group()
+{
+    this->wait();
+}
+
+//----------------------------------------------------------------------------
+void ThreadPool::Group::run(const std::function<void()>& fn)
+{
+    this->pending++;
+    this->pool.submit(new Task{fn, this, nullptr});
+}
+
+//----------------------------------------------------------------------------
+void ThreadPool::Group::wait(bool help)
+{
+    int self = (currentPool == &this->pool) ? currentIndex : -1;
+
+    while(this->pending.load() > 0)
+    {
+        Task* t = help ? this->pool.find(self) : nullptr;
+
+        if(t != nullptr)
+        {
+            this->pool.execute(t);
+            continue;
+        }
+
+        // nothing to help with, doze until the group is done or more
+        // work may have turned up
+        std::unique_lock<std::mutex> guard(this->lock);
+        this->finished.wait_for(guard, std::chrono::milliseconds(1), [&]()
+        {
+            return this->pending.load() == 0;
+        });
+    }
+
+    // the last task may still be signalling
+    std::lock_guard<std::mutex> guard(this->lock);
+}
+
+//----------------------------------------------------------------------------
+ThreadPool::ThreadPool(int workers) : numWorkers(0), queued(0), sleepers(0)
+{
+    this->stopping = false;
+    this->pinned = false;
+    this->reserve(workers);
+}
+
+//----------------------------------------------------------------------------
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(this->sleepLock);
+        this->stopping = true;
+        this->wake.notify_all();
+    }
+
+    for(std::thread& t: this->workers)
+        t.join();
+}
+
+//----------------------------------------------------------------------------
+ThreadPool& ThreadPool::shared()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+//----------------------------------------------------------------------------
+ThreadPool& ThreadPool::forNode(int node, const std::vector<int>& cpus)
+{
+    static std::mutex lock;
+    static std::map<int, std::unique_ptr<ThreadPool>> pools;
+
+    std::lock_guard<std::mutex> guard(lock);
+    std::unique_ptr<ThreadPool>& pool = pools[node];
+
+    if(!pool)
+    {
+        pool.reset(new ThreadPool);
+        pool->pinWorkers(cpus);
+    }
+
+    return *pool;
+}
+
+//----------------------------------------------------------------------------
+void ThreadPool::reserve(int workers)
+{
+    std::lock_guard<std::mutex> guard(this->growLock);
+
+    workers = std::min(workers, MAX_WORKERS);
+
+    while(static_cast<int>(this->workers.size()) < workers)
+    {
+        int index = this->workers.size();
+        this->workers.push_back(std::thread(&ThreadPool::work, this, index));
+        this->numWorkers.store(index + 1, std::memory_order_release);
+
+        if(this->pinned)
+            this->pin(index);
+    }
+}
+
+//----------------------------------------------------------------------------
+int ThreadPool::size() const
+{
+    return this->numWorkers.load();
+}
+
+//----------------------------------------------------------------------------
+void ThreadPool::pinWorkers()
+{
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+
+    if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+        return;
+
+    std::vector<int> cpus;
+
+    for(int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+        if(CPU_ISSET(cpu, &allowed))
+            cpus.push_back(cpu);
+    }
+
+    this->pinWorkers(cpus);
+}
+
+//----------------------------------------------------------------------------
+void ThreadPool::pinWorkers(const std::vector<int>& cpus)
+{
+    std::lock_guard<std::mutex> guard(this->growLock);
+
+    if(cpus.empty())
+        return;
+
+    this->cpus = cpus;
+    this->pinned = true;
+
+    for(size_t i = 0; i < this->workers.size(); i++)
+        this->pin(i);
+}
+
+//----------------------------------------------------------------------------
+void ThreadPool::pin(int index)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(this->cpus[index % this->cpus.size()], &set);
+
+    pthread_setaffinity_np(this->workers[index].native_handle(),
+                           sizeof(set), &set);
+}
+
+//----------------------------------------------------------------------------
+void ThreadPool::submit(Task* t)
+{
+    // counted first so a sleeping worker never misses it
+    this->queued++;
+
+    if(currentPool == this)
+        this->deques[currentIndex].push(t);
+    else
+    {
+        std::lock_guard<std::mutex> guard(this->injectLock);
+        this->injected.push_back(t);
+    }
+
+    if(this->sleepers.load() > 0)
+    {
+        std::lock_guard<std::mutex> guard(this->sleepLock);
+        this->wake.notify_one();
+    }
+}
+
+//----------------------------------------------------------------------------
+ThreadPool::Task* ThreadPool::find(int self)
+{
+    Task* t = nullptr;
+
+    if(self >= 0)
+        t = this->deques[self].take();
+
+    int n = this->numWorkers.load(std::memory_order_acquire);
+
+    for(int i = 1; t == nullptr && i <= n; i++)
+    {
+        int victim = (self + i) % n;
+
+        if(victim != self)
+            t = this->deques[victim].steal();
+    }
+
+    if(t == nullptr)
+    {
+        std::lock_guard<std::mutex> guard(this->injectLock);
+
+        if(!this->injected.empty())
+        {
+            t = this->injected.front();
+            this->injected.pop_front();
+        }
+    }
+
+    if(t != nullptr)
+        this->queued--;
+
+    return t;
+}
+
+//----------------------------------------------------------------------------
+void ThreadPool::execute(Task* t)
+{
+    // a posted task may be gone as soon as it is called
+    if(t->group == nullptr)
+    {
+        t->call(t);
+        return;
+    }
+
+    t->fn();
+
+    Group* group = t->group;
+    delete t;
+
+    std::lock_guard<std::mutex> guard(group->lock);
+    if(--group->pending == 0)
+        group->finished.notify_all();
+}
+
+//----------------------------------------------------------------------------
+void ThreadPool::work(int index)
+{
+    currentPool = this;
+    currentIndex = index;
+
+    while(true)
+    {
+        Task* t = this->find(index);
+
+        if(t != nullptr)
+        {
+            this->execute(t);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(this->sleepLock);
+        this->sleepers++;
+
+        while(!this->stopping && this->queued.load() <= 0)
+            this->wake.wait(guard);
+
+        this->sleepers--;
+
+        if(this->stopping && this->queued.load() <= 0)
+            return;
+    }
+}
+
+//----------------------------------------------------------------------------
+void ThreadPool::post(Task* t)
+{
+    if(this->numWorkers.load() == 0)
+        this->reserve(1);
+
+    t->group = nullptr;
+    this->submit(t);
+}
+
+//----------------------------------------------------------------------------
+void ThreadPool::parallelFor(size_t begin, size_t end, size_t grain,
+                             const std::function<void(size_t, size_t)>& fn,
+                             int maxTasks)
+{
+    if(end <= begin)
+        return;
+
+    if(grain == 0)
+        grain = 1;
+
+    if(maxTasks <= 0)
+        maxTasks = std::max(1u, std::thread::hardware_concurrency());
+
+    // no point in more tasks than blocks
+    size_t blocks = (end - begin + grain - 1) / grain;
+    int tasks = std::min<size_t>(maxTasks, blocks);
+
+    std::atomic<size_t> next(begin);
+    std::function<void()> drain = [&]()
+    {
+        size_t start;
+
+        while((start = next.fetch_add(grain)) < end)
+            fn(start, std::min(start + grain, end));
+    };
+
+    if(tasks == 1)
+    {
+        drain();
+        return;
+    }
+
+    // the calling thread takes one share of the work itself
+    this->reserve(tasks - 1);
+
+    Group group(*this);
+    for(int i = 1; i < tasks; i++)
+        group.run(drain);
+
+    drain();
+    group.wait();
+}
@@ -0,0 +1,284 @@
+#ifndef THREADPOOL_H_INCLUDED
+#define THREADPOOL_H_INCLUDED
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * The ThreadPool class runs tasks on a set of worker threads. Every worker
+ * keeps its own deque of tasks, pushing and taking at one end, while idle
+ * workers steal from the other end of someone else's deque. Tasks handed
+ * in from outside the pool wait in a shared queue until a worker picks
+ * them up.
+ *
+ * Workers are started as they are asked for and live as long as the pool.
+ * One pool is shared by the whole program, see shared(), and each NUMA
+ * node has one more of its own, see forNode().
+ */
+class ThreadPool
+{
+    public:
+        class Group;
+
+        /**
+         * A piece of work and the group waiting on it
+         * Tasks made by Group::run() belong to the pool, which frees them
+         * once run. A task handed to post() belongs to the caller, and the
+         * pool does not touch it once call has been entered, so call may
+         * free or reuse it.
+         */
+        struct Task
+        {
+            std::function<void()> fn;   ///< Work to run, for a group
+            Group* group;               ///< Group to tell when it is done,
+                                        ///< nullptr for a posted task
+            void (*call)(Task* self);   ///< Work to run, for a posted task
+        };
+
+    private:
+
+        /**
+         * A Chase-Lev deque of tasks
+         * Only the owning worker calls push() and take(), any thread may
+         * call steal(). Arrays outgrown by push() are kept until the deque
+         * is destroyed, since a thief may still be reading from them.
+         */
+        class WorkDeque
+        {
+            private:
+                /**
+                 * A ring of task slots, its size a power of two
+                 */
+                struct Ring
+                {
+                    long long size;                 ///< Number of slots
+                    std::atomic<Task*>* slots;      ///< Slots of the ring
+
+                    Ring(long long size);
+                    ~Ring();
+                };
+
+                std::atomic<long long> top;     ///< Next slot to steal
+                std::atomic<long long> bottom;  ///< Next slot to push
+                std::atomic<Ring*> ring;        ///< Current ring
+                std::vector<Ring*> retired;     ///< Rings outgrown
+
+            public:
+                WorkDeque();
+                ~WorkDeque();
+
+                /**
+                 * Add a task at the bottom, owner only
+                 */
+                void push(Task* t);
+
+                /**
+                 * Remove the task at the bottom, owner only
+                 *
+                 * @return the task, or nullptr if the deque is empty
+                 */
+                Task* take();
+
+                /**
+                 * Remove the task at the top, any thread
+                 *
+                 * @return the task, or nullptr if the deque is empty or
+                 *         another thread got there first
+                 */
+                Task* steal();
+        };
+
+        static const int MAX_WORKERS = 256;   ///< Most workers in a pool
+
+        WorkDeque deques[MAX_WORKERS];      ///< One deque for each worker
+        std::vector<std::thread> workers;   ///< Threads of the pool
+        std::atomic<int> numWorkers;        ///< Workers started so far
+        std::mutex growLock;                ///< Guards starting workers
+
+        std::mutex injectLock;              ///< Guards injected
+        std::deque<Task*> injected;         ///< Tasks from outside the pool
+
+        std::mutex sleepLock;               ///< Guards sleeping workers
+        std::condition_variable wake;       ///< Signalled when work arrives
+        std::atomic<long long> queued;      ///< Tasks waiting to start
+        std::atomic<int> sleepers;          ///< Workers waiting for work
+        bool stopping;                      ///< True when the pool shuts down
+        bool pinned;                        ///< True to pin workers to CPUs
+        std::vector<int> cpus;              ///< CPUs workers are pinned to
+
+        /**
+         * Hand a task to the pool, on the calling worker's own deque if
+         * it is part of this pool
+         */
+        void submit(Task* t);
+
+        /**
+         * Find a task to run, from the worker's own deque, the other
+         * workers, or the shared queue
+         *
+         * @param self index of the calling worker, -1 if it is not one
+         *
+         * @return the task, or nullptr if there is none
+         */
+        Task* find(int self);
+
+        /**
+         * Run a task and tell its group
+         */
+        void execute(Task* t);
+
+        /**
+         * Pin a worker to one of the CPUs the process may run on
+         *
+         * @param index position of the worker in the pool
+         */
+        void pin(int index);
+
+        /**
+         * Body of every worker thread
+         *
+         * @param index position of the worker in the pool
+         */
+        void work(int index);
+
+    public:
+        /**
+         * A set of tasks that can be waited on together
+         * A thread waiting on a group runs tasks from the pool in the
+         * meantime, so groups may be nested inside tasks.
+         */
+        class Group
+        {
+            friend class ThreadPool;
+
+            private:
+                ThreadPool& pool;               ///< Pool that runs the tasks
+                std::atomic<long long> pending; ///< Tasks not yet finished
+                std::mutex lock;                ///< Guards finished
+                std::condition_variable finished;   ///< Signalled at zero
+
+            public:
+                /**
+                 * Constructor
+                 *
+                 * @param pool pool to run the tasks on
+                 */
+                Group(ThreadPool& pool);
+
+                /**
+                 * Destructor, waits for every task of the group
+                 */
+                ~Group();
+
+                /**
+                 * Run a task on the pool as part of this group
+                 *
+                 * @param fn work to run
+                 */
+                void run(const std::function<void()>& fn);
+
+                /**
+                 * Wait until every task of the group has finished
+                 * Without help, only the pool's own workers run the tasks,
+                 * which keeps them on the CPUs the workers are pinned to.
+                 *
+                 * @param help true to run tasks of the pool while waiting
+                 */
+                void wait(bool help = true);
+        };
+
+        /**
+         * Constructor
+         *
+         * @param workers number of workers to start right away
+         */
+        ThreadPool(int workers = 0);
+
+        /**
+         * Destructor, finishes waiting tasks and stops every worker
+         */
+        ~ThreadPool();
+
+        /**
+         * Get the pool shared by the whole program
+         * It starts without workers, callers reserve() as many as they
+         * need.
+         *
+         * @return the shared pool
+         */
+        static ThreadPool& shared();
+
+        /**
+         * Get the pool of one NUMA node, kept for the whole program
+         * It starts without workers and is pinned to the CPUs given the
+         * first time the node is asked for.
+         *
+         * @param node id of the node
+         * @param cpus CPUs of the node
+         *
+         * @return the pool of the node
+         */
+        static ThreadPool& forNode(int node, const std::vector<int>& cpus);
+
+        /**
+         * Make sure the pool has at least some number of workers
+         *
+         * @param workers number of workers wanted, capped at MAX_WORKERS
+         */
+        void reserve(int workers);
+
+        /**
+         * Get the number of workers started
+         *
+         * @return number of workers
+         */
+        int size() const;
+
+        /**
+         * Pin every worker, now and later, to its own CPU, wrapping
+         * around when there are more workers than CPUs
+         */
+        void pinWorkers();
+
+        /**
+         * Pin every worker, now and later, to one of a set of CPUs in
+         * turn, such as the CPUs of one NUMA node
+         *
+         * @param cpus CPUs to pin the workers to
+         */
+        void pinWorkers(const std::vector<int>& cpus);
+
+        /**
+         * Run a task on the pool without waiting for it
+         * Nothing is allocated: the task lives in the caller's memory,
+         * which must last until call is entered. A pool without workers
+         * is given one, since nobody waits on the task to run it.
+         *
+         * @param t task with call set
+         */
+        void post(Task* t);
+
+        /**
+         * Call fn over consecutive blocks of a range, in parallel
+         * At most maxTasks blocks are worked on at once, one of them by
+         * the calling thread, and the call returns once every block is
+         * done.
+         *
+         * @param begin first index of the range
+         * @param end one past the last index
+         * @param grain size of every block but the last
+         * @param fn work for the block from its first to one past its
+         *        last index
+         * @param maxTasks most blocks at once, 0 for one per core
+         */
+        void parallelFor(size_t begin, size_t end, size_t grain,
+                         const std::function<void(size_t, size_t)>& fn,
+                         int maxTasks = 0);
+};
+#endif
@@ -0,0 +1,234 @@
+#include <cerrno>
+#include <cstring>
+
+#include <linux/io_uring.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "Uring.h"
+
+const int Uring::SUBMIT_TRIES;
+
+//----------------------------------------------------------------------------
+Uring::Uring()
+{
+    this->fd = -1;
+    this->sqRing = nullptr;
+    this->sqRingSize = 0;
+    this->cqRing = nullptr;
+    this->cqRingSize = 0;
+    this->sqes = nullptr;
+    this->sqesSize = 0;
+    this->queued = 0;
+}
+
+//----------------------------------------------------------------------------
+Uring::~Uring()
+{
+    if(this->sqes != nullptr)
+        munmap(this->sqes, this->sqesSize);
+
+    if(this->cqRing != nullptr && this->cqRing != this->sqRing)
+        munmap(this->cqRing, this->cqRingSize);
+
+    if(this->sqRing != nullptr)
+        munmap(this->sqRing, this->sqRingSize);
+
+    if(this->fd >= 0)
+        close(this->fd);
+}
+
+//----------------------------------------------------------------------------
+bool Uring::init(unsigned entries)
+{
+    struct io_uring_params p;
+    std::memset(&p, 0, sizeof(p));
+
+    int ringFd = syscall(__NR_io_uring_setup, entries, &p);
+    if(ringFd < 0)
+        return false;
+
+    this->sqRingSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    this->cqRingSize = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+
+    // newer kernels share one mapping between both rings
+    bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if(single && this->cqRingSize > this->sqRingSize)
+        this->sqRingSize = this->cqRingSize;
+
+    void* sq = mmap(nullptr, this->sqRingSize, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    if(sq == MAP_FAILED)
+    {
+        close(ringFd);
+        return false;
+    }
+
+    void* cq = sq;
+    if(!single)
+    {
+        cq = mmap(nullptr, this->cqRingSize, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+        if(cq == MAP_FAILED)
+        {
+            munmap(sq, this->sqRingSize);
+            close(ringFd);
+            return false;
+        }
+    }
+
+    this->sqesSize = p.sq_entries * sizeof(io_uring_sqe);
+    void* sqeMap = mmap(nullptr, this->sqesSize, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    if(sqeMap == MAP_FAILED)
+    {
+        if(!single)
+            munmap(cq, this->cqRingSize);
+        munmap(sq, this->sqRingSize);
+        close(ringFd);
+        return false;
+    }
+
+    char* sqBase = static_cast<char*>(sq);
+    char* cqBase = static_cast<char*>(cq);
+
+    this->fd = ringFd;
+    this->sqRing = sq;
+    this->cqRing = cq;
+    this->sqes = static_cast<io_uring_sqe*>(sqeMap);
+
+    this->sqHead = reinterpret_cast<unsigned*>(sqBase + p.sq_off.head);
+    this->sqTail = reinterpret_cast<unsigned*>(sqBase + p.sq_off.tail);
+    this->sqMask = *reinterpret_cast<unsigned*>(sqBase + p.sq_off.ring_mask);
+    this->sqEntries = p.sq_entries;
+    this->sqArray = reinterpret_cast<unsigned*>(sqBase + p.sq_off.array);
+    this->cqHead = reinterpret_cast<unsigned*>(cqBase + p.cq_off.head);
+    this->cqTail = reinterpret_cast<unsigned*>(cqBase + p.cq_off.tail);
+    this->cqMask = *reinterpret_cast<unsigned*>(cqBase + p.cq_off.ring_mask);
+    this->cqes = reinterpret_cast<io_uring_cqe*>(cqBase + p.cq_off.cqes);
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+bool Uring::ready() const
+{
+    return this->fd >= 0;
+}
+
+//----------------------------------------------------------------------------
+bool Uring::registerBuffers(const struct iovec* bufs, unsigned n)
+{
+    return syscall(__NR_io_uring_register, this->fd, IORING_REGISTER_BUFFERS,
+                   bufs, n) == 0;
+}
+
+//----------------------------------------------------------------------------
+bool Uring::queue(int op, int file, int bufIndex, void* buf, unsigned len,
+                  off_t offset, unsigned long long userData)
+{
+    unsigned tail = *this->sqTail;
+    unsigned head = __atomic_load_n(this->sqHead, __ATOMIC_ACQUIRE);
+
+    if(tail - head >= this->sqEntries)
+        return false;
+
+    unsigned idx = tail & this->sqMask;
+    io_uring_sqe* sqe = &this->sqes[idx];
+
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = op;
+    sqe->fd = file;
+    sqe->addr = reinterpret_cast<unsigned long long>(buf);
+    sqe->len = len;
+    sqe->off = offset;
+    sqe->buf_index = bufIndex;
+    sqe->user_data = userData;
+
+    this->sqArray[idx] = idx;
+
+    // the kernel must see the entry before it sees the new tail
+    __atomic_store_n(this->sqTail, tail + 1, __ATOMIC_RELEASE);
+    this->queued++;
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+bool Uring::queueRead(int file, int bufIndex, void* buf, unsigned len,
+                      off_t offset, unsigned long long userData)
+{
+    return this->queue(IORING_OP_READ_FIXED, file, bufIndex, buf, len,
+                       offset, userData);
+}
+
+//----------------------------------------------------------------------------
+bool Uring::queueWrite(int file, int bufIndex, const void* buf, unsigned len,
+                       off_t offset, unsigned long long userData)
+{
+    return this->queue(IORING_OP_WRITE_FIXED, file, bufIndex,
+                       const_cast<void*>(buf), len, offset, userData);
+}
+
+//----------------------------------------------------------------------------
+bool Uring::submit()
+{
+    int tries = 0;
+
+    while(this->queued > 0)
+    {
+        int n = syscall(__NR_io_uring_enter, this->fd, this->queued, 0, 0,
+                        nullptr, 0);
+
+        if(n < 0 && errno != EINTR && errno != EAGAIN)
+            return false;
+
+        if(n > 0)
+        {
+            this->queued -= n;
+            tries = 0;
+            continue;
+        }
+
+        // callers read and write by hand when the kernel takes nothing
+        if(++tries == SUBMIT_TRIES)
+            return false;
+
+        sched_yield();
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+bool Uring::wait(unsigned long long& userData, int& res)
+{
+    if(!this->submit())
+        return false;
+
+    while(true)
+    {
+        unsigned head = *this->cqHead;
+        unsigned tail = __atomic_load_n(this->cqTail, __ATOMIC_ACQUIRE);
+
+        if(head != tail)
+        {
+            io_uring_cqe* cqe = &this->cqes[head & this->cqMask];
+            userData = cqe->user_data;
+            res = cqe->res;
+
+            // hand the slot back once it has been read
+            __atomic_store_n(this->cqHead, head + 1, __ATOMIC_RELEASE);
+
+            return true;
+        }
+
+        int n = syscall(__NR_io_uring_enter, this->fd, 0, 1,
+                        IORING_ENTER_GETEVENTS, nullptr, 0);
+
+        if(n < 0 && errno != EINTR && errno != EAGAIN)
+            return false;
+    }
+}
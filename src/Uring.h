@@ -0,0 +1,146 @@
+#ifndef URING_H_INCLUDED
+#define URING_H_INCLUDED
+
+#include <cstddef>
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+/**
+ * The Uring class is a minimal io_uring instance talking to the kernel
+ * through the raw system calls. It queues reads and writes on registered
+ * buffers and hands back their completions.
+ */
+class Uring
+{
+    private:
+        int fd;                     ///< Ring descriptor, -1 if not set up
+
+        void* sqRing;               ///< Mapping of the submission ring
+        size_t sqRingSize;          ///< Length of the submission mapping
+        void* cqRing;               ///< Mapping of the completion ring
+        size_t cqRingSize;          ///< Length of the completion mapping
+        io_uring_sqe* sqes;         ///< Submission queue entries
+        size_t sqesSize;            ///< Length of the entry mapping
+
+        unsigned* sqTail;           ///< Tail of the submission ring
+        unsigned* sqHead;           ///< Head of the submission ring
+        unsigned sqMask;            ///< Mask for submission indices
+        unsigned sqEntries;         ///< Number of submission entries
+        unsigned* sqArray;          ///< Indices of queued entries
+        unsigned* cqHead;           ///< Head of the completion ring
+        unsigned* cqTail;           ///< Tail of the completion ring
+        unsigned cqMask;            ///< Mask for completion indices
+        io_uring_cqe* cqes;         ///< Completion queue entries
+
+        unsigned queued;            ///< Entries not yet handed to the kernel
+
+        static const int SUBMIT_TRIES = 16; ///< Calls in a row that may
+                                            ///< hand nothing to the kernel
+                                            ///< before submit() gives up
+
+        /**
+         * Queue an operation on a registered buffer
+         *
+         * @return false if the submission ring is full
+         */
+        bool queue(int op, int file, int bufIndex, void* buf, unsigned len,
+                   off_t offset, unsigned long long userData);
+
+    public:
+        /**
+         * Default Constructor
+         */
+        Uring();
+
+        /**
+         * Destructor, tears down the ring
+         */
+        ~Uring();
+
+        /**
+         * Set up the ring
+         *
+         * @param entries number of submission entries
+         *
+         * @return false if io_uring is not available
+         */
+        bool init(unsigned entries);
+
+        /**
+         * Determine whether the ring was set up
+         *
+         * @return true if init() succeeded
+         */
+        bool ready() const;
+
+        /**
+         * Register buffers for fixed reads and writes
+         *
+         * @param bufs buffers to register
+         * @param n number of buffers
+         *
+         * @return true if the kernel accepted the buffers
+         */
+        bool registerBuffers(const struct iovec* bufs, unsigned n);
+
+        /**
+         * Queue a read into a registered buffer
+         *
+         * @param file descriptor to read from
+         * @param bufIndex index of the registered buffer
+         * @param buf where in the buffer the data goes
+         * @param len number of bytes to read
+         * @param offset file offset to read from
+         * @param userData value handed back with the completion
+         *
+         * @return false if the submission ring is full
+         */
+        bool queueRead(int file, int bufIndex, void* buf, unsigned len,
+                       off_t offset, unsigned long long userData);
+
+        /**
+         * Queue a write from a registered buffer
+         *
+         * @param file descriptor to write to
+         * @param bufIndex index of the registered buffer
+         * @param buf where in the buffer the data is
+         * @param len number of bytes to write
+         * @param offset file offset to write at
+         * @param userData value handed back with the completion
+         *
+         * @return false if the submission ring is full
+         */
+        bool queueWrite(int file, int bufIndex, const void* buf, unsigned len,
+                        off_t offset, unsigned long long userData);
+
+        /**
+         * Hand every queued operation to the kernel
+         * A kernel that keeps taking none of them, busy or interrupted,
+         * is given up on after SUBMIT_TRIES calls, and what is left stays
+         * queued for the next submit().
+         *
+         * @return false if the kernel refused them, or took none of them
+         *         in SUBMIT_TRIES calls
+         */
+        bool submit();
+
+        /**
+         * Wait for the next completion
+         * Anything still queued is submitted first.
+         *
+         * @param userData set to the value given when queueing
+         * @param res set to the result, bytes moved or a negative errno
+         *
+         * @return false if the ring is broken
+         */
+        bool wait(unsigned long long& userData, int& res);
+
+    private:
+        Uring(const Uring&);
+        Uring& operator=(const Uring&);
+};
+#endif
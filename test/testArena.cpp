@@ -0,0 +1,114 @@
+#include "catch.hpp"    // CATCH testing framework
+#include "../src/Arena.h"
+#include "../src/SudokuSolver.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+/**
+ * Every call to the global operator new in the test program
+ */
+static std::atomic<long long> allocations(0);
+
+void* operator new(std::size_t size)
+{
+    allocations++;
+
+    void* p = std::malloc(size ? size : 1);
+    if(p == nullptr)
+        throw std::bad_alloc();
+
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+TEST_CASE("Arena memory is handed out and given back", "[arena]")
+{
+    Arena arena(256);
+
+    char* a = arena.allocate<char>(3);
+    double* b = arena.allocate<double>(2);
+    REQUIRE( reinterpret_cast<std::uintptr_t>(b) % alignof(double) == 0 );
+    REQUIRE( reinterpret_cast<char*>(b) >= a + 3 );
+
+    Arena::Mark m = arena.mark();
+    int* c = arena.allocate<int>(10);
+    arena.reset(m);
+    REQUIRE( arena.allocate<int>(10) == c );
+
+    // too big for a block gets one of its own
+    char* big = arena.allocate<char>(1000);
+    big[999] = 'x';
+    REQUIRE( arena.capacity() >= 1256 );
+
+    // blocks are kept and reused after a reset
+    size_t capacity = arena.capacity();
+    arena.reset();
+    REQUIRE( arena.allocate<char>(3) == a );
+
+    for(int i = 0; i < 10; i++)
+    {
+        m = arena.mark();
+        arena.allocate<char>(200);
+        arena.allocate<char>(1000);
+        arena.reset(m);
+    }
+    REQUIRE( arena.capacity() == capacity );
+}
+
+TEST_CASE("Solving does not allocate once warmed up", "[arena]")
+{
+    std::string puzzles[] = {
+        ".7...3..9....89.5.2.9.7.1.3.5..1..249.7.5.8.148..3..7."
+        "6.4.2.3.8.3.89....7..3...4.",
+        "8..........36......7..9.2...5...7.......457.....1...3..."
+        "1....68..85...1..9....4..",
+        "..9748...7.........2.1.9.....7...24..64.1.59..98...3....."
+        "8.3.2.........6...2759.."
+    };
+
+    std::vector<Board> boards;
+    for(std::string& p: puzzles)
+    {
+        boards.push_back(Board());
+        REQUIRE( boards.back().readLine(p.data(), p.size()) == true );
+    }
+
+    SudokuSolver solver;
+    solver.search = true;
+
+    for(Board& b: boards)
+    {
+        solver.board = b;
+        solver.solveDriver();
+    }
+
+    long long before = allocations;
+    int solved = 0;
+
+    for(int run = 0; run < 3; run++)
+    {
+        for(Board& b: boards)
+        {
+            solver.board = b;
+            solved += solver.solveDriver();
+        }
+    }
+
+    long long after = allocations;
+
+    REQUIRE( solved == 9 );
+    REQUIRE( after - before == 0 );
+}
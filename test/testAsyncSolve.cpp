@@ -0,0 +1,211 @@
+#include "catch.hpp"    // CATCH testing framework
+#include "../src/AsyncSolve.h"
+#include "testHelpers.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Count a finished operation
+ */
+static void countDone(void* arg)
+{
+    static_cast<std::atomic<int>*>(arg)->fetch_add(1);
+}
+
+/**
+ * Wait for a count to reach a number
+ */
+static void waitFor(const std::atomic<int>& count, int n)
+{
+    while(count.load() < n)
+        std::this_thread::yield();
+}
+
+/**
+ * Write a board as a line
+ */
+static std::string line(const Board& b)
+{
+    char out[81];
+    b.writeLine(out);
+
+    return std::string(out, 81);
+}
+
+TEST_CASE("Operations solve boards in place on the pool", "[async]")
+{
+    std::vector<Board> boards(20);
+    for(Board& b: boards)
+        b.readLine(HARD, 81);
+
+    AsyncOptions opts;
+    opts.search = true;
+
+    std::vector<SolveOperation*> ops;
+    for(Board& b: boards)
+        ops.push_back(new SolveOperation(b, opts));
+
+    std::atomic<int> finished(0);
+    for(SolveOperation* op: ops)
+        op->start(countDone, &finished);
+
+    waitFor(finished, ops.size());
+
+    for(size_t i = 0; i < ops.size(); i++)
+    {
+        REQUIRE(ops[i]->stats.status == SOLVED);
+        REQUIRE(ops[i]->stats.searchNodes > 0);
+        REQUIRE(line(boards[i]) == HARD_SOLVED);
+        delete ops[i];
+    }
+
+    SECTION("Without search the board is left stuck")
+    {
+        Board b;
+        b.readLine(HARD, 81);
+
+        SolveOperation op(b);
+        finished = 0;
+        op.start(countDone, &finished);
+        waitFor(finished, 1);
+
+        REQUIRE(op.stats.status == STUCK);
+        REQUIRE(op.stats.searchNodes == 0);
+    }
+}
+
+TEST_CASE("A cancelled operation stops with the budget status", "[async]")
+{
+    Board b;
+    b.readLine(HARD, 81);
+
+    AsyncOptions opts;
+    opts.search = true;
+
+    SolveOperation op(b, opts);
+    op.cancel();
+
+    std::atomic<int> finished(0);
+    op.start(countDone, &finished);
+    waitFor(finished, 1);
+
+    REQUIRE(op.stats.status == BUDGET);
+    REQUIRE(op.stats.passes == 0);
+    REQUIRE(line(b) == HARD);
+
+    // the solver the worker keeps is not left cancelled
+    SolveOperation again(b, opts);
+    again.start(countDone, &finished);
+    waitFor(finished, 2);
+
+    REQUIRE(again.stats.status == SOLVED);
+}
+
+TEST_CASE("Frames are recycled by size class", "[async]")
+{
+    void* first = FramePool::operator new(100);
+    FramePool::operator delete(first, 100);
+
+    long long before = FramePool::allocated();
+
+    // any size in the same class gets the frame back
+    void* second = FramePool::operator new(120);
+    REQUIRE(second == first);
+    REQUIRE(FramePool::allocated() == before);
+
+    void* third = FramePool::operator new(100);
+    REQUIRE(third != second);
+    REQUIRE(FramePool::allocated() == before + 1);
+
+    FramePool::operator delete(second, 120);
+    FramePool::operator delete(third, 100);
+
+    // frames too large for a class come from the heap every time
+    void* big = FramePool::operator new(FramePool::MAX_FRAME + 1);
+    REQUIRE(FramePool::allocated() == before + 2);
+    FramePool::operator delete(big, FramePool::MAX_FRAME + 1);
+}
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+/**
+ * A coroutine nobody waits on, with its frames from the pool
+ */
+struct Detached
+{
+    struct promise_type : FramePool
+    {
+        Detached get_return_object()
+        {
+            return Detached();
+        }
+
+        std::suspend_never initial_suspend() noexcept
+        {
+            return std::suspend_never();
+        }
+
+        std::suspend_never final_suspend() noexcept
+        {
+            return std::suspend_never();
+        }
+
+        void return_void()
+        {
+        }
+
+        void unhandled_exception()
+        {
+            std::terminate();
+        }
+    };
+};
+
+/**
+ * Solve a board from a coroutine and count it done
+ */
+static Detached solveFrom(Board& b, AsyncOptions opts, std::stop_token stop,
+                          SolveStats& stats, std::thread::id& resumedOn,
+                          std::atomic<int>& finished)
+{
+    stats = co_await solveAsync(b, opts, stop);
+    resumedOn = std::this_thread::get_id();
+    finished++;
+}
+
+TEST_CASE("Coroutines await solves on the pool", "[async]")
+{
+    Board b;
+    b.readLine(HARD, 81);
+
+    AsyncOptions opts;
+    opts.search = true;
+
+    SolveStats stats;
+    std::thread::id resumedOn;
+    std::atomic<int> finished(0);
+
+    SECTION("The coroutine is resumed with the board solved")
+    {
+        solveFrom(b, opts, std::stop_token(), stats, resumedOn, finished);
+        waitFor(finished, 1);
+
+        REQUIRE(stats.status == SOLVED);
+        REQUIRE(line(b) == HARD_SOLVED);
+        REQUIRE(resumedOn != std::this_thread::get_id());
+    }
+
+    SECTION("A stop request cancels the solve")
+    {
+        std::stop_source source;
+        source.request_stop();
+
+        solveFrom(b, opts, source.get_token(), stats, resumedOn, finished);
+        waitFor(finished, 1);
+
+        REQUIRE(stats.status == BUDGET);
+        REQUIRE(line(b) == HARD);
+    }
+}
+#endif
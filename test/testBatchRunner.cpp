@@ -0,0 +1,221 @@
+#include "catch.hpp"    // CATCH testing framework
+#include "../src/BatchRunner.h"
+#include "testHelpers.h"
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+TEST_CASE("Batch of puzzles is solved", "[batch]")
+{
+    std::string easy = ".7...3..9....89.5.2.9.7.1.3.5..1..249.7.5.8.148..3..7."
+                       "6.4.2.3.8.3.89....7..3...4.";
+    std::string easySolved = "875143269163289457249675183356718924927456831"
+                             "481932675614527398532894716798361542";
+
+    std::stringstream ins;
+    ins << "# comment line\n"
+        << easy << "\n"
+        << "\n"
+        << "not a puzzle\n"
+        << easy << "\r\n";
+
+    int fd = tempFile();
+    OutputBuffer out(fd);
+    BatchRunner runner;
+    runner.run(ins, out);
+
+    REQUIRE( runner.count == 2 );
+    REQUIRE( runner.solved == 2 );
+    REQUIRE( runner.malformed == 1 );
+    REQUIRE( slurp(fd) == easySolved + "\n" + easySolved + "\n" );
+
+    // puzzle and solution on one line
+    ins.clear();
+    ins.seekg(0);
+    out.content = OutputBuffer::PUZZLE_SOLUTION;
+    REQUIRE( ftruncate(fd, 0) == 0 );
+    lseek(fd, 0, SEEK_SET);
+    runner.run(ins, out);
+
+    std::string both = easy + "," + easySolved + "\n";
+    REQUIRE( slurp(fd) == both + both );
+
+    close(fd);
+}
+
+TEST_CASE("Blank lines and comments are skipped", "[batch]")
+{
+    REQUIRE( BatchRunner::isSkipped("", 0) );
+    REQUIRE( BatchRunner::isSkipped("\r", 1) );
+    REQUIRE( BatchRunner::isSkipped(" \t\r", 3) );
+    REQUIRE( BatchRunner::isSkipped("# comment", 9) );
+    REQUIRE_FALSE( BatchRunner::isSkipped(" 1", 2) );
+    REQUIRE_FALSE( BatchRunner::isSkipped("not a puzzle", 12) );
+}
+
+TEST_CASE("Unsolvable puzzles do not stop a batch", "[batch]")
+{
+    // the 2s leave no room for a 2 in the top right block
+    std::string bad(81, '.');
+    bad[10] = '2';
+    bad[23] = '2';
+    bad[34] = '2';
+    bad[42] = '2';
+    bad[62] = '2';
+
+    std::stringstream ins;
+    ins << bad << "\n" << bad << "\n";
+
+    int fd = tempFile();
+    OutputBuffer out(fd);
+    BatchRunner runner;
+    runner.run(ins, out);
+    close(fd);
+
+    REQUIRE( runner.count == 2 );
+    REQUIRE( runner.solved == 0 );
+    REQUIRE( runner.malformed == 0 );
+}
+
+TEST_CASE("Threaded batch matches a single thread", "[batch]")
+{
+    std::string easy = ".7...3..9....89.5.2.9.7.1.3.5..1..249.7.5.8.148..3..7."
+                       "6.4.2.3.8.3.89....7..3...4.";
+    std::string bad(81, '.');
+    bad[10] = '2';
+    bad[23] = '2';
+    bad[34] = '2';
+    bad[42] = '2';
+    bad[62] = '2';
+
+    // enough records to span several chunks, with a few broken ones
+    char path[] = "/tmp/batchInputXXXXXX";
+    int in = mkstemp(path);
+    std::string text;
+    for(int i = 0; i < 1000; i++)
+    {
+        std::string rec = (i % 7 == 0) ? bad : easy;
+        rec[80 - i % 40] = '.';
+        text += (i % 97 == 0) ? "garbage\n" : rec + "\n";
+    }
+    REQUIRE( write(in, text.data(), text.size()) == (ssize_t)text.size() );
+    close(in);
+
+    std::string results[3];
+    long long counts[3][3];
+
+    for(int run = 0; run < 3; run++)
+    {
+        int fd = tempFile();
+        PuzzleReader reader;
+        REQUIRE( reader.open(path) == true );
+
+        OutputBuffer out(fd);
+        out.content = OutputBuffer::PUZZLE_SOLUTION;
+
+        BatchRunner runner;
+        runner.threads = (run == 0) ? 1 : 4;
+        runner.numa = (run == 2);
+        runner.run(reader, out);
+
+        std::ostringstream summary;
+        runner.summary(summary);
+        REQUIRE( (summary.str().find("node ") != std::string::npos) ==
+                 runner.numa );
+
+        results[run] = slurp(fd);
+        counts[run][0] = runner.count;
+        counts[run][1] = runner.solved;
+        counts[run][2] = runner.malformed;
+        close(fd);
+    }
+
+    std::remove(path);
+
+    REQUIRE( counts[0][0] == 989 );
+    REQUIRE( counts[0][2] == 11 );
+    REQUIRE( counts[1][0] == counts[0][0] );
+    REQUIRE( counts[1][1] == counts[0][1] );
+    REQUIRE( counts[1][2] == counts[0][2] );
+    REQUIRE( results[1] == results[0] );
+    REQUIRE( counts[2][1] == counts[0][1] );
+    REQUIRE( results[2] == results[0] );
+}
+
+TEST_CASE("Output is written through io_uring", "[batch]")
+{
+    int fd = tempFile();
+    std::string expected;
+
+    {
+        // plain writes are used where io_uring is missing
+        OutputBuffer out(fd, 1024);
+        out.useUring(3);
+
+        // enough to cycle through every buffer a few times
+        for(int i = 0; i < 500; i++)
+        {
+            std::string rec = std::to_string(i) + " " +
+                              std::string(i % 50, 'x') + "\n";
+            out.append(rec.data(), rec.size());
+            expected += rec;
+        }
+
+        // a single append bigger than a buffer still goes out whole
+        std::string big(3000, 'y');
+        out.append(big.data(), big.size());
+        expected += big;
+
+        REQUIRE( out.flush() == true );
+    }
+
+    REQUIRE( slurp(fd) == expected );
+    close(fd);
+}
+
+TEST_CASE("Records carry the solve statistics", "[batch]")
+{
+    std::string easy = ".7...3..9....89.5.2.9.7.1.3.5..1..249.7.5.8.148..3..7."
+                       "6.4.2.3.8.3.89....7..3...4.";
+    std::string easySolved = "875143269163289457249675183356718924927456831"
+                             "481932675614527398532894716798361542";
+
+    std::stringstream ins;
+    ins << "\n" << easy << "\n";
+
+    int fd = tempFile();
+    OutputBuffer out(fd);
+    out.layout = OutputBuffer::JSONL;
+
+    BatchRunner runner;
+    runner.run(ins, out);
+
+    // the timing differs from run to run, check everything before it
+    std::string rec = slurp(fd);
+    std::string expected = "{\"id\":2,\"input\":\"" + easy +
+                           "\",\"solution\":\"" + easySolved +
+                           "\",\"status\":\"solved\",\"placements\":46,"
+                           "\"search_nodes\":0,\"strategies\":{";
+
+    REQUIRE( rec.substr(0, expected.size()) == expected );
+    REQUIRE( rec.find("},\"solve_ns\":") != std::string::npos );
+    REQUIRE( rec.substr(rec.size() - 2) == "}\n" );
+
+    // CSV starts with a header line
+    REQUIRE( ftruncate(fd, 0) == 0 );
+    lseek(fd, 0, SEEK_SET);
+    ins.clear();
+    ins.seekg(0);
+    out.layout = OutputBuffer::CSV;
+    runner.run(ins, out);
+
+    rec = slurp(fd);
+    expected = "id,input,solution,status,placements,search_nodes,"
+               "block_singles,row_singles,col_singles,solve_ns\n"
+               "2," + easy + "," + easySolved + ",solved,46,0,";
+
+    REQUIRE( rec.substr(0, expected.size()) == expected );
+
+    close(fd);
+}
@@ -3,6 +3,8 @@
 #include <cstdlib>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <string>
 
 TEST_CASE("SudokuBoard constructors are called", "[constructor]")
 {
@@ -204,3 +206,60 @@ TEST_CASE("Read function is called", "[read]")
 
     REQUIRE( B == A );
 }
+
+TEST_CASE("Line format is read and written", "[line]")
+{
+    std::string line = ".7...3..9....89.5.2.9.7.1.3.5..1..249.7.5.8.148..3..7."
+                       "6.4.2.3.8.3.89....7..3...4.";
+
+    Board A;
+
+    // valid line, with a trailing carriage return
+    REQUIRE( A.readLine((line + "\r").data(), line.size() + 1) == true );
+    REQUIRE( A.getCell(0, 1) == 7 );
+    REQUIRE( A.getCell(0, 0) == -1 );
+    REQUIRE( A.getCell(8, 7) == 4 );
+    REQUIRE( A.getFilled() == 35 );
+
+    // zeros are empty spaces as well
+    std::string zeros(line);
+    for(char& ch: zeros)
+        if(ch == '.')
+            ch = '0';
+
+    Board B;
+    REQUIRE( B.readLine(zeros.data(), zeros.size()) == true );
+    REQUIRE( B == A );
+
+    // writing reproduces the original line
+    char out[81];
+    A.writeLine(out);
+    REQUIRE( std::string(out, 81) == line );
+
+    // bad characters and lengths are rejected without changing the board
+    Board C(A);
+    std::string bad(line);
+    bad[40] = 'x';
+    REQUIRE( C.readLine(bad.data(), bad.size()) == false );
+    REQUIRE( C.readLine(line.data(), 80) == false );
+    REQUIRE( C == A );
+}
+
+TEST_CASE("Pretty layout matches display", "[display]")
+{
+    std::ifstream inf;
+    inf.open("test/easyPuzzle.txt");
+
+    Board A;
+    inf >> A;
+
+    std::stringstream outs;
+    A.display(outs);
+
+    char out[Board::PRETTY_SIZE];
+    int n = A.writePretty(out);
+
+    REQUIRE( n == Board::PRETTY_SIZE );
+    REQUIRE( std::string(out, n) == outs.str() );
+    REQUIRE( outs.str().substr(0, 25) == "   7   ||     3 ||     9\n" );
+}
@@ -0,0 +1,150 @@
+#include "catch.hpp"    // CATCH testing framework
+#include "../src/Canonical.h"
+#include "../src/CanonicalCache.h"
+#include <cstdlib>
+#include <string>
+
+/**
+ * Pick a random transform
+ *
+ * @param sym transform to fill in
+ */
+static void randomSymmetry(Symmetry& sym)
+{
+    int bands[3] = {0, 1, 2};
+    int stacks[3] = {0, 1, 2};
+
+    for(int i = 2; i > 0; i--)
+    {
+        std::swap(bands[i], bands[std::rand() % (i + 1)]);
+        std::swap(stacks[i], stacks[std::rand() % (i + 1)]);
+    }
+
+    sym.transpose = std::rand() % 2;
+
+    for(int b = 0; b < 3; b++)
+    {
+        int rows[3] = {0, 1, 2};
+        int cols[3] = {0, 1, 2};
+
+        for(int i = 2; i > 0; i--)
+        {
+            std::swap(rows[i], rows[std::rand() % (i + 1)]);
+            std::swap(cols[i], cols[std::rand() % (i + 1)]);
+        }
+
+        for(int i = 0; i < 3; i++)
+        {
+            sym.rows[b * 3 + i] = bands[b] * 3 + rows[i];
+            sym.cols[b * 3 + i] = stacks[b] * 3 + cols[i];
+        }
+    }
+
+    for(int d = 1; d <= 9; d++)
+        sym.digits[d] = d;
+    for(int d = 9; d > 1; d--)
+        std::swap(sym.digits[d], sym.digits[1 + std::rand() % d]);
+}
+
+TEST_CASE("Equivalent boards have the same canonical form", "[canonical]")
+{
+    std::string puzzles[] = {
+        ".7...3..9....89.5.2.9.7.1.3.5..1..249.7.5.8.148..3..7."
+        "6.4.2.3.8.3.89....7..3...4.",
+        "..3.2.6..9..3.5..1..18.64....81.29..7.......8..67.82...."
+        "26.95..8..2.3..9..5.1.3..",
+        "4.....8.5.3..........7......2.....6.....8.4......1......."
+        "6.3.7.5..2.....1.4......"
+    };
+
+    std::srand(40);
+
+    for(int p = 0; p < 3; p++)
+    {
+        Board b;
+        REQUIRE(b.readLine(puzzles[p].data(), puzzles[p].size()));
+
+        Board canon;
+        Symmetry sym;
+        canonicalForm(b, canon, sym);
+
+        Board check;
+        sym.apply(b, check);
+        REQUIRE(check == canon);
+
+        sym.invert(canon, check);
+        REQUIRE(check == b);
+
+        for(int i = 0; i < 20; i++)
+        {
+            Symmetry shuffle;
+            randomSymmetry(shuffle);
+
+            Board moved;
+            shuffle.apply(b, moved);
+
+            Board back;
+            shuffle.invert(moved, back);
+            REQUIRE(back == b);
+
+            Board other;
+            Symmetry otherSym;
+            canonicalForm(moved, other, otherSym);
+            REQUIRE(other == canon);
+        }
+    }
+}
+
+TEST_CASE("Cache hits map solutions back to the board asked for",
+          "[canonical]")
+{
+    std::string line = ".7...3..9....89.5.2.9.7.1.3.5..1..249.7.5.8.148..3..7."
+                       "6.4.2.3.8.3.89....7..3...4.";
+
+    Board puzzle;
+    REQUIRE(puzzle.readLine(line.data(), line.size()));
+
+    CanonicalCache cache;
+    SudokuSolver solver;
+    solver.board = puzzle;
+    REQUIRE(cache.solve(solver));
+    REQUIRE(cache.entries().misses() == 1);
+    REQUIRE(cache.entries().size() == 1);
+
+    std::srand(41);
+
+    for(int i = 0; i < 10; i++)
+    {
+        Symmetry shuffle;
+        randomSymmetry(shuffle);
+
+        Board moved;
+        shuffle.apply(puzzle, moved);
+
+        SudokuSolver fresh;
+        fresh.board = moved;
+        fresh.solveDriver();
+
+        solver.board = moved;
+        REQUIRE(cache.solve(solver));
+        REQUIRE(solver.board == fresh.board);
+        REQUIRE(solver.stats.placements == fresh.stats.placements);
+    }
+
+    REQUIRE(cache.entries().hits() == 10);
+    REQUIRE(cache.entries().misses() == 1);
+
+    // stuck boards are kept too, budgeted solves skip the cache
+    Board empty;
+    solver.board = empty;
+    REQUIRE_FALSE(cache.solve(solver));
+    REQUIRE(solver.stats.status == STUCK);
+    REQUIRE(cache.entries().size() == 2);
+
+    solver.board = puzzle;
+    solver.budget = 1;
+    cache.solve(solver);
+    REQUIRE(solver.stats.status == BUDGET);
+    REQUIRE(cache.entries().hits() == 10);
+    REQUIRE(cache.entries().misses() == 2);
+}
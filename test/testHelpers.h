@@ -0,0 +1,52 @@
+#ifndef TESTHELPERS_H_INCLUDED
+#define TESTHELPERS_H_INCLUDED
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+/**
+ * A puzzle cross checking alone gets stuck on, and its only solution
+ */
+static const char* const HARD =
+    "4.....8.5.3..........7......2.....6.....8.4......1......."
+    "6.3.7.5..2.....1.4......";
+static const char* const HARD_SOLVED =
+    "417369825632158947958724316825437169791586432346912758289643571"
+    "573291684164875293";
+
+/**
+ * Read back everything written to a temporary file
+ *
+ * @param fd file from tempFile()
+ *
+ * @return the whole file
+ */
+inline std::string slurp(int fd)
+{
+    std::string text;
+    char buf[4096];
+    ssize_t n;
+
+    lseek(fd, 0, SEEK_SET);
+    while((n = read(fd, buf, sizeof(buf))) > 0)
+        text.append(buf, n);
+
+    return text;
+}
+
+/**
+ * Create an unlinked temporary file
+ *
+ * @return descriptor of the file, to be closed by the caller
+ */
+inline int tempFile()
+{
+    char path[] = "/tmp/sudokuTestXXXXXX";
+    int fd = mkstemp(path);
+    std::remove(path);
+
+    return fd;
+}
+#endif
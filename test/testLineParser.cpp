@@ -0,0 +1,101 @@
+#include "catch.hpp"    // CATCH testing framework
+#include "../src/LineParser.h"
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/**
+ * Collect every parser the processor can run
+ */
+static std::vector<bool (*)(const char*, int*)> parsers()
+{
+    std::vector<bool (*)(const char*, int*)> all;
+
+    all.push_back(parseCellsScalar);
+    all.push_back(parseCells);
+
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("sse4.1"))
+        all.push_back(parseCellsSse41);
+    if(__builtin_cpu_supports("avx2"))
+        all.push_back(parseCellsAvx2);
+
+    return all;
+}
+
+TEST_CASE("Every parser agrees on valid lines", "[parser]")
+{
+    const char alphabet[] = ".0123456789";
+    std::srand(81);
+
+    for(int trial = 0; trial < 200; trial++)
+    {
+        std::string line(81, '.');
+        for(char& ch: line)
+            ch = alphabet[std::rand() % 11];
+
+        std::vector<int> expected;
+        for(char ch: line)
+            expected.push_back((ch == '.' || ch == '0') ? -1 : ch - '0');
+
+        for(bool (*parse)(const char*, int*): parsers())
+        {
+            int cells[81];
+
+            REQUIRE( parse(line.data(), cells) == true );
+            REQUIRE( std::vector<int>(cells, cells + 81) == expected );
+        }
+    }
+}
+
+TEST_CASE("Every parser rejects a bad character anywhere", "[parser]")
+{
+    const char bad[] = {'/', ':', 'a', ' ', '\n', '\0', '\x80', '\xff'};
+
+    for(int pos = 0; pos < 81; pos++)
+    {
+        for(char ch: bad)
+        {
+            std::string line(81, '5');
+            line[pos] = ch;
+
+            for(bool (*parse)(const char*, int*): parsers())
+            {
+                // a rejected line leaves the cells alone
+                int cells[81];
+                for(int i = 0; i < 81; i++)
+                    cells[i] = 42;
+
+                REQUIRE( parse(line.data(), cells) == false );
+                REQUIRE( std::vector<int>(cells, cells + 81) ==
+                         std::vector<int>(81, 42) );
+            }
+        }
+    }
+}
+
+TEST_CASE("Parsers stay within the 81 characters", "[parser]")
+{
+    // put the line right before a page that can not be read
+    long page = sysconf(_SC_PAGESIZE);
+    char* map = static_cast<char*>(mmap(nullptr, 2 * page,
+                                        PROT_READ | PROT_WRITE,
+                                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    REQUIRE( map != MAP_FAILED );
+    REQUIRE( mprotect(map + page, page, PROT_NONE) == 0 );
+
+    char* line = map + page - 81;
+    std::memset(line, '7', 81);
+
+    for(bool (*parse)(const char*, int*): parsers())
+    {
+        int cells[81];
+        REQUIRE( parse(line, cells) == true );
+        REQUIRE( cells[80] == 7 );
+    }
+
+    munmap(map, 2 * page);
+}
@@ -0,0 +1,86 @@
+#include "catch.hpp"    // CATCH testing framework
+#include "../src/LockstepSolver.h"
+#include <string>
+#include <vector>
+
+TEST_CASE("Lockstep groups match solving one board at a time", "[lockstep]")
+{
+    std::string puzzles[] = {
+        ".7...3..9....89.5.2.9.7.1.3.5..1..249.7.5.8.148..3..7."
+        "6.4.2.3.8.3.89....7..3...4.",
+        "..3.2.6..9..3.5..1..18.64....81.29..7.......8..67.82...."
+        "26.95..8..2.3..9..5.1.3..",
+        "4.....8.5.3..........7......2.....6.....8.4......1......."
+        "6.3.7.5..2.....1.4......"
+    };
+
+    // solved, stuck, and contradicting boards, and a group left short
+    std::vector<Board> boards(45);
+    for(size_t i = 0; i < boards.size(); i++)
+    {
+        std::string line = puzzles[i % 3];
+        line[(i * 7) % 81] = '.';
+        boards[i].readLine(line.data(), line.size());
+
+        if(i % 9 == 4)
+            boards[i] = Board();
+        if(i % 9 == 8)
+            boards[i].setCell(0, 0, boards[i].getCell(0, 1) == -1 ? 7 :
+                                    boards[i].getCell(0, 1));
+    }
+
+    for(int budget = 0; budget <= 2; budget += 2)
+    {
+        LockstepSolver group;
+        group.budget = budget;
+
+        std::vector<Result> results(boards.size());
+        for(size_t i = 0; i < boards.size(); i += LockstepSolver::LANES)
+        {
+            int n = std::min<size_t>(LockstepSolver::LANES,
+                                     boards.size() - i);
+            group.solve(&boards[i], n, &results[i]);
+        }
+
+        for(size_t i = 0; i < boards.size(); i++)
+        {
+            SudokuSolver solver(boards[i]);
+            solver.budget = budget;
+            solver.solveDriver();
+
+            REQUIRE( results[i].solution == solver.board );
+            REQUIRE( results[i].stats.status == solver.stats.status );
+            REQUIRE( results[i].stats.placements == solver.stats.placements );
+        }
+    }
+}
+
+TEST_CASE("Batches can be solved in lockstep", "[lockstep]")
+{
+    std::string easy = ".7...3..9....89.5.2.9.7.1.3.5..1..249.7.5.8.148..3..7."
+                       "6.4.2.3.8.3.89....7..3...4.";
+
+    std::vector<Board> boards(50);
+    for(size_t i = 0; i < boards.size(); i++)
+    {
+        std::string line = easy;
+        line[i % 81] = '.';
+        boards[i].readLine(line.data(), line.size());
+    }
+
+    BatchOptions opts;
+    opts.threads = 2;
+    opts.lockstep = true;
+
+    std::vector<Result> results(boards.size());
+    solveBatch(boards.data(), boards.size(), results.data(), opts);
+
+    for(size_t i = 0; i < boards.size(); i++)
+    {
+        SudokuSolver solver(boards[i]);
+        solver.solveDriver();
+
+        REQUIRE( results[i].solution == solver.board );
+        REQUIRE( results[i].stats.status == solver.stats.status );
+    }
+}
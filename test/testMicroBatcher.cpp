@@ -0,0 +1,171 @@
+#include "catch.hpp"    // CATCH testing framework
+#include "../src/MicroBatcher.h"
+#include "../src/SudokuSolver.h"
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Micro-batches give every request its own results", "[batcher]")
+{
+    std::string puzzles[] = {
+        ".7...3..9....89.5.2.9.7.1.3.5..1..249.7.5.8.148..3..7."
+        "6.4.2.3.8.3.89....7..3...4.",
+        "..3.2.6..9..3.5..1..18.64....81.29..7.......8..67.82...."
+        "26.95..8..2.3..9..5.1.3..",
+        "4.....8.5.3..........7......2.....6.....8.4......1......."
+        "6.3.7.5..2.....1.4......"
+    };
+
+    std::vector<Board> boards(60);
+    std::vector<SudokuSolver> fresh(60);
+    for(size_t i = 0; i < boards.size(); i++)
+    {
+        boards[i].readLine(puzzles[i % 3].data(), 81);
+        fresh[i].board = boards[i];
+        fresh[i].solveDriver();
+    }
+
+    MicroBatcher batcher;
+    batcher.maxBatch = 8;
+    batcher.maxWindow = 50000;
+    batcher.target = 10000000;
+    batcher.start();
+
+    std::mutex lock;
+    std::vector<int> answered(60, 0);
+    std::vector<bool> matched(60, false);
+
+    // requests of 1 to 5 boards from two threads, some larger than a batch
+    auto client = [&](size_t first, size_t last)
+    {
+        for(size_t i = first; i < last; )
+        {
+            size_t n = std::min<size_t>(1 + i % 5, last - i);
+            batcher.submit(&boards[i], n, false, 0,
+                           [&, i, n](const Result* results, long long)
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                for(size_t k = 0; k < n; k++)
+                {
+                    answered[i + k]++;
+                    matched[i + k] =
+                        results[k].solution == fresh[i + k].board &&
+                        results[k].stats.status == fresh[i + k].stats.status;
+                }
+            });
+            i += n;
+        }
+    };
+
+    std::thread a(client, 0, 30);
+    std::thread b(client, 30, 50);
+    client(50, 60);
+    a.join();
+    b.join();
+
+    // a request with no boards is answered at once
+    bool empty = false;
+    batcher.submit(boards.data(), 0, false, 0,
+                   [&](const Result*, long long) { empty = true; });
+    REQUIRE( empty == true );
+
+    batcher.stop();
+
+    for(size_t i = 0; i < answered.size(); i++)
+    {
+        REQUIRE( answered[i] == 1 );
+        REQUIRE( matched[i] == true );
+    }
+
+    REQUIRE( batcher.boards == 60 );
+    REQUIRE( batcher.batches >= 60 / 8 );
+}
+
+TEST_CASE("Micro-batches keep search and budget apart", "[batcher]")
+{
+    std::string line = "4.....8.5.3..........7......2.....6.....8.4......1......."
+                       "6.3.7.5..2.....1.4......";
+    Board board;
+    board.readLine(line.data(), line.size());
+
+    MicroBatcher batcher;
+    batcher.maxWindow = 50000;
+    batcher.start();
+
+    int plain = -1;
+    int guessed = -1;
+    int limited = -1;
+
+    batcher.submit(&board, 1, false, 0,
+                   [&](const Result* r, long long)
+                   { plain = r[0].stats.status; });
+    batcher.submit(&board, 1, true, 0,
+                   [&](const Result* r, long long)
+                   { guessed = r[0].stats.status; });
+    batcher.submit(&board, 1, false, 1,
+                   [&](const Result* r, long long)
+                   { limited = r[0].stats.status; });
+    batcher.stop();
+
+    REQUIRE( plain == STUCK );
+    REQUIRE( guessed == SOLVED );
+    REQUIRE( limited == BUDGET );
+    REQUIRE( batcher.batches == 3 );
+}
+
+TEST_CASE("The window follows the load and the target", "[batcher]")
+{
+    std::string line = "4.....8.5.3..........7......2.....6.....8.4......1......."
+                       "6.3.7.5..2.....1.4......";
+    Board board;
+    board.readLine(line.data(), line.size());
+
+    MicroBatcher batcher;
+    batcher.maxWindow = 2000;
+    batcher.target = 1;
+    batcher.start();
+    REQUIRE( batcher.window() == 2000 );
+
+    // send some requests at once and wait for all of them
+    auto burst = [&](int n)
+    {
+        std::vector<std::promise<void>> done(n);
+        for(int i = 0; i < n; i++)
+        {
+            std::promise<void>* p = &done[i];
+            batcher.submit(&board, 1, false, 0, [p](const Result*, long long)
+            {
+                p->set_value();
+            });
+        }
+
+        for(int i = 0; i < n; i++)
+            done[i].get_future().wait();
+    };
+
+    // the requests take far longer than the target, the window is
+    // adjusted after a batch is answered so the last may not count yet
+    for(int i = 0; i < 5; i++)
+        burst(3);
+
+    REQUIRE( batcher.window() <= 2000 / 16 );
+
+    // it grows back, a step at a time, once they meet it
+    batcher.target = 10000000;
+    for(int i = 0; i < 4; i++)
+        burst(3);
+    batcher.stop();
+
+    REQUIRE( batcher.window() > 2000 / 16 );
+    REQUIRE( batcher.window() < 2000 );
+
+    // and closes when there is nobody to wait for
+    batcher.start();
+    for(int i = 0; i < 5; i++)
+        burst(1);
+    batcher.stop();
+
+    REQUIRE( batcher.window() <= 2000 / 16 );
+}
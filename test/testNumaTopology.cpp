@@ -0,0 +1,66 @@
+#include "catch.hpp"    // CATCH testing framework
+#include "../src/NumaTopology.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+TEST_CASE("CPU lists are parsed", "[numa]")
+{
+    std::vector<int> list;
+
+    REQUIRE( NumaTopology::parseCpuList("0-3,8,10-11\n", list) == true );
+    REQUIRE( list == std::vector<int>({0, 1, 2, 3, 8, 10, 11}) );
+
+    REQUIRE( NumaTopology::parseCpuList("5", list) == true );
+    REQUIRE( list == std::vector<int>({5}) );
+
+    REQUIRE( NumaTopology::parseCpuList("", list) == true );
+    REQUIRE( list.empty() );
+
+    REQUIRE( NumaTopology::parseCpuList("3-1", list) == false );
+    REQUIRE( NumaTopology::parseCpuList("a", list) == false );
+    REQUIRE( NumaTopology::parseCpuList("1-", list) == false );
+    REQUIRE( NumaTopology::parseCpuList("1 2", list) == false );
+}
+
+TEST_CASE("Nodes are read from sysfs", "[numa]")
+{
+    char root[] = "/tmp/numaTopologyXXXXXX";
+    REQUIRE( mkdtemp(root) != nullptr );
+    std::string dir = root;
+
+    // two nodes with CPUs, one with memory only, and unrelated entries
+    const char* nodes[][2] = {{"node0", "0-1\n"}, {"node1", "2,3\n"},
+                              {"node2", "\n"}, {"nodex", "4\n"}};
+
+    for(auto& node: nodes)
+    {
+        mkdir((dir + "/" + node[0]).c_str(), 0700);
+        std::ofstream((dir + "/" + node[0] + "/cpulist").c_str()) << node[1];
+    }
+
+    NumaTopology topology;
+    REQUIRE( topology.load(dir) == true );
+    REQUIRE( topology.size() == 2 );
+    REQUIRE( topology.ids == std::vector<int>({0, 1}) );
+    REQUIRE( topology.cpus[0] == std::vector<int>({0, 1}) );
+    REQUIRE( topology.cpus[1] == std::vector<int>({2, 3}) );
+
+    for(auto& node: nodes)
+    {
+        std::remove((dir + "/" + node[0] + "/cpulist").c_str());
+        rmdir((dir + "/" + node[0]).c_str());
+    }
+    rmdir(root);
+
+    // without sysfs every allowed CPU ends up on one node
+    REQUIRE( topology.load(dir) == false );
+    REQUIRE( topology.size() == 0 );
+
+    topology.keepAllowed();
+    REQUIRE( topology.size() == 1 );
+    REQUIRE( topology.cpus[0].size() > 0 );
+}
@@ -0,0 +1,106 @@
+#include "catch.hpp"    // CATCH testing framework
+#include "../src/PackedCorpus.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+TEST_CASE("Boards are packed four bits to a cell", "[packed]")
+{
+    std::vector<int> testBoard(81, -1);
+    for(int i = 0; i < 81; i += 2)
+        testBoard[i] = (i % 9) + 1;
+
+    Board A(testBoard);
+    unsigned char packed[Board::PACKED_SIZE];
+    A.writePacked(packed);
+
+    // cell 0 is the low half of byte 0, cell 1 the high half
+    REQUIRE( (packed[0] & 0x0f) == 1 );
+    REQUIRE( (packed[0] >> 4) == 0 );
+    REQUIRE( (packed[40] >> 4) == 0 );
+
+    Board B;
+    REQUIRE( B.readPacked(packed) == true );
+    REQUIRE( B == A );
+
+    // values above 9 are rejected
+    packed[3] = 0xf0;
+    REQUIRE( B.readPacked(packed) == false );
+    REQUIRE( B == A );
+}
+
+TEST_CASE("Packed corpus is written and read back", "[packed]")
+{
+    char path[] = "/tmp/packedCorpusXXXXXX";
+    close(mkstemp(path));
+
+    std::vector<Board> boards;
+    for(int n = 0; n < 5; n++)
+    {
+        Board b;
+        b.setCell(n, n, n + 1);
+        boards.push_back(b);
+    }
+
+    for(int ids = 0; ids < 2; ids++)
+    {
+        PackedWriter writer;
+        REQUIRE( writer.open(path, ids == 1) == true );
+
+        for(int n = 0; n < 5; n++)
+            writer.write(boards[n], n + 10, 1000 + n);
+
+        REQUIRE( writer.close() == true );
+
+        // header, records, and footer, with or without the 8 byte ids
+        struct stat st;
+        stat(path, &st);
+        REQUIRE( st.st_size == 16 + 5 * (42 + ids * 8) + 24 );
+
+        PackedReader reader;
+        REQUIRE( PackedReader::isPacked(path) == true );
+        REQUIRE( reader.open(path) == true );
+        REQUIRE( reader.size() == 5 );
+        REQUIRE( reader.hasIds() == (ids == 1) );
+
+        // records are read in any order
+        for(int n = 4; n >= 0; n--)
+        {
+            Board b;
+            unsigned char status;
+            unsigned long long id;
+
+            REQUIRE( reader.read(n, b, &status, &id) == true );
+            REQUIRE( b == boards[n] );
+            REQUIRE( status == n + 10 );
+            REQUIRE( id == (ids == 1 ? 1000ULL + n : 0ULL) );
+        }
+
+        Board b;
+        REQUIRE( reader.read(5, b) == false );
+    }
+
+    // a truncated file is not accepted
+    REQUIRE( truncate(path, 16 + 42) == 0 );
+    PackedReader reader;
+    REQUIRE( reader.open(path) == false );
+
+    std::remove(path);
+    REQUIRE( PackedReader::isPacked("test/easyPuzzleLine.txt") == false );
+
+    // pipes are not looked into, so nothing is taken from them
+    int fds[2];
+    REQUIRE( pipe(fds) == 0 );
+    REQUIRE( write(fds[1], "SDKPACK1", 8) == 8 );
+    close(fds[1]);
+
+    std::string pipePath = "/dev/fd/" + std::to_string(fds[0]);
+    REQUIRE( PackedReader::isPacked(pipePath.c_str()) == false );
+
+    char magic[9] = {0};
+    REQUIRE( read(fds[0], magic, 8) == 8 );
+    REQUIRE( std::string(magic) == "SDKPACK1" );
+    close(fds[0]);
+}
@@ -0,0 +1,137 @@
+#include "catch.hpp"    // CATCH testing framework
+#include "../src/PuzzleGenerator.h"
+#include "testHelpers.h"
+#include <string>
+#include <unistd.h>
+
+TEST_CASE("Generated puzzles have one solution and no spare clues",
+          "[generator]")
+{
+    PuzzleGenerator generator;
+    Board puzzle;
+    Board solution;
+    SolveStats stats;
+    SudokuSolver check;
+
+    for(unsigned long long index = 0; index < 3; index++)
+    {
+        generator.generate(index, puzzle, solution, stats);
+
+        REQUIRE( solution.isFull() == true );
+        REQUIRE( solution.hasDuplicates() == false );
+        REQUIRE( stats.status == SOLVED );
+
+        check.board = puzzle;
+        REQUIRE( check.countSolutions(2) == 1 );
+        REQUIRE( check.board == solution );
+
+        // taking away any clue left gives another solution
+        int cells[81];
+        puzzle.saveCells(cells);
+
+        for(int cell = 0; cell < 81; cell++)
+        {
+            if(cells[cell] == -1)
+                continue;
+
+            int val = cells[cell];
+            cells[cell] = -1;
+            check.board.loadCells(cells);
+            REQUIRE( check.countSolutions(2) == 2 );
+            cells[cell] = val;
+        }
+    }
+}
+
+TEST_CASE("Generated puzzles depend only on the seed and position",
+          "[generator]")
+{
+    PuzzleGenerator generator;
+    Board first;
+    Board again;
+    Board solution;
+    SolveStats stats;
+
+    generator.generate(7, first, solution, stats);
+    generator.generate(7, again, solution, stats);
+    REQUIRE( first == again );
+
+    generator.generate(8, again, solution, stats);
+    REQUIRE( !(first == again) );
+
+    generator.seed = 2;
+    generator.generate(7, again, solution, stats);
+    REQUIRE( !(first == again) );
+
+    // the same puzzles come out whatever the number of threads
+    int one = tempFile();
+    int three = tempFile();
+    {
+        OutputBuffer out(one);
+        generator.threads = 1;
+        REQUIRE( generator.run(10, out) );
+        REQUIRE( generator.count == 10 );
+    }
+    {
+        OutputBuffer out(three);
+        generator.threads = 3;
+        REQUIRE( generator.run(10, out) );
+        REQUIRE( generator.count == 10 );
+        REQUIRE( generator.clues > 10 * 17 );
+    }
+
+    std::string text = slurp(one);
+    REQUIRE( text == slurp(three) );
+    REQUIRE( text.size() == 10 * 82 );
+
+    close(one);
+    close(three);
+}
+
+TEST_CASE("Generated puzzles are written in the batch formats",
+          "[generator]")
+{
+    PuzzleGenerator generator;
+    generator.threads = 2;
+
+    Board puzzle;
+    Board solution;
+    SolveStats stats;
+    generator.generate(0, puzzle, solution, stats);
+
+    char p[81];
+    char s[81];
+    puzzle.writeLine(p);
+    solution.writeLine(s);
+
+    int fd = tempFile();
+    OutputBuffer out(fd);
+
+    SECTION("Lines hold the puzzle")
+    {
+        generator.run(2, out);
+        REQUIRE( slurp(fd).substr(0, 82) == std::string(p, 81) + "\n" );
+    }
+
+    SECTION("Lines hold the puzzle and its solution when asked")
+    {
+        out.content = OutputBuffer::PUZZLE_SOLUTION;
+        generator.run(1, out);
+        REQUIRE( slurp(fd) ==
+                 std::string(p, 81) + "," + std::string(s, 81) + "\n" );
+    }
+
+    SECTION("JSON records hold both, numbered from 1")
+    {
+        out.layout = OutputBuffer::JSONL;
+        generator.run(2, out);
+
+        std::string text = slurp(fd);
+        REQUIRE( text.find("{\"id\":1,\"input\":\"" + std::string(p, 81) +
+                           "\",\"solution\":\"" + std::string(s, 81) +
+                           "\",\"status\":\"solved\"") == 0 );
+        REQUIRE( text.find("{\"id\":2,") != std::string::npos );
+    }
+
+    close(fd);
+}
@@ -0,0 +1,168 @@
+#include "catch.hpp"    // CATCH testing framework
+#include "../src/PuzzleReader.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+/**
+ * Collect every record handed out by a reader
+ */
+static std::vector<std::string> readAll(PuzzleReader& reader)
+{
+    std::vector<std::string> records;
+    const char* rec;
+    int len;
+
+    while(reader.next(rec, len))
+        records.push_back(std::string(rec, len));
+
+    return records;
+}
+
+TEST_CASE("Regular files are mapped", "[reader]")
+{
+    char path[] = "/tmp/puzzleReaderXXXXXX";
+    int fd = mkstemp(path);
+    std::string text = "first\nsecond\n\nlast";
+    REQUIRE( write(fd, text.data(), text.size()) == (ssize_t)text.size() );
+    close(fd);
+
+    PuzzleReader reader;
+    REQUIRE( reader.open(path) == true );
+    REQUIRE( reader.isMapped() == true );
+
+    std::vector<std::string> records = readAll(reader);
+    REQUIRE( records.size() == 4 );
+    REQUIRE( records[0] == "first" );
+    REQUIRE( records[1] == "second" );
+    REQUIRE( records[2] == "" );
+    REQUIRE( records[3] == "last" );
+
+    reader.close();
+    std::remove(path);
+
+    REQUIRE( reader.open("/tmp/does/not/exist") == false );
+}
+
+TEST_CASE("Pipes are read through the buffer", "[reader]")
+{
+    int fds[2];
+    REQUIRE( pipe(fds) == 0 );
+
+    // the second line is longer than the buffer and comes back cut short
+    std::string text = "abc\n0123456789abcdef\nxyz\nend";
+    REQUIRE( write(fds[1], text.data(), text.size()) == (ssize_t)text.size() );
+    close(fds[1]);
+
+    PuzzleReader reader(8);
+    REQUIRE( reader.openFd(fds[0]) == true );
+    REQUIRE( reader.isMapped() == false );
+
+    std::vector<std::string> records = readAll(reader);
+    REQUIRE( records.size() == 4 );
+    REQUIRE( records[0] == "abc" );
+    REQUIRE( records[1] == "01234567" );
+    REQUIRE( records[2] == "xyz" );
+    REQUIRE( records[3] == "end" );
+
+    close(fds[0]);
+
+    SECTION("Standard input is read through the buffer when reading ahead")
+    {
+        REQUIRE( pipe(fds) == 0 );
+        REQUIRE( write(fds[1], "abc\nxyz", 7) == 7 );
+        close(fds[1]);
+
+        int saved = dup(0);
+        dup2(fds[0], 0);
+        close(fds[0]);
+
+        PuzzleReader stdinReader;
+        REQUIRE( stdinReader.openAsync("-") == true );
+        REQUIRE( stdinReader.isAsync() == false );
+
+        records = readAll(stdinReader);
+        stdinReader.close();
+        dup2(saved, 0);
+        close(saved);
+
+        REQUIRE( records.size() == 2 );
+        REQUIRE( records[0] == "abc" );
+        REQUIRE( records[1] == "xyz" );
+    }
+}
+
+TEST_CASE("Files are read ahead in chunks", "[reader]")
+{
+    char path[] = "/tmp/puzzleReaderXXXXXX";
+    int fd = mkstemp(path);
+
+    // lines of every length so some straddle the 16 byte chunks
+    std::vector<std::string> lines;
+    std::string text;
+    for(int i = 0; i < 60; i++)
+    {
+        std::string line(i % 23, static_cast<char>('a' + i % 26));
+        lines.push_back(line);
+        text += line + "\n";
+    }
+    text += "tail";
+    lines.push_back("tail");
+
+    REQUIRE( write(fd, text.data(), text.size()) == (ssize_t)text.size() );
+    close(fd);
+
+    for(int depth = 1; depth <= 4; depth += 3)
+    {
+        PuzzleReader reader(16);
+        REQUIRE( reader.openAsync(path, depth) == true );
+        REQUIRE( reader.isMapped() == false );
+        REQUIRE( reader.isAsync() == true );
+
+        std::vector<std::string> records = readAll(reader);
+
+        // lines longer than a chunk come back cut short
+        REQUIRE( records.size() == lines.size() );
+        for(size_t i = 0; i < lines.size(); i++)
+            REQUIRE( records[i] == lines[i].substr(0, 16) );
+    }
+
+    std::remove(path);
+}
+
+TEST_CASE("Records stop where a chunk can not be read", "[reader]")
+{
+    char path[] = "/tmp/puzzleReaderXXXXXX";
+    int fd = mkstemp(path);
+
+    std::string text;
+    for(int i = 0; i < 40; i++)
+        text += "0123456\n";
+
+    REQUIRE( write(fd, text.data(), text.size()) == (ssize_t)text.size() );
+    close(fd);
+
+    // the reader is given the lowest free descriptor, which is then
+    // swapped for a directory so every later read fails
+    int probe = dup(0);
+    close(probe);
+
+    PuzzleReader reader(16);
+    REQUIRE( reader.openAsync(path, 1) == true );
+    REQUIRE( reader.hasFailed() == false );
+
+    int dir = ::open("/tmp", O_RDONLY | O_DIRECTORY);
+    REQUIRE( dup2(dir, probe) == probe );
+    close(dir);
+
+    std::vector<std::string> records = readAll(reader);
+    REQUIRE( records.size() < 40 );
+    for(const std::string& rec: records)
+        REQUIRE( rec == "0123456" );
+    REQUIRE( reader.hasFailed() == true );
+
+    reader.close();
+    std::remove(path);
+}
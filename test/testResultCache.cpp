@@ -0,0 +1,148 @@
+#include "catch.hpp"    // CATCH testing framework
+#include "../src/ResultCache.h"
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Repeated boards are answered from the cache", "[cache]")
+{
+    std::string puzzles[] = {
+        ".7...3..9....89.5.2.9.7.1.3.5..1..249.7.5.8.148..3..7."
+        "6.4.2.3.8.3.89....7..3...4.",
+        "..3.2.6..9..3.5..1..18.64....81.29..7.......8..67.82...."
+        "26.95..8..2.3..9..5.1.3..",
+        "4.....8.5.3..........7......2.....6.....8.4......1......."
+        "6.3.7.5..2.....1.4......"
+    };
+
+    ResultCache cache(1 << 20);
+    REQUIRE(cache.capacity() > 0);
+
+    for(int round = 0; round < 3; round++)
+    {
+        for(int p = 0; p < 3; p++)
+        {
+            Board b;
+            REQUIRE(b.readLine(puzzles[p].data(), puzzles[p].size()));
+
+            SudokuSolver fresh(b);
+            bool solved = fresh.solveDriver();
+
+            SudokuSolver solver(b);
+            REQUIRE(cache.solve(solver) == solved);
+            REQUIRE(solver.board == fresh.board);
+            REQUIRE(solver.stats.status == fresh.stats.status);
+            REQUIRE(solver.stats.placements == fresh.stats.placements);
+            REQUIRE(solver.unsolvable == fresh.unsolvable);
+        }
+    }
+
+    REQUIRE(cache.misses() == 3);
+    REQUIRE(cache.hits() == 6);
+    REQUIRE(cache.size() == 3);
+
+    // the same board with guessing is a different entry
+    Board b;
+    b.readLine(puzzles[1].data(), puzzles[1].size());
+    SudokuSolver solver(b);
+    solver.search = true;
+    REQUIRE(cache.solve(solver));
+    REQUIRE(cache.misses() == 4);
+
+    // budgeted solves are not kept
+    solver.board = b;
+    solver.search = false;
+    solver.budget = 1;
+    cache.solve(solver);
+    REQUIRE(solver.stats.status == BUDGET);
+    REQUIRE(cache.size() == 4);
+}
+
+TEST_CASE("A full cache evicts boards not asked for again", "[cache]")
+{
+    // room for four boards in a single shard
+    ResultCache cache(4 * ResultCache::ENTRY_BYTES, 1);
+    REQUIRE(cache.capacity() == 4);
+
+    std::vector<ResultCache::Key> keys(8);
+    Board solution;
+    SolveStats stats;
+
+    for(int i = 0; i < 8; i++)
+    {
+        Board b;
+        b.setCell(i, 0, i + 1);
+        ResultCache::makeKey(b, false, keys[i]);
+    }
+
+    for(int i = 0; i < 4; i++)
+        cache.insert(keys[i], solution, stats);
+
+    // board 0 is asked for, so the clock passes over it once
+    REQUIRE(cache.find(keys[0], solution, stats));
+
+    for(int i = 4; i < 7; i++)
+        cache.insert(keys[i], solution, stats);
+
+    REQUIRE(cache.size() == 4);
+    REQUIRE(cache.evictions() == 3);
+    REQUIRE(cache.find(keys[0], solution, stats));
+    REQUIRE_FALSE(cache.find(keys[1], solution, stats));
+    REQUIRE_FALSE(cache.find(keys[2], solution, stats));
+    REQUIRE_FALSE(cache.find(keys[3], solution, stats));
+    for(int i = 4; i < 7; i++)
+        REQUIRE(cache.find(keys[i], solution, stats));
+
+    // a cache with no memory keeps nothing
+    ResultCache none(0);
+    none.insert(keys[7], solution, stats);
+    REQUIRE(none.size() == 0);
+    REQUIRE_FALSE(none.find(keys[7], solution, stats));
+}
+
+TEST_CASE("The cache can be shared between threads", "[cache]")
+{
+    std::string line = ".7...3..9....89.5.2.9.7.1.3.5..1..249.7.5.8.148..3..7."
+                       "6.4.2.3.8.3.89....7..3...4.";
+    Board b;
+    b.readLine(line.data(), line.size());
+
+    SudokuSolver fresh(b);
+    fresh.solveDriver();
+
+    // little enough room that boards are evicted while others read
+    ResultCache cache(8 * ResultCache::ENTRY_BYTES, 4);
+    std::vector<std::thread> workers;
+    std::vector<int> wrong(4, 0);
+
+    for(int t = 0; t < 4; t++)
+    {
+        workers.push_back(std::thread([&, t]()
+        {
+            SudokuSolver solver;
+
+            for(int i = 0; i < 200; i++)
+            {
+                solver.board = b;
+                solver.board.setCell(0, 0, (i + t) % 2 ? 8 : -1);
+                solver.solveDriver();
+                Board expect = solver.board;
+
+                solver.board = b;
+                solver.board.setCell(0, 0, (i + t) % 2 ? 8 : -1);
+                cache.solve(solver);
+
+                if(!(solver.board == expect))
+                    wrong[t]++;
+            }
+        }));
+    }
+
+    for(size_t t = 0; t < workers.size(); t++)
+        workers[t].join();
+
+    for(int t = 0; t < 4; t++)
+        REQUIRE(wrong[t] == 0);
+    REQUIRE(cache.hits() + cache.misses() == 800);
+    REQUIRE(fresh.stats.status == SOLVED);
+}
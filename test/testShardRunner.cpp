@@ -0,0 +1,206 @@
+#include "catch.hpp"    // CATCH testing framework
+#include "../src/ShardRunner.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Read a whole file
+ */
+static std::string slurp(const char* path)
+{
+    std::ifstream in(path);
+    std::stringstream text;
+    text << in.rdbuf();
+
+    return text.str();
+}
+
+/**
+ * Drop the last field of every line
+ */
+static std::string dropTimes(const std::string& text)
+{
+    std::istringstream in(text);
+    std::string line;
+    std::string kept;
+
+    while(std::getline(in, line))
+        kept += line.substr(0, line.rfind(',')) + "\n";
+
+    return kept;
+}
+
+TEST_CASE("Sharded runs match a run in one process", "[shards]")
+{
+    char input[] = "/tmp/shardInputXXXXXX";
+    char expected[] = "/tmp/shardExpectedXXXXXX";
+    char joined[] = "/tmp/shardJoinedXXXXXX";
+    close(mkstemp(input));
+    close(mkstemp(expected));
+    close(mkstemp(joined));
+
+    std::string puzzles[] = {
+        ".7...3..9....89.5.2.9.7.1.3.5..1..249.7.5.8.148..3..7."
+        "6.4.2.3.8.3.89....7..3...4.",
+        "..3.2.6..9..3.5..1..18.64....81.29..7.......8..67.82...."
+        "26.95..8..2.3..9..5.1.3..",
+        "# a comment",
+        "not a puzzle"
+    };
+
+    {
+        std::ofstream out(input);
+        for(int i = 0; i < 50; i++)
+            out << puzzles[i % 4] << "\n";
+    }
+
+    // lines, CSV, and lines with the shards read and written through
+    // io_uring
+    for(int mode = 0; mode < 3; mode++)
+    {
+        bool csv = mode == 1;
+        BatchRunner single;
+        int fd = open(expected, O_WRONLY | O_TRUNC);
+        {
+            OutputBuffer out(fd);
+            out.layout = csv ? OutputBuffer::CSV : OutputBuffer::LINE;
+            std::ifstream in(input);
+            single.run(in, out);
+        }
+        close(fd);
+
+        BatchRunner runner;
+        ShardRunner sharded;
+        sharded.shards = 3;
+        sharded.uring = mode == 2;
+        fd = open(joined, O_WRONLY | O_TRUNC);
+        {
+            OutputBuffer out(fd);
+            out.layout = csv ? OutputBuffer::CSV : OutputBuffer::LINE;
+            REQUIRE( sharded.run(input, runner, out) == true );
+        }
+        close(fd);
+
+        std::string a = slurp(expected);
+        std::string b = slurp(joined);
+
+        // the times differ, so compare CSV records up to them
+        if(csv)
+        {
+            a = dropTimes(a);
+            b = dropTimes(b);
+        }
+
+        REQUIRE( a == b );
+
+        // the shard directory is gone once the shards are joined
+        struct stat st;
+        REQUIRE( stat((std::string(input) + ".shards").c_str(), &st) != 0 );
+
+        std::ostringstream summary;
+        sharded.summary(summary);
+        REQUIRE( summary.str().find("26 puzzles, 26 solved, 0 unsolved, "
+                                    "12 malformed") == 0 );
+    }
+
+    std::remove(input);
+    std::remove(expected);
+    std::remove(joined);
+}
+
+TEST_CASE("Resumed runs keep the shards already done", "[shards]")
+{
+    char input[] = "/tmp/shardInputXXXXXX";
+    close(mkstemp(input));
+
+    std::string line = ".7...3..9....89.5.2.9.7.1.3.5..1..249.7.5.8.148..3..7."
+                       "6.4.2.3.8.3.89....7..3...4.";
+    {
+        std::ofstream out(input);
+        for(int i = 0; i < 10; i++)
+            out << line << "\n";
+    }
+
+    std::string dir = std::string(input) + ".shards";
+    int devNull = open("/dev/null", O_WRONLY);
+
+    // a first run planned two shards and finished the first
+    BatchRunner runner;
+    ShardRunner first;
+    first.shards = 2;
+    first.dir = dir;
+    {
+        OutputBuffer out(devNull);
+        REQUIRE( first.run(input, runner, out) == true );
+    }
+
+    mkdir(dir.c_str(), 0755);
+    {
+        struct stat st;
+        stat(input, &st);
+
+        std::ofstream plan((dir + "/plan").c_str());
+        plan << "input " << input << "\n"
+             << "bytes " << st.st_size << "\n"
+             << "modified " << st.st_mtime << "\n"
+             << "records 10\n"
+             << "shards 2\n"
+             << "layout 0 0\n";
+
+        std::ofstream out((dir + "/shard-0.out").c_str());
+        out << "from the first run\n";
+
+        std::ofstream done((dir + "/shard-0.done").c_str());
+        done << "5 5 0 0.5\n";
+    }
+
+    char joined[] = "/tmp/shardJoinedXXXXXX";
+    int fd = mkstemp(joined);
+
+    ShardRunner again;
+    again.shards = 2;
+    again.resume = true;
+    again.dir = dir;
+    {
+        OutputBuffer out(fd);
+        REQUIRE( again.run(input, runner, out) == true );
+    }
+    close(fd);
+
+    std::string text = slurp(joined);
+    REQUIRE( text.find("from the first run\n") == 0 );
+    REQUIRE( std::count(text.begin(), text.end(), '\n') == 6 );
+
+    std::ostringstream summary;
+    again.summary(summary);
+    REQUIRE( summary.str().find("shard 0: 5 puzzles (resumed)") !=
+             std::string::npos );
+
+    // a plan for other shards is not resumed
+    mkdir(dir.c_str(), 0755);
+    {
+        std::ofstream plan((dir + "/plan").c_str());
+        plan << "something else\n";
+    }
+
+    ShardRunner other;
+    other.shards = 2;
+    other.resume = true;
+    other.dir = dir;
+    {
+        OutputBuffer out(devNull);
+        REQUIRE( other.run(input, runner, out) == false );
+    }
+
+    std::remove((dir + "/plan").c_str());
+    rmdir(dir.c_str());
+    close(devNull);
+    std::remove(input);
+    std::remove(joined);
+}
@@ -0,0 +1,182 @@
+#include "catch.hpp"    // CATCH testing framework
+#include "../src/SharedRing.h"
+#include "../src/SolverDaemon.h"
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+TEST_CASE("Rings pass slots in order across wraparound", "[ring]")
+{
+    std::string path = "/tmp/sharedRing" + std::to_string(getpid());
+
+    SharedChannel server;
+    REQUIRE( server.create(path.c_str(), 20) == true );
+    REQUIRE( server.requests.size() == 32 );
+    REQUIRE( server.results.size() == 32 );
+
+    SharedChannel client;
+    REQUIRE( client.open(path.c_str()) == true );
+
+    // one client at a time
+    SharedChannel other;
+    REQUIRE( other.open(path.c_str(), 0) == false );
+
+    const unsigned long long count = 10000;
+
+    std::thread producer([&]()
+    {
+        for(unsigned long long i = 0; i < count; )
+        {
+            // fill what room there is, then wait for more
+            size_t n = 0;
+            RingRequest* r;
+
+            while(i + n < count &&
+                  (r = static_cast<RingRequest*>(client.requests.claim(n))))
+            {
+                r->id = i + n;
+                n++;
+            }
+
+            client.requests.publish(n);
+            i += n;
+
+            if(i < count)
+                client.requests.waitRoom(false, 1000);
+        }
+    });
+
+    unsigned long long next = 0;
+    bool ordered = true;
+
+    while(next < count && server.requests.waitData(false, 1000))
+    {
+        size_t n = server.requests.available();
+
+        for(size_t i = 0; i < n; i++)
+            ordered = ordered &&
+                static_cast<RingRequest*>(server.requests.at(i))->id ==
+                next + i;
+
+        server.requests.release(n);
+        next += n;
+    }
+
+    producer.join();
+
+    REQUIRE( next == count );
+    REQUIRE( ordered == true );
+    REQUIRE( server.requests.available() == 0 );
+    REQUIRE( server.requests.waitData(true, 10) == false );
+
+    client.close();
+    server.close();
+    REQUIRE( access(path.c_str(), F_OK) != 0 );
+}
+
+TEST_CASE("Only channel files are opened", "[ring]")
+{
+    std::string path = "/tmp/sharedRing" + std::to_string(getpid());
+
+    {
+        std::ofstream junk(path.c_str());
+        junk << std::string(8192, 'x');
+    }
+
+    SharedChannel client;
+    REQUIRE( client.open(path.c_str()) == false );
+    REQUIRE( client.open("/nonexistent/ring") == false );
+
+    unlink(path.c_str());
+}
+
+TEST_CASE("The daemon solves requests from its ring", "[ring]")
+{
+    std::string sock = "/tmp/solverDaemon" + std::to_string(getpid());
+    std::string path = "/tmp/sharedRing" + std::to_string(getpid());
+
+    SolverDaemon daemon;
+    daemon.threads = 2;
+    REQUIRE( daemon.listen(sock.c_str()) == true );
+    REQUIRE( daemon.listenRing(path.c_str(), 16) == true );
+
+    std::thread server([&]() { daemon.serve(); });
+
+    std::string puzzles[] = {
+        ".7...3..9....89.5.2.9.7.1.3.5..1..249.7.5.8.148..3..7."
+        "6.4.2.3.8.3.89....7..3...4.",
+        "4.....8.5.3..........7......2.....6.....8.4......1......."
+        "6.3.7.5..2.....1.4......"
+    };
+
+    Board boards[2];
+    SudokuSolver fresh[2];
+    for(int i = 0; i < 2; i++)
+    {
+        boards[i].readLine(puzzles[i].data(), 81);
+        fresh[i].board = boards[i];
+        fresh[i].search = true;
+        fresh[i].solveDriver();
+    }
+
+    SharedChannel client;
+    REQUIRE( client.open(path.c_str()) == true );
+
+    // a full ring of guessing requests, then one that cannot be read
+    for(size_t i = 0; i < 15; i++)
+    {
+        RingRequest* r = static_cast<RingRequest*>(client.requests.claim(i));
+        REQUIRE( r != nullptr );
+
+        r->id = 100 + i;
+        r->flags = FLAG_SEARCH;
+        r->budget = 0;
+        boards[i % 2].writePacked(r->board);
+    }
+
+    RingRequest* bad = static_cast<RingRequest*>(client.requests.claim(15));
+    REQUIRE( bad != nullptr );
+    REQUIRE( client.requests.claim(16) == nullptr );
+
+    bad->id = 115;
+    bad->flags = 0;
+    bad->budget = 0;
+    std::memset(bad->board, 0xff, Board::PACKED_SIZE);
+    client.requests.publish(16);
+
+    size_t received = 0;
+
+    while(received < 16 && client.results.waitData(false, 5000))
+    {
+        const RingResult* r = static_cast<RingResult*>(client.results.at(0));
+        REQUIRE( r->id == 100 + received );
+
+        if(received < 15)
+        {
+            Board solution;
+            REQUIRE( solution.readPacked(r->solution) == true );
+            REQUIRE( solution == fresh[received % 2].board );
+            REQUIRE( r->status == fresh[received % 2].stats.status );
+            REQUIRE( r->searchNodes == fresh[received % 2].stats.searchNodes );
+        }
+        else
+            REQUIRE( r->status == MALFORMED );
+
+        client.results.release(1);
+        received++;
+    }
+
+    REQUIRE( received == 16 );
+
+    daemon.stop();
+    server.join();
+
+    REQUIRE( daemon.puzzles == 16 );
+
+    // ring requests are counted like socket ones, and none is left queued
+    REQUIRE( daemon.requests == 16 );
+    REQUIRE( daemon.queued == 0 );
+    REQUIRE( daemon.peakQueued >= 1 );
+}
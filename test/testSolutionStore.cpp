@@ -0,0 +1,155 @@
+#include "catch.hpp"    // CATCH testing framework
+#include "../src/SolutionStore.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+TEST_CASE("Solution stores keep results across opens", "[store]")
+{
+    char path[] = "/tmp/solutionStoreXXXXXX";
+    close(mkstemp(path));
+
+    std::string puzzles[] = {
+        ".7...3..9....89.5.2.9.7.1.3.5..1..249.7.5.8.148..3..7."
+        "6.4.2.3.8.3.89....7..3...4.",
+        "..3.2.6..9..3.5..1..18.64....81.29..7.......8..67.82...."
+        "26.95..8..2.3..9..5.1.3..",
+        "4.....8.5.3..........7......2.....6.....8.4......1......."
+        "6.3.7.5..2.....1.4......"
+    };
+
+    std::vector<Board> boards(3);
+    std::vector<SudokuSolver> fresh(3);
+    for(int p = 0; p < 3; p++)
+    {
+        boards[p].readLine(puzzles[p].data(), puzzles[p].size());
+        fresh[p].board = boards[p];
+        fresh[p].solveDriver();
+    }
+
+    // a missing store cannot be opened, only created
+    std::remove(path);
+    SolutionStore store;
+    REQUIRE( store.open(path) == false );
+    REQUIRE( store.create(path, 100) == true );
+    REQUIRE( store.isWritable() == true );
+    REQUIRE( store.capacity() >= 100 );
+
+    int misses = 0;
+    for(int round = 0; round < 2; round++)
+    {
+        for(int p = 0; p < 3; p++)
+        {
+            SudokuSolver solver(boards[p]);
+            store.solve(solver, [&](SudokuSolver& s) -> bool
+            {
+                misses++;
+                return s.solveDriver();
+            });
+
+            REQUIRE( solver.board == fresh[p].board );
+            REQUIRE( solver.stats.status == fresh[p].stats.status );
+            REQUIRE( solver.stats.placements == fresh[p].stats.placements );
+        }
+    }
+
+    REQUIRE( misses == 3 );
+    REQUIRE( store.size() == 3 );
+
+    // only one writer, but readers see what it adds
+    SolutionStore other;
+    REQUIRE( other.open(path, true) == false );
+    REQUIRE( other.open(path) == true );
+    REQUIRE( other.isWritable() == false );
+
+    ResultCache::Key key;
+    Board solution;
+    SolveStats stats;
+    ResultCache::makeKey(boards[0], true, key);
+    REQUIRE( other.find(key, solution, stats) == false );
+    REQUIRE( other.insert(key, fresh[0].board, fresh[0].stats) == false );
+    REQUIRE( store.insert(key, fresh[0].board, fresh[0].stats) == true );
+    REQUIRE( other.find(key, solution, stats) == true );
+    REQUIRE( solution == fresh[0].board );
+
+    // the results outlive the writer
+    store.close();
+    REQUIRE( other.open(path, true) == true );
+    REQUIRE( other.size() == 4 );
+    ResultCache::makeKey(boards[2], false, key);
+    REQUIRE( other.find(key, solution, stats) == true );
+    REQUIRE( solution == fresh[2].board );
+    REQUIRE( stats.status == fresh[2].stats.status );
+
+    // a full store turns inserts away
+    bool full = false;
+    for(int i = 0; i < 81 && !full; i++)
+    {
+        for(int v = 1; v <= 9 && !full; v++)
+        {
+            Board b;
+            b.setCell(i / 9, i % 9, v);
+            ResultCache::makeKey(b, false, key);
+            full = !other.insert(key, b, stats);
+        }
+    }
+    REQUIRE( full == true );
+    REQUIRE( other.size() == other.capacity() );
+    other.close();
+
+    // files cut short are rejected
+    REQUIRE( truncate(path, 64 + 128) == 0 );
+    REQUIRE( other.open(path) == false );
+
+    std::remove(path);
+}
+
+TEST_CASE("Solution stores can be built from a solved batch", "[store]")
+{
+    char path[] = "/tmp/solutionStoreXXXXXX";
+    close(mkstemp(path));
+
+    std::string line = ".7...3..9....89.5.2.9.7.1.3.5..1..249.7.5.8.148..3..7."
+                       "6.4.2.3.8.3.89....7..3...4.";
+
+    std::vector<Board> boards(200);
+    for(size_t i = 0; i < boards.size(); i++)
+    {
+        std::string copy = line;
+        copy[i % 81] = '.';
+        copy[(i * 7) % 81] = '.';
+        boards[i].readLine(copy.data(), copy.size());
+    }
+
+    BatchOptions opts;
+    opts.threads = 2;
+    std::vector<Result> results(boards.size());
+    solveBatch(boards.data(), boards.size(), results.data(), opts);
+
+    REQUIRE( SolutionStore::build(path, boards.data(), results.data(),
+                                  boards.size(), false) == true );
+
+    SolutionStore store;
+    REQUIRE( store.open(path) == true );
+    REQUIRE( store.size() > 0 );
+    REQUIRE( store.size() <= boards.size() );
+
+    ResultCache::Key key;
+    Board solution;
+    SolveStats stats;
+
+    for(size_t i = 0; i < boards.size(); i++)
+    {
+        ResultCache::makeKey(boards[i], false, key);
+        REQUIRE( store.find(key, solution, stats) == true );
+        REQUIRE( solution == results[i].solution );
+        REQUIRE( stats.status == results[i].stats.status );
+        REQUIRE( stats.rowSingles == results[i].stats.rowSingles );
+
+        ResultCache::makeKey(boards[i], true, key);
+        REQUIRE( store.find(key, solution, stats) == false );
+    }
+
+    std::remove(path);
+}
@@ -0,0 +1,78 @@
+#include "catch.hpp"    // CATCH testing framework
+#include "../src/SolveBatch.h"
+#include <fstream>
+#include <string>
+#include <vector>
+
+TEST_CASE("Batches match solving one board at a time", "[solvebatch]")
+{
+    std::string easy = ".7...3..9....89.5.2.9.7.1.3.5..1..249.7.5.8.148..3..7."
+                       "6.4.2.3.8.3.89....7..3...4.";
+
+    // solvable, stuck, and contradicting boards mixed together
+    std::vector<Board> boards(100);
+    for(size_t i = 0; i < boards.size(); i++)
+    {
+        std::string line = easy;
+        line[i % 81] = '.';
+        boards[i].readLine(line.data(), line.size());
+
+        if(i % 10 == 3)
+            boards[i] = Board();
+        if(i % 10 == 7)
+            boards[i].setCell(0, 0, 7);
+    }
+
+    std::vector<Result> expected(boards.size());
+    for(size_t i = 0; i < boards.size(); i++)
+    {
+        SudokuSolver solver(boards[i]);
+        solver.solveDriver();
+        expected[i].solution = solver.board;
+        expected[i].stats = solver.stats;
+    }
+
+    for(int threads = 0; threads <= 4; threads++)
+    {
+        BatchOptions opts;
+        opts.threads = threads;
+
+        std::vector<Result> results(boards.size());
+        solveBatch(boards.data(), boards.size(), results.data(), opts);
+
+        for(size_t i = 0; i < boards.size(); i++)
+        {
+            REQUIRE( results[i].solution == expected[i].solution );
+            REQUIRE( results[i].stats.status == expected[i].stats.status );
+            REQUIRE( results[i].stats.placements ==
+                     expected[i].stats.placements );
+        }
+    }
+
+    // a single board and an empty batch
+    BatchOptions opts;
+    Result one;
+    solveBatch(boards.data(), 1, &one, opts);
+    REQUIRE( one.solution == expected[0].solution );
+    solveBatch(boards.data(), 0, nullptr, opts);
+}
+
+TEST_CASE("Batches pass the budget on", "[solvebatch]")
+{
+    std::ifstream inf;
+    inf.open("test/easyPuzzle.txt");
+
+    Board puzzle;
+    inf >> puzzle;
+
+    std::vector<Board> boards(40, puzzle);
+    std::vector<Result> results(boards.size());
+
+    BatchOptions opts;
+    opts.threads = 3;
+    opts.budget = 1;
+    solveBatch(boards.data(), boards.size(), results.data(), opts);
+
+    for(Result& r: results)
+        REQUIRE( r.stats.status == BUDGET );
+}
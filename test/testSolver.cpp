@@ -2,7 +2,9 @@
 #include "../src/SudokuSolver.h"
 #include "../src/Board.h"
 #include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <string>
 
 
 
@@ -167,3 +169,210 @@ TEST_CASE("Driver for the solver is called", "[solving]")
 
 }
 
+
+TEST_CASE("Unsolvable boards are detected", "[solving]")
+{
+    // the 2s leave no room for a 2 in the top right block
+    SudokuSolver A;
+    A.board.setCell(1, 1, 2);
+    A.board.setCell(2, 5, 2);
+    A.board.setCell(3, 7, 2);
+    A.board.setCell(4, 6, 2);
+    A.board.setCell(6, 8, 2);
+
+    REQUIRE( A.solveDriver() == false );
+    REQUIRE( A.unsolvable == true );
+
+    // the flag is cleared by the next solve
+    A.board = Board();
+    REQUIRE( A.solveDriver() == false );
+    REQUIRE( A.unsolvable == false );
+}
+
+TEST_CASE("Solve statistics are kept", "[stats]")
+{
+    std::vector<int> testBoard = {4, 2, 3, 6, 9, 7, 8, 1, 5,
+                                  6, 9, 1, 5, 3, 8, 4, 7, 2,
+                                  5, 8, 7, 4, 2, 1, 6, 3, 9,
+                                  3, 1, 9, 8, 7, 5, 2, 6, 4,
+                                  2, 5, 6, 1, 4, 9, 3, 8, 7,
+                                  7, 4, 8, 3, 6, 2, 5, 9, 1,
+                                  9, 6, 4, 2, 1, 3, 7, 5, 8,
+                                  1, 3, 5, 7, 8, 4, 9, 2, 6,
+                                  8, 7, 2, 9, 5, 6, 1, 4, 3};
+    testBoard[6] = -1;
+    testBoard[55] = -1;
+    testBoard[23] = -1;
+
+    SudokuSolver A((Board(testBoard)));
+
+    REQUIRE( A.solveDriver() == true );
+    REQUIRE( A.stats.status == SOLVED );
+    REQUIRE( A.stats.placements == 3 );
+    REQUIRE( A.stats.blockSingles + A.stats.rowSingles +
+             A.stats.colSingles == 3 );
+    REQUIRE( A.stats.searchNodes == 0 );
+    REQUIRE( A.stats.passes >= 1 );
+
+    // an empty board gets stuck right away
+    SudokuSolver B;
+    REQUIRE( B.solveDriver() == false );
+    REQUIRE( B.stats.status == STUCK );
+    REQUIRE( B.stats.placements == 0 );
+
+    // a budget of one pass stops a board that needs more
+    std::ifstream inf;
+    inf.open("test/easyPuzzle.txt");
+    SudokuSolver C;
+    inf >> C;
+    SudokuSolver D(C);
+
+    C.budget = 1;
+    REQUIRE( C.solveDriver() == false );
+    REQUIRE( C.stats.status == BUDGET );
+    REQUIRE( C.stats.passes == 1 );
+
+    REQUIRE( D.solveDriver() == true );
+    REQUIRE( D.stats.passes > 1 );
+
+    REQUIRE( std::string(SolveStats::statusName(CONTRADICTION)) ==
+             "contradiction" );
+}
+
+TEST_CASE("Search finishes boards the cross checks cannot", "[search]")
+{
+    std::string hard = "8..........36......7..9.2...5...7.......457.....1...3..."
+                       "1....68..85...1..9....4..";
+    std::string solved = "812753649943682175675491283154237896369845721287169"
+                         "534521974368438526917796318452";
+
+    SudokuSolver A;
+    REQUIRE( A.board.readLine(hard.data(), hard.size()) == true );
+
+    REQUIRE( A.solveDriver() == false );
+    REQUIRE( A.stats.status == STUCK );
+
+    A.board.readLine(hard.data(), hard.size());
+    A.search = true;
+    REQUIRE( A.solveDriver() == true );
+    REQUIRE( A.stats.status == SOLVED );
+    REQUIRE( A.stats.searchNodes > 0 );
+    REQUIRE( A.stats.placements == 81 - 21 );
+
+    char line[81];
+    A.board.writeLine(line);
+    REQUIRE( std::string(line, 81) == solved );
+
+    // an empty board is filled too
+    SudokuSolver B;
+    B.search = true;
+    REQUIRE( B.solveDriver() == true );
+    REQUIRE( B.board.hasDuplicates() == false );
+
+    // boards without a solution end in a contradiction, left as given
+    std::string none = hard;
+    none[1] = '1';
+    none[2] = '2';
+    none[3] = '3';
+    SudokuSolver C;
+    C.board.readLine(none.data(), none.size());
+    Board given = C.board;
+    C.search = true;
+    REQUIRE( C.solveDriver() == false );
+    REQUIRE( C.stats.status == CONTRADICTION );
+    REQUIRE( C.board.getFilled() >= given.getFilled() );
+
+    none = std::string(81, '.');
+    none[0] = '1';
+    none[1] = '1';
+    C.board.readLine(none.data(), none.size());
+    REQUIRE( C.board.hasDuplicates() == true );
+    REQUIRE( C.solveDriver() == false );
+    REQUIRE( C.stats.status == CONTRADICTION );
+    REQUIRE( C.stats.searchNodes == 0 );
+
+    // the budget covers the passes made while guessing
+    A.board.readLine(hard.data(), hard.size());
+    A.budget = 5;
+    REQUIRE( A.solveDriver() == false );
+    REQUIRE( A.stats.status == BUDGET );
+    REQUIRE( A.stats.passes == 5 );
+
+    // a board the budget stops holds no numbers from guesses
+    for(int budget = 1; budget <= 40; budget++)
+    {
+        A.board.readLine(hard.data(), hard.size());
+        A.budget = budget;
+        A.solveDriver();
+
+        if(A.stats.status != BUDGET)
+            continue;
+
+        A.board.writeLine(line);
+        for(int i = 0; i < 81; i++)
+        {
+            if(line[i] != '.')
+                REQUIRE( line[i] == solved[i] );
+        }
+    }
+}
+
+TEST_CASE("Solutions are counted up to a limit", "[search]")
+{
+    std::string hard = "4.....8.5.3..........7......2.....6.....8.4......1......."
+                       "6.3.7.5..2.....1.4......";
+    std::string solved = "417369825632158947958724316825437169791586432346912"
+                         "758289643571573291684164875293";
+
+    SudokuSolver A;
+    A.board.readLine(hard.data(), hard.size());
+    A.budget = 3;
+    REQUIRE( A.countSolutions(2) == 1 );
+    REQUIRE( A.stats.status == SOLVED );
+    REQUIRE( A.stats.searchNodes > 0 );
+    REQUIRE( A.budget == 3 );
+
+    // the board is left as the solution
+    char line[81];
+    A.board.writeLine(line);
+    REQUIRE( std::string(line, 81) == solved );
+
+    // a full board is its own solution
+    REQUIRE( A.countSolutions(2) == 1 );
+    REQUIRE( A.stats.searchNodes == 0 );
+
+    // an empty board has more than any limit
+    SudokuSolver B;
+    B.board.readLine(std::string(81, '.').data(), 81);
+    REQUIRE( B.countSolutions(2) == 2 );
+    REQUIRE( B.board.isFull() == true );
+    REQUIRE( B.board.hasDuplicates() == false );
+
+    B.board.readLine(std::string(81, '.').data(), 81);
+    REQUIRE( B.countSolutions(50) == 50 );
+
+    // a board with no solution is left as given
+    std::string none = hard;
+    none[1] = '1';
+    none[2] = '2';
+    none[3] = '3';
+    B.board.readLine(none.data(), none.size());
+    Board given = B.board;
+    REQUIRE( B.countSolutions(2) == 0 );
+    REQUIRE( B.stats.status == CONTRADICTION );
+    REQUIRE( B.board == given );
+
+    none = std::string(81, '.');
+    none[0] = '1';
+    none[1] = '1';
+    B.board.readLine(none.data(), none.size());
+    REQUIRE( B.countSolutions(2) == 0 );
+
+    // the two top rows taken out of a solution can be put back either
+    // way round
+    std::string open = solved;
+    for(int i = 0; i < 18; i++)
+        open[i] = '.';
+    B.board.readLine(open.data(), open.size());
+    REQUIRE( B.countSolutions(10) > 1 );
+}
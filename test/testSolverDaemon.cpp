@@ -0,0 +1,286 @@
+#include "catch.hpp"    // CATCH testing framework
+#include "../src/SolverClient.h"
+#include "../src/SolverDaemon.h"
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+TEST_CASE("Requests and responses survive the wire", "[daemon]")
+{
+    std::string line = ".7...3..9....89.5.2.9.7.1.3.5..1..249.7.5.8.148..3..7."
+                       "6.4.2.3.8.3.89....7..3...4.";
+    Board boards[2];
+    boards[0].readLine(line.data(), line.size());
+
+    std::string frame;
+    appendRequest(frame, 7, FLAG_SEARCH, 3, boards, 2, 500);
+    REQUIRE( frame.size() == 4 + 20 + 2 * 81 );
+
+    SolveRequest req;
+    REQUIRE( parseRequest(frame.data() + 4, frame.size() - 4, req) == true );
+    REQUIRE( req.id == 7 );
+    REQUIRE( req.flags == FLAG_SEARCH );
+    REQUIRE( req.budget == 3 );
+    REQUIRE( req.deadline == 500 );
+    REQUIRE( req.boards.size() == 2 );
+    REQUIRE( req.boards[0] == boards[0] );
+    REQUIRE( req.valid[1] == true );
+
+    // a count that does not match the length is rejected
+    REQUIRE( parseRequest(frame.data() + 4, frame.size() - 5, req) == false );
+
+    Result results[2];
+    results[0].solution = boards[0];
+    results[0].stats.status = STUCK;
+    req.valid[1] = false;
+
+    frame.clear();
+    appendResponse(frame, 7, RESPONSE_OK, req, results);
+
+    SolveResponse resp;
+    REQUIRE( parseResponse(frame.data() + 4, frame.size() - 4, resp) ==
+             true );
+    REQUIRE( resp.id == 7 );
+    REQUIRE( resp.status == RESPONSE_OK );
+    REQUIRE( resp.boards[0] == boards[0] );
+    REQUIRE( resp.statuses[0] == STUCK );
+    REQUIRE( resp.statuses[1] == MALFORMED );
+}
+
+TEST_CASE("The daemon answers pipelined requests", "[daemon]")
+{
+    std::string path = "/tmp/solverDaemon" + std::to_string(getpid());
+
+    SolverDaemon daemon;
+    daemon.threads = 2;
+    REQUIRE( daemon.listen(path.c_str()) == true );
+
+    std::thread server([&]() { daemon.serve(); });
+
+    std::string puzzles[] = {
+        ".7...3..9....89.5.2.9.7.1.3.5..1..249.7.5.8.148..3..7."
+        "6.4.2.3.8.3.89....7..3...4.",
+        "..3.2.6..9..3.5..1..18.64....81.29..7.......8..67.82...."
+        "26.95..8..2.3..9..5.1.3..",
+        "4.....8.5.3..........7......2.....6.....8.4......1......."
+        "6.3.7.5..2.....1.4......"
+    };
+
+    std::vector<Board> boards(30);
+    std::vector<SudokuSolver> fresh(30);
+    for(size_t i = 0; i < boards.size(); i++)
+    {
+        boards[i].readLine(puzzles[i % 3].data(), 81);
+        fresh[i].board = boards[i];
+        fresh[i].solveDriver();
+    }
+
+    SolverClient client;
+    REQUIRE( client.connect(path.c_str()) == true );
+
+    // one board per request, then the rest in one request
+    for(unsigned r = 0; r < 10; r++)
+        REQUIRE( client.send(r, 0, 0, &boards[r], 1) == true );
+    REQUIRE( client.send(10, 0, 0, &boards[10], 20) == true );
+
+    std::vector<bool> seen(11, false);
+    SolveResponse resp;
+
+    for(int r = 0; r < 11; r++)
+    {
+        REQUIRE( client.receive(resp) == true );
+        REQUIRE( resp.id <= 10 );
+        REQUIRE( resp.status == RESPONSE_OK );
+        REQUIRE( seen[resp.id] == false );
+        seen[resp.id] = true;
+
+        size_t first = resp.id;
+        REQUIRE( resp.boards.size() == (resp.id == 10 ? 20u : 1u) );
+
+        for(size_t i = 0; i < resp.boards.size(); i++)
+        {
+            REQUIRE( resp.boards[i] == fresh[first + i].board );
+            REQUIRE( resp.statuses[i] == fresh[first + i].stats.status );
+        }
+    }
+
+    // guessing and budgets are passed on
+    REQUIRE( client.send(11, FLAG_SEARCH, 0, &boards[1], 1) == true );
+    REQUIRE( client.receive(resp) == true );
+    REQUIRE( resp.statuses[0] == SOLVED );
+
+    REQUIRE( client.send(12, 0, 1, &boards[0], 1) == true );
+    REQUIRE( client.receive(resp) == true );
+    REQUIRE( resp.statuses[0] == BUDGET );
+
+    // a second client is served alongside the first
+    SolverClient other;
+    REQUIRE( other.connect(path.c_str()) == true );
+    REQUIRE( other.send(1, 0, 0, &boards[0], 1) == true );
+    REQUIRE( other.receive(resp) == true );
+    REQUIRE( resp.boards[0] == fresh[0].board );
+    other.close();
+
+    daemon.stop();
+    server.join();
+
+    // stopping hangs up on the clients still connected
+    REQUIRE( client.receive(resp) == false );
+    REQUIRE( daemon.requests == 14 );
+    REQUIRE( daemon.puzzles == 33 );
+}
+
+TEST_CASE("The daemon coalesces requests into batches", "[daemon]")
+{
+    std::string path = "/tmp/solverDaemon" + std::to_string(getpid());
+
+    SolverDaemon daemon;
+    daemon.threads = 2;
+    daemon.coalesce = true;
+    daemon.batcher.maxWindow = 100000;
+    daemon.batcher.target = 10000000;
+    daemon.batcher.maxBatch = 16;
+    REQUIRE( daemon.listen(path.c_str()) == true );
+
+    std::thread server([&]() { daemon.serve(); });
+
+    std::string line = "..3.2.6..9..3.5..1..18.64....81.29..7.......8..67.82...."
+                       "26.95..8..2.3..9..5.1.3..";
+    std::vector<Board> boards(40);
+    for(size_t i = 0; i < boards.size(); i++)
+        boards[i].readLine(line.data(), line.size());
+
+    SudokuSolver fresh;
+    fresh.board = boards[0];
+    fresh.solveDriver();
+
+    SolverClient client;
+    REQUIRE( client.connect(path.c_str()) == true );
+
+    for(unsigned r = 0; r < 20; r++)
+        REQUIRE( client.send(r, 0, 0, &boards[r], 1) == true );
+    REQUIRE( client.send(20, 0, 0, &boards[20], 20) == true );
+
+    SolveResponse resp;
+    for(int r = 0; r < 21; r++)
+    {
+        REQUIRE( client.receive(resp) == true );
+        REQUIRE( resp.boards.size() == (resp.id == 20 ? 20u : 1u) );
+
+        for(size_t i = 0; i < resp.boards.size(); i++)
+            REQUIRE( resp.boards[i] == fresh.board );
+    }
+
+    daemon.stop();
+    server.join();
+
+    REQUIRE( daemon.requests == 21 );
+    REQUIRE( daemon.batcher.boards == 40 );
+    REQUIRE( daemon.batcher.batches < 21 );
+}
+
+TEST_CASE("A client that stops reading holds up nobody else", "[daemon]")
+{
+    std::string path = "/tmp/solverDaemon" + std::to_string(getpid());
+
+    SolverDaemon daemon;
+    daemon.threads = 2;
+    daemon.coalesce = true;
+    REQUIRE( daemon.listen(path.c_str()) == true );
+
+    std::thread server([&]() { daemon.serve(); });
+
+    std::string line = "..3.2.6..9..3.5..1..18.64....81.29..7.......8..67.82...."
+                       "26.95..8..2.3..9..5.1.3..";
+    std::vector<Board> boards(40);
+    for(size_t i = 0; i < boards.size(); i++)
+        boards[i].readLine(line.data(), line.size());
+
+    // far more responses than the socket holds, none of them read
+    SolverClient stalled;
+    REQUIRE( stalled.connect(path.c_str()) == true );
+    for(unsigned r = 0; r < 400; r++)
+        REQUIRE( stalled.send(r, 0, 0, boards.data(), boards.size()) ==
+                 true );
+
+    SolverClient client;
+    REQUIRE( client.connect(path.c_str()) == true );
+    REQUIRE( client.send(1, 0, 0, boards.data(), 1) == true );
+
+    SolveResponse resp;
+    REQUIRE( client.receive(resp) == true );
+    REQUIRE( resp.id == 1 );
+    REQUIRE( resp.status == RESPONSE_OK );
+
+    stalled.close();
+    client.close();
+    daemon.stop();
+    server.join();
+
+    REQUIRE( daemon.requests == 401 );
+}
+
+TEST_CASE("The daemon sheds load and keeps deadlines", "[daemon]")
+{
+    std::string path = "/tmp/solverDaemon" + std::to_string(getpid());
+
+    // requests wait in the batcher long enough for the next to find the
+    // queue full
+    SolverDaemon daemon;
+    daemon.threads = 2;
+    daemon.coalesce = true;
+    daemon.batcher.maxWindow = 100000;
+    daemon.batcher.target = 10000000;
+    daemon.maxQueue = 10;
+    REQUIRE( daemon.listen(path.c_str()) == true );
+
+    std::thread server([&]() { daemon.serve(); });
+
+    std::string line = "4.....8.5.3..........7......2.....6.....8.4......1......."
+                       "6.3.7.5..2.....1.4......";
+    std::vector<Board> boards(20);
+    for(size_t i = 0; i < boards.size(); i++)
+        boards[i].readLine(line.data(), line.size());
+
+    SolverClient client;
+    REQUIRE( client.connect(path.c_str()) == true );
+
+    // an empty queue takes a request larger than the limit
+    REQUIRE( client.send(1, 0, 0, &boards[0], 20) == true );
+    REQUIRE( client.send(2, 0, 0, &boards[0], 1) == true );
+
+    SolveResponse resp;
+    REQUIRE( client.receive(resp) == true );
+    REQUIRE( resp.id == 2 );
+    REQUIRE( resp.status == RESPONSE_BUSY );
+    REQUIRE( resp.boards.size() == 0 );
+
+    REQUIRE( client.receive(resp) == true );
+    REQUIRE( resp.id == 1 );
+    REQUIRE( resp.status == RESPONSE_OK );
+    REQUIRE( resp.boards.size() == 20 );
+
+    // a deadline that has passed leaves a single pass, a generous one
+    // lets guessing finish
+    REQUIRE( client.send(3, FLAG_SEARCH, 0, &boards[0], 1, 1) == true );
+    REQUIRE( client.receive(resp) == true );
+    REQUIRE( resp.id == 3 );
+    REQUIRE( resp.statuses[0] == BUDGET );
+
+    REQUIRE( client.send(4, FLAG_SEARCH, 0, &boards[0], 1, 10000000) ==
+             true );
+    REQUIRE( client.receive(resp) == true );
+    REQUIRE( resp.id == 4 );
+    REQUIRE( resp.statuses[0] == SOLVED );
+
+    daemon.stop();
+    server.join();
+
+    REQUIRE( daemon.requests == 3 );
+    REQUIRE( daemon.busy == 1 );
+    REQUIRE( daemon.late >= 1 );
+    REQUIRE( daemon.queued == 0 );
+    REQUIRE( daemon.peakQueued == 20 );
+    REQUIRE( daemon.maxWaitNanos > 0 );
+}
@@ -0,0 +1,159 @@
+#include "catch.hpp"    // CATCH testing framework
+#include "../src/SudokuApi.h"
+#include "testHelpers.h"
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static const char* EASY =
+    "..3.2.6..9..3.5..1..18.64....81.29..7.......8..67.82...."
+    "26.95..8..2.3..9..5.1.3..";
+
+TEST_CASE("Boards are parsed and formatted through the C interface", "[api]")
+{
+    REQUIRE(sudoku_abi_version() == SUDOKU_ABI_VERSION);
+
+    sudoku_board b;
+    REQUIRE(sudoku_parse(HARD, std::strlen(HARD), &b) == 0);
+    REQUIRE(b.cells[0] == 4);
+    REQUIRE(b.cells[1] == 0);
+
+    char text[81];
+    sudoku_format(&b, text);
+    REQUIRE(std::string(text, 81) == HARD);
+
+    // trailing whitespace is ignored, short lines and odd characters are not
+    std::string line = std::string(HARD) + "\r\n";
+    REQUIRE(sudoku_parse(line.data(), line.size(), &b) == 0);
+    REQUIRE(sudoku_parse(HARD, 80, &b) == SUDOKU_MALFORMED);
+
+    std::string bad = HARD;
+    bad[3] = 'x';
+    REQUIRE(sudoku_parse(bad.data(), bad.size(), &b) == SUDOKU_MALFORMED);
+}
+
+TEST_CASE("Boards are solved in place through the C interface", "[api]")
+{
+    sudoku_solver* solver = sudoku_new();
+    REQUIRE(solver != nullptr);
+
+    sudoku_board b;
+    sudoku_stats stats;
+    char text[81];
+
+    SECTION("Without search a hard board gets stuck")
+    {
+        sudoku_parse(HARD, 81, &b);
+        REQUIRE(sudoku_solve(solver, &b, 0, 0, &stats) == SUDOKU_STUCK);
+        REQUIRE(stats.status == SUDOKU_STUCK);
+        REQUIRE(stats.search_nodes == 0);
+    }
+
+    SECTION("With search a hard board is solved")
+    {
+        sudoku_parse(HARD, 81, &b);
+        REQUIRE(sudoku_solve(solver, &b, SUDOKU_SEARCH, 0, &stats) ==
+                SUDOKU_SOLVED);
+        REQUIRE(stats.search_nodes > 0);
+        REQUIRE(stats.reserved == 0);
+
+        sudoku_format(&b, text);
+        REQUIRE(std::string(text, 81) == HARD_SOLVED);
+    }
+
+    SECTION("Counts may be left out")
+    {
+        sudoku_parse(EASY, 81, &b);
+        REQUIRE(sudoku_solve(solver, &b, 0, 0, nullptr) == SUDOKU_SOLVED);
+    }
+
+    SECTION("A cell above 9 is malformed")
+    {
+        sudoku_parse(EASY, 81, &b);
+        b.cells[5] = 10;
+        REQUIRE(sudoku_solve(solver, &b, 0, 0, &stats) == SUDOKU_MALFORMED);
+        REQUIRE(stats.status == SUDOKU_MALFORMED);
+    }
+
+    sudoku_free(solver);
+    sudoku_free(nullptr);
+}
+
+TEST_CASE("Batches are solved in place through the C interface", "[api]")
+{
+    sudoku_solver* solver = sudoku_new();
+
+    // enough boards for the lockstep solver, and one it cannot read
+    std::vector<sudoku_board> boards(40);
+    for(size_t i = 0; i < boards.size(); i++)
+        sudoku_parse(i % 2 == 0 ? HARD : EASY, 81, &boards[i]);
+    boards[7].cells[0] = 12;
+
+    std::vector<sudoku_stats> stats(boards.size());
+    long long solved = sudoku_solve_batch(solver, boards.data(),
+                                          boards.size(), SUDOKU_SEARCH, 0, 2,
+                                          stats.data());
+    REQUIRE(solved == static_cast<long long>(boards.size()) - 1);
+
+    char text[81];
+    for(size_t i = 0; i < boards.size(); i++)
+    {
+        if(i == 7)
+        {
+            REQUIRE(stats[i].status == SUDOKU_MALFORMED);
+            continue;
+        }
+
+        REQUIRE(stats[i].status == SUDOKU_SOLVED);
+        sudoku_format(&boards[i], text);
+        REQUIRE(std::string(text, 81).find('.') == std::string::npos);
+        if(i % 2 == 0)
+            REQUIRE(std::string(text, 81) == HARD_SOLVED);
+    }
+
+    // a smaller batch reuses the memory of the first, without counts
+    sudoku_parse(HARD, 81, &boards[0]);
+    REQUIRE(sudoku_solve_batch(solver, boards.data(), 1, 0, 0, 1, nullptr) ==
+            0);
+    REQUIRE(sudoku_solve_batch(solver, boards.data(), 0, 0, 0, 1, nullptr) ==
+            0);
+
+    // a batch too large to make room for fails without touching anything
+    sudoku_parse(HARD, 81, &boards[0]);
+    stats[0].status = SUDOKU_BUDGET;
+    REQUIRE(sudoku_solve_batch(solver, boards.data(), SIZE_MAX / 4, 0, 0, 1,
+                               stats.data()) == SUDOKU_ERROR);
+    REQUIRE(stats[0].status == SUDOKU_BUDGET);
+
+    sudoku_format(&boards[0], text);
+    REQUIRE(std::string(text, 81) == HARD);
+    REQUIRE(sudoku_solve_batch(solver, boards.data(), 1, SUDOKU_SEARCH, 0, 1,
+                               nullptr) == 1);
+
+    sudoku_free(solver);
+}
+
+TEST_CASE("Solutions are counted through the C interface", "[api]")
+{
+    sudoku_solver* solver = sudoku_new();
+    sudoku_board b;
+    sudoku_board first;
+    char text[81];
+
+    sudoku_parse(HARD, 81, &b);
+    REQUIRE(sudoku_count_solutions(solver, &b, 2, &first) == 1);
+    sudoku_format(&first, text);
+    REQUIRE(std::string(text, 81) == HARD_SOLVED);
+
+    // with two givens gone there is more than one solution
+    b.cells[0] = 0;
+    b.cells[6] = 0;
+    REQUIRE(sudoku_count_solutions(solver, &b, 2, nullptr) == 2);
+
+    b.cells[0] = 11;
+    REQUIRE(sudoku_count_solutions(solver, &b, 2, nullptr) ==
+            SUDOKU_MALFORMED);
+
+    sudoku_free(solver);
+}
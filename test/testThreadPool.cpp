@@ -0,0 +1,146 @@
+#include "catch.hpp"    // CATCH testing framework
+#include "../src/ThreadPool.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TEST_CASE("parallelFor covers every index once", "[threadpool]")
+{
+    ThreadPool pool(3);
+    std::vector<std::atomic<int>> hits(10007);
+
+    for(std::atomic<int>& h: hits)
+        h = 0;
+
+    pool.parallelFor(0, hits.size(), 13, [&](size_t start, size_t end)
+    {
+        REQUIRE( end - start <= 13 );
+
+        for(size_t i = start; i < end; i++)
+            hits[i]++;
+    }, 4);
+
+    bool once = true;
+    for(std::atomic<int>& h: hits)
+        once = once && (h == 1);
+
+    REQUIRE( once );
+    REQUIRE( pool.size() == 3 );
+
+    // empty ranges do nothing
+    pool.parallelFor(5, 5, 1, [&](size_t, size_t) { hits[0]++; });
+    REQUIRE( hits[0] == 1 );
+}
+
+TEST_CASE("Groups wait for nested tasks", "[threadpool]")
+{
+    ThreadPool pool(2);
+    pool.pinWorkers();
+
+    std::atomic<int> leaves(0);
+    ThreadPool::Group outer(pool);
+
+    // enough tasks from inside a worker to outgrow its deque
+    for(int i = 0; i < 8; i++)
+    {
+        outer.run([&]()
+        {
+            ThreadPool::Group inner(pool);
+
+            for(int j = 0; j < 100; j++)
+                inner.run([&]() { leaves++; });
+
+            inner.wait();
+        });
+    }
+
+    outer.wait();
+    REQUIRE( leaves == 800 );
+
+    // a group with nothing to wait on returns at once
+    ThreadPool::Group none(pool);
+    none.wait();
+}
+
+TEST_CASE("Waiting without help leaves tasks to the workers",
+          "[threadpool]")
+{
+    ThreadPool pool(1);
+    ThreadPool::Group group(pool);
+    std::atomic<int> onCaller(0);
+    std::thread::id caller = std::this_thread::get_id();
+
+    for(int i = 0; i < 200; i++)
+    {
+        group.run([&]()
+        {
+            if(std::this_thread::get_id() == caller)
+                onCaller++;
+        });
+    }
+
+    group.wait(false);
+    REQUIRE( onCaller == 0 );
+}
+
+TEST_CASE("The shared pool starts workers as they are needed",
+          "[threadpool]")
+{
+    ThreadPool& pool = ThreadPool::shared();
+    pool.reserve(2);
+    REQUIRE( pool.size() >= 2 );
+
+    std::atomic<long long> sum(0);
+    pool.parallelFor(1, 1001, 10, [&](size_t start, size_t end)
+    {
+        for(size_t i = start; i < end; i++)
+            sum += i;
+    });
+
+    REQUIRE( sum == 500500 );
+}
+
+TEST_CASE("Node pools are kept for the whole program", "[threadpool]")
+{
+    std::vector<int> cpus(1, 0);
+    ThreadPool& pool = ThreadPool::forNode(0, cpus);
+    pool.reserve(1);
+
+    REQUIRE( &ThreadPool::forNode(0, cpus) == &pool );
+    REQUIRE( &pool != &ThreadPool::shared() );
+    REQUIRE( pool.size() >= 1 );
+}
+
+/**
+ * A posted task that counts itself run
+ */
+struct CountingTask : ThreadPool::Task
+{
+    std::atomic<int>* runs;
+
+    static void count(ThreadPool::Task* t)
+    {
+        static_cast<CountingTask*>(t)->runs->fetch_add(1);
+    }
+};
+
+TEST_CASE("Posted tasks run from the caller's memory", "[threadpool]")
+{
+    // a pool without workers gets one for posted tasks
+    ThreadPool pool;
+    std::atomic<int> runs(0);
+    std::vector<CountingTask> tasks(100);
+
+    for(CountingTask& t: tasks)
+    {
+        t.call = &CountingTask::count;
+        t.runs = &runs;
+        pool.post(&t);
+    }
+
+    while(runs.load() < 100)
+        std::this_thread::yield();
+
+    REQUIRE(pool.size() == 1);
+    REQUIRE(runs.load() == 100);
+}
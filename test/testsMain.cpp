@@ -1,4 +1,5 @@
 #define CATCH_CONFIG_MAIN
+#define CATCH_CONFIG_NO_POSIX_SIGNALS  // SIGSTKSZ is no longer constant in glibc
 #include "catch.hpp"
 
 